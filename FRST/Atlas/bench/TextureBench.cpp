@@ -0,0 +1,192 @@
+/*
+ * Compares the texture kernels of each SIMD level against the scalar ones, in MB/s of RGBA8 input.
+ *
+ * Every kernel is run on one image, at each level this CPU supports and then at the best level on a WorkerPool.
+ * Results are also checked against the scalar ones, as every level has to cook textures bit for bit the same.
+ *
+ * Usage: Atlas_texture_bench [--size N] [--workers N] [image.png]
+ * Without an image, a generated N x N one (1024 by default) with gradients, noise and cutout alpha is used.
+ */
+
+#include "Atlas/Png.hpp"
+#include "Atlas/TextureKernels.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace FRST::Atlas;
+using namespace FRST::WorkForce;
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	// Keep the optimizer from throwing the work away
+	volatile uint64_t s_sink;
+
+	Image generateImage(uint32_t size) {
+		Image image;
+		image.width = size;
+		image.height = size;
+		image.pixels.resize(size_t(size) * size * 4);
+		uint32_t random = 12345;
+		for (uint32_t y = 0; y < size; y++) {
+			for (uint32_t x = 0; x < size; x++) {
+				random = random * 1664525 + 1013904223;
+				int noise = static_cast<int>(random >> 28) - 8;
+				uint8_t* pixel = image.pixel(x, y);
+				pixel[0] = static_cast<uint8_t>(std::clamp(static_cast<int>(x * 255 / size) + noise, 0, 255));
+				pixel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(y * 255 / size) + noise, 0, 255));
+				pixel[2] = static_cast<uint8_t>(std::clamp(static_cast<int>(128 + 100 * std::sin(x * 0.05) * std::cos(y * 0.03)) + noise, 0, 255));
+				// Leaves: blobs of opaque on transparent, with a soft edge
+				float leaf = std::sin(x * 0.11f) * std::sin(y * 0.13f) + std::sin((x + y) * 0.021f) * 0.5f;
+				pixel[3] = static_cast<uint8_t>(std::clamp(static_cast<int>((leaf - 0.2f) * 2000.0f), 0, 255));
+			}
+		}
+		return image;
+	}
+
+	Image loadImage(const std::string& path) {
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream) {
+			throw std::runtime_error("cannot read " + path);
+		}
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		return decodePng(data);
+	}
+
+	struct Kernel {
+		const char* name;
+		// Runs the kernel once, returning its output for comparing levels
+		std::function<std::vector<uint8_t>(SimdLevel level, WorkerPool* pool, double& seconds)> run;
+	};
+
+	// Best of several runs, in MB/s of the source image
+	double measure(const Kernel& kernel, SimdLevel level, WorkerPool* pool, size_t bytes, std::vector<uint8_t>& output) {
+		double best = 1e30;
+		double total = 0.0;
+		for (int run = 0; run < 20 && (run < 3 || total < 0.5); run++) {
+			double seconds = 0.0;
+			output = kernel.run(level, pool, seconds);
+			s_sink = s_sink + output.size();
+			best = std::min(best, seconds);
+			total += seconds;
+		}
+		return bytes / best / 1e6;
+	}
+
+	double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t size = 1024;
+	size_t workers = 0;
+	std::string imagePath;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			size = static_cast<uint32_t>(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+			workers = static_cast<size_t>(std::atoi(argv[++i]));
+		} else if (argv[i][0] != '-') {
+			imagePath = argv[i];
+		} else {
+			std::fprintf(stderr, "usage: Atlas_texture_bench [--size N] [--workers N] [image.png]\n");
+			return 2;
+		}
+	}
+
+	try {
+		Image image = imagePath.empty() ? generateImage(size) : loadImage(imagePath);
+		size_t bytes = image.pixels.size();
+		LinearImage linear = toLinear(image, true);
+		// The mip below the top, as scaleAlphaToCoverage() would get it
+		Image mip = fromLinear(downsample(linear), true);
+		float coverage = alphaCoverage(image, 128);
+
+		std::vector<Kernel> kernels = {
+			{ "mip chain", [&](SimdLevel level, WorkerPool* pool, double& seconds) {
+				Clock::time_point start = Clock::now();
+				LinearImage current = downsample(linear, pool, level);
+				std::vector<uint8_t> output(reinterpret_cast<const uint8_t*>(current.texels.data()),
+					reinterpret_cast<const uint8_t*>(current.texels.data() + current.texels.size()));
+				while (current.width > 1 || current.height > 1) {
+					current = downsample(current, pool, level);
+				}
+				seconds = secondsSince(start);
+				return output;
+			} },
+			{ "coverage", [&](SimdLevel level, WorkerPool*, double& seconds) {
+				Image scaled = mip;
+				Clock::time_point start = Clock::now();
+				scaleAlphaToCoverage(scaled, coverage, 128, level);
+				seconds = secondsSince(start);
+				return scaled.pixels;
+			} },
+		};
+		const std::pair<const char*, TextureFormat> formats[] = {
+			{ "BC1", TextureFormat::BC1 }, { "BC3", TextureFormat::BC3 }, { "BC4", TextureFormat::BC4 },
+			{ "BC5", TextureFormat::BC5 }, { "BC7", TextureFormat::BC7 }
+		};
+		for (const auto& [name, format] : formats) {
+			kernels.push_back({ name, [&, format](SimdLevel level, WorkerPool* pool, double& seconds) {
+				Clock::time_point start = Clock::now();
+				std::vector<uint8_t> output = compressBlocks(image, format, pool, level);
+				seconds = secondsSince(start);
+				return output;
+			} });
+		}
+
+		WorkerPoolConfig config;
+		config.numWorkers = workers;
+		WorkerPool pool(config);
+
+		std::printf("%ux%u, %zu workers\n", image.width, image.height, pool.numWorkers());
+		std::printf("%-10s %12s %12s %12s %8s %12s\n", "kernel", "scalar", "SSE4.1", "AVX2", "speedup", "parallel");
+		bool mismatch = false;
+		for (const Kernel& kernel : kernels) {
+			std::vector<uint8_t> scalarOutput;
+			double scalar = measure(kernel, SimdLevel::Scalar, nullptr, bytes, scalarOutput);
+			std::printf("%-10s %7.1f MB/s", kernel.name, scalar);
+			double fastest = scalar;
+			for (SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2 }) {
+				if (!isSimdLevelSupported(level)) {
+					std::printf(" %12s", "-");
+					continue;
+				}
+				std::vector<uint8_t> output;
+				double speed = measure(kernel, level, nullptr, bytes, output);
+				if (output != scalarOutput) {
+					std::fprintf(stderr, "%s: %s differs from scalar\n", kernel.name, simdLevelName(level));
+					mismatch = true;
+				}
+				fastest = std::max(fastest, speed);
+				std::printf(" %7.1f MB/s", speed);
+			}
+			std::vector<uint8_t> output;
+			double parallel = measure(kernel, bestSimdLevel(), &pool, bytes, output);
+			if (output != scalarOutput) {
+				std::fprintf(stderr, "%s: parallel differs from scalar\n", kernel.name);
+				mismatch = true;
+			}
+			std::printf(" %7.2fx %7.1f MB/s\n", fastest / scalar, parallel);
+		}
+		return mismatch ? 1 : 0;
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
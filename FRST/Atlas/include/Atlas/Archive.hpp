@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "Atlas/AssetUUID.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		/*
+		 * The on-disk layout of a packed asset archive. Everything is little endian, as written by ArchiveWriter.
+		 *
+		 *   ArchiveHeader
+		 *   ArchiveEntry[slotCount]   an open addressing hash table keyed by AssetUUID
+		 *   path strings              the original path of each entry, not null terminated
+		 *   (padding to ALIGNMENT)
+		 *   blobs                     each one starting on an ALIGNMENT boundary
+		 *
+		 * The header, index and paths sit together at the front, so finding assets only touches those pages.
+		 *
+		 * A compressed blob is split into blockSize byte blocks (the last one shorter), each compressed on its own,
+		 * so that one large asset can be decompressed on many workers at once:
+		 *   uint64[block count]       where each block's stored bytes end, from the end of this table
+		 *   the blocks                each stored raw instead if compressing did not make it smaller
+		 */
+		struct ArchiveHeader {
+			static constexpr char MAGIC[8] = { 'F', 'R', 'S', 'T', 'P', 'A', 'K', '\0' };
+			// Also bumped whenever AssetUUID's hash changes
+			static constexpr uint32_t VERSION = 3;
+			// Blobs are page aligned, so that each can be mapped, prefetched and evicted on its own
+			static constexpr uint32_t ALIGNMENT = 4096;
+
+			char magic[8];
+			uint32_t version;
+			uint32_t alignment;
+			// The decompressed size of every block of a compressed blob, but the last
+			uint32_t blockSize;
+			uint32_t reserved;
+			uint64_t entryCount;
+			// A power of two, at least twice entryCount
+			uint64_t slotCount;
+			uint64_t indexOffset;
+			uint64_t pathsOffset;
+			uint64_t fileSize;
+		};
+
+		enum class ArchiveCompression : uint32_t {
+			None,
+			// The LZ4 block format, see Lz4.hpp
+			LZ4
+		};
+
+		struct ArchiveEntry {
+			uint64_t uuid;
+			// From the start of the file. 0 marks an empty slot, since no blob can share the header's page.
+			uint64_t offset;
+			// The asset's size, once decompressed
+			uint64_t size;
+			// What the blob takes up in the file, which is size unless it is compressed
+			uint64_t storedSize;
+			// From ArchiveHeader::pathsOffset
+			uint32_t pathOffset;
+			uint32_t pathLength;
+			ArchiveCompression compression;
+			uint32_t reserved;
+
+			bool empty() const { return offset == 0; }
+			bool compressed() const { return compression != ArchiveCompression::None; }
+		};
+
+		class Archive {
+		public:
+			/*
+			 * A packed archive, mapped read only into memory.
+			 *
+			 * Looking an asset up is a hash and usually a single probe of the index. Uncompressed bytes are used straight
+			 * from the mapping, so nothing is copied and no file is opened per asset. Compressed ones are decompressed
+			 * from the mapping straight into wherever they are needed, a block at a time. The kernel reads pages in
+			 * on first touch, or ahead of time through willNeed().
+			 *
+			 * Throws std::runtime_error if the file cannot be mapped or is not a valid archive.
+			 */
+			explicit Archive(const std::string& path);
+			~Archive();
+
+			Archive(const Archive&) = delete;
+			Archive& operator=(const Archive&) = delete;
+
+			const std::string& path() const { return m_path; }
+			size_t size() const { return static_cast<size_t>(m_header->entryCount); }
+
+			// Returns nullptr if the archive does not contain the asset
+			const ArchiveEntry* find(AssetUUID uuid) const;
+
+			// The bytes of an uncompressed entry. Throws std::logic_error for a compressed one.
+			std::span<const uint8_t> data(const ArchiveEntry& entry) const;
+			std::string_view assetPath(const ArchiveEntry& entry) const;
+
+			// How many blocks a compressed entry is split into, each decompressed by decompressBlock()
+			size_t blockCount(const ArchiveEntry& entry) const;
+			uint32_t blockSize() const { return m_header->blockSize; }
+			/*
+			 * Decompress one block of an entry into its place in destination, which is entry.size bytes for the
+			 * whole asset. Blocks are independent, so any number may be decompressed at once.
+			 * Returns false if the block is corrupt.
+			 */
+			bool decompressBlock(const ArchiveEntry& entry, size_t block, std::span<uint8_t> destination) const;
+			// Copy or decompress a whole entry into destination, entry.size bytes, on this thread. False if corrupt.
+			bool read(const ArchiveEntry& entry, std::span<uint8_t> destination) const;
+
+			// Ask the kernel to start reading an entry's stored pages in, without waiting for them
+			void willNeed(const ArchiveEntry& entry) const;
+			// Let the kernel drop an entry's pages. They are read back from the file if touched again.
+			void dontNeed(const ArchiveEntry& entry) const;
+
+			// Every slot of the index, including empty ones, eg. to list the contents
+			std::span<const ArchiveEntry> slots() const { return { m_slots, static_cast<size_t>(m_header->slotCount) }; }
+
+		private:
+			const std::string m_path;
+			const uint8_t* m_mapping;
+			size_t m_mappingSize;
+			const ArchiveHeader* m_header;
+			const ArchiveEntry* m_slots;
+			const char* m_paths;
+		};
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Atlas/Archive.hpp"
+#include "Atlas/AssetUUID.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		class ArchiveWriter {
+		public:
+			/*
+			 * Builds a packed archive (see Archive.hpp) from assets added in memory.
+			 * Blobs are written in the order they were added, so related assets added together stay close on disk.
+			 *
+			 * Assets are compressed in blockSize blocks, unless that saves too little to be worth decompressing,
+			 * in which case they are stored as they are and can be used straight from the mapping.
+			 */
+			explicit ArchiveWriter(ArchiveCompression compression = ArchiveCompression::LZ4, uint32_t blockSize = DEFAULT_BLOCK_SIZE);
+
+			// The same as LZ4's window, so that splitting into blocks costs little ratio.
+			// Each block is one piece of work when decompressing, so smaller blocks spread large assets further.
+			static constexpr uint32_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+			/*
+			 * Add an asset under the path it would be loaded by, relative to the Data folder.
+			 * Throws std::logic_error if the path has already been added, or hashes to the same AssetUUID as another.
+			 */
+			void add(const std::string& path, std::vector<uint8_t> data);
+
+			size_t size() const { return m_assets.size(); }
+
+			/*
+			 * Compress every asset, on pool if given, and write the archive.
+			 * Throws std::runtime_error if the file cannot be written.
+			 */
+			void write(const std::string& archivePath, WorkForce::WorkerPool* pool = nullptr);
+
+			// Uncompressed and stored sizes of everything added, once written
+			uint64_t totalSize() const;
+			uint64_t totalStoredSize() const;
+
+		private:
+			struct PendingAsset {
+				std::string path;
+				AssetUUID uuid;
+				std::vector<uint8_t> data;
+				// Filled in by compress(), empty if the data is stored as it is
+				std::vector<uint8_t> compressed;
+			};
+
+			// Compress one asset, keeping the result only if it is enough smaller
+			void compress(PendingAsset& asset) const;
+			// What goes into the file for an asset
+			static const std::vector<uint8_t>& stored(const PendingAsset& asset) {
+				return asset.compressed.empty() ? asset.data : asset.compressed;
+			}
+
+			const ArchiveCompression m_compression;
+			const uint32_t m_blockSize;
+			std::vector<PendingAsset> m_assets;
+			// Index into m_assets of each AssetUUID, to catch collisions
+			std::unordered_map<AssetUUID, size_t> m_uuids;
+		};
+	}
+}
@@ -1,17 +1,95 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <vector>
 
-#include "FRST/Atlas/AssetUUID.hpp"
+#include "Atlas/AssetHandle.hpp"
+#include "Atlas/AssetUUID.hpp"
+#include "Atlas/AsyncIO.hpp"
+#include "Atlas/Residency.hpp"
+#include "WorkForce/AsyncEvent.hpp"
 
 
 namespace FRST {
 	namespace Atlas {
+		class Archive;
+		struct ArchiveEntry;
+		class AssetManager;
+
 		class Asset {
 		public:
+			/*
+			 * The raw bytes of one file in the Data folder.
+			 * An Asset is created by the AssetManager as soon as it is requested. Loose files are filled in by an
+			 * asynchronous read. Assets in a mounted Archive are loaded straight away, and their data points into the
+			 * archive's mapping rather than being copied, unless it is compressed and has to be decompressed first.
+			 * Until loaded() is set, only path() and uuid() may be read.
+			 *
+			 * Assets that have not been used for a while may be evicted to stay within the AssetManager's budgets,
+			 * see AssetManager::use(). References to an asset must not be kept across frames without using it.
+			 */
+			Asset(const std::string& path, AssetUUID uuid, AssetClass assetClass, WorkForce::WorkerPool& pool);
+
+			Asset(const Asset&) = delete;
+			Asset& operator=(const Asset&) = delete;
+
+			const std::string& path() const { return m_path; }
+			AssetUUID uuid() const { return m_uuid; }
+			// The handle to look this asset up again by, through AssetManager::get()
+			AssetHandle<Asset> handle() const { return m_handle; }
+			AssetClass assetClass() const { return m_class; }
+
+			// Set once loading has finished, successfully or not. Tasks can co_await it.
+			WorkForce::AsyncEvent& loaded() { return m_loaded; }
+			bool isLoaded() const { return m_loaded.isSet(); }
+
+			// Only valid once loaded() is set. A cancelled asset has also failed.
+			bool failed() const { return m_failed; }
+			bool cancelled() const { return m_cancelled; }
+			std::span<const uint8_t> data() const { return m_view; }
+
 		private:
+			friend class AssetManager;
+
+			// Runs on a worker once the read has finished
+			struct ReadCompletion : public WorkForce::WorkItem {
+				Asset* asset;
+				AssetManager* manager;
+			};
+			static void finishRead(WorkForce::WorkItem* item, WorkForce::Worker& worker);
+
 			std::string m_path;
 			AssetUUID m_uuid;
+			AssetHandle<Asset> m_handle;
+			AssetClass m_class;
+			// The bytes of a loose file or a compressed archived asset. Other archived assets leave this empty.
+			std::vector<uint8_t> m_data;
+			std::span<const uint8_t> m_view;
+			bool m_failed;
+			bool m_cancelled;
+			WorkForce::AsyncEvent m_loaded;
+
+			// Where an archived asset's data comes from, or nullptr for a loose file
+			const Archive* m_archive;
+			const ArchiveEntry* m_archiveEntry;
+
+			// Residency. The last frame the asset was used in, and how far from the camera it was used.
+			std::atomic<uint64_t> m_lastUse;
+			std::atomic<float> m_distance;
+			// What this asset counts against its class's budgets, and the AssetManager's counter of CPU bytes
+			// for the class, which a failed read gives its bytes back to. Guarded by the AssetManager's mutex
+			// once the asset is loaded.
+			uint64_t m_residentSize;
+			uint64_t m_stagingSize;
+			std::atomic<uint64_t>* m_residentCounter;
+
+			// The file being read, and the read itself
+			int m_fd;
+			IORequest m_request;
+			ReadCompletion m_readCompletion;
 		};
 	}
-}
\ No newline at end of file
+}
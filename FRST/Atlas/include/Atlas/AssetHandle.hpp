@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace FRST {
+	namespace Atlas {
+		template<class T>
+		struct AssetHandle {
+			/*
+			 * A reference to an object in a HandleTable, such as an Asset in the AssetManager.
+			 *
+			 * index picks the table slot, and generation is the slot's generation when the object was put there.
+			 * Removing the object bumps the slot's generation, so old handles to it resolve to nullptr instead of
+			 * to whatever reuses the slot. Generations start at 1, so a default constructed handle is never valid.
+			 *
+			 * T only keeps handles to different kinds of object from being mixed up.
+			 */
+			uint32_t index = 0;
+			uint32_t generation = 0;
+
+			bool isNull() const { return generation == 0; }
+
+			bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+			bool operator!=(const AssetHandle& other) const { return !(*this == other); }
+		};
+	}
+}
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <WorkForce/Job.hpp>
 #include "Atlas/AssetUpdateJob.hpp"
 
 
@@ -15,4 +14,4 @@ namespace FRST {
 			virtual ~AssetLoadJob();
 		};
 	}
-}
\ No newline at end of file
+}
@@ -1,15 +1,65 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
-#include "FRST/Atlas/Asset.hpp"
-#include "FRST/Atlas/AssetUUID.hpp"
+#include "Atlas/Archive.hpp"
+#include "Atlas/Asset.hpp"
+#include "Atlas/AssetHandle.hpp"
+#include "Atlas/AssetUUID.hpp"
+#include "Atlas/AssetWatcher.hpp"
+#include "Atlas/AsyncIO.hpp"
+#include "Atlas/Cooker.hpp"
+#include "Atlas/HandleTable.hpp"
+#include "Atlas/Residency.hpp"
+#include "WorkForce/AsyncEvent.hpp"
+#include "WorkForce/FrameListener.hpp"
+#include "WorkForce/Task.hpp"
+#include "WorkForce/WorkerPool.hpp"
 
 
 namespace FRST {
 	namespace Atlas {
-		class AssetManager {
+		// co_await AssetManager::load() to suspend a Task until the asset has been read
+		class AssetLoad {
+		public:
+			explicit AssetLoad(Asset& asset)
+				: m_asset(asset)
+				, m_awaiter(asset.loaded()) {}
+
+			bool await_ready() const noexcept { return m_awaiter.await_ready(); }
+			bool await_suspend(std::coroutine_handle<> handle) noexcept { return m_awaiter.await_suspend(handle); }
+			const Asset& await_resume() noexcept { return m_asset; }
+
+		private:
+			Asset& m_asset;
+			WorkForce::AsyncEvent::Awaiter m_awaiter;
+		};
+
+		// How well archived assets decompressed, for each AssetClass, since the AssetManager was created
+		struct DecompressionStats {
+			uint64_t assets[ASSET_CLASS_COUNT];
+			// Read from the archive, and written out. Their ratio is the compression ratio.
+			uint64_t compressedBytes[ASSET_CLASS_COUNT];
+			uint64_t decompressedBytes[ASSET_CLASS_COUNT];
+			// From starting each asset to its last block finishing, summed over assets.
+			// decompressedBytes over this is the throughput of one asset spread over the workers.
+			uint64_t nanoseconds[ASSET_CLASS_COUNT];
+		};
+
+		class AssetManager : private WorkForce::FrameListener {
+			// Read completions count themselves off through finishTask()
+			friend class Asset;
+
 			/*
 			 * The AssetManager is a framework for managing access/loading/processing of backing raw assets
 			 * such as meshs, textures, shaders, etc.
@@ -18,12 +68,211 @@ namespace FRST {
 			 * "Data/textures/tree/alpha.png" would be "textures/tree/alpha.png".
 			 * After loaded, an asset will be given a UUID to be used as a faster reference method. Generally this
 			 * will be a hashed value of the string suitable for use in a hashtable, for quick lookup reasons.
+			 * Code that uses an asset repeatedly should keep its AssetHandle instead, which get() resolves without
+			 * hashing or locking, and which safely stops resolving once the asset is gone.
+			 *
+			 * Files are read through AsyncIO, never on a worker. A Task that needs an asset co_awaits
+			 * load(), which frees its worker until the read has finished.
+			 *
+			 * Shipping builds cook the Data folder with FRST_cook, which converts every source into the form the
+			 * runtime uses (see CookedFormats.hpp) under the same path, and pack the result into Archives to mount.
+			 * Assets found in a mounted archive are loaded as soon as they are requested, with their data mapped
+			 * rather than read, and only paths missing from every archive fall back to loose files. Compressed ones
+			 * are decompressed from the mapping, their blocks spread over the workers, while their load is awaited.
+			 *
+			 * Memory is kept within per-class budgets (see ResidencyConfig) by evicting the assets that have gone
+			 * unused for longest, or were last used furthest from the camera, a few each frame.
+			 *
+			 * Development builds can watch the source Data folder instead, and recook assets in the background as
+			 * their sources are saved. See enableHotReload().
 			 */
 		public:
+			AssetManager(WorkForce::WorkerPool& pool, const std::string& dataDirectory = "Data/",
+				const AsyncIOConfig& ioConfig = AsyncIOConfig(), const ResidencyConfig& residencyConfig = ResidencyConfig());
+			// Must be destroyed on the thread that starts frames if hot reload was enabled
+			~AssetManager();
+
+			AssetManager(const AssetManager&) = delete;
+			AssetManager& operator=(const AssetManager&) = delete;
+
+			/*
+			 * Look assets up in an archive from now on, ahead of loose files and of archives mounted before it.
+			 * Assets that were already requested keep their data. Throws std::runtime_error if it cannot be mapped,
+			 * and std::logic_error if any of its assets has the same AssetUUID as a different path already known.
+			 */
+			void mountArchive(const std::string& archivePath);
+
+			/*
+			 * Start loading the asset at path, unless it was already requested, and return something to co_await it with.
+			 * priority orders the read against other queued reads. Safe to call from any thread.
+			 * Throws std::logic_error if the path's AssetUUID collides with a different asset's.
+			 */
+			AssetLoad load(const std::string& path, WorkForce::Priority priority = WorkForce::Priority::Normal);
+
+			/*
+			 * Start loading several assets, handing their reads to the I/O system as one batch.
+			 * Archived assets have their pages read ahead.
+			 */
+			void prefetch(const std::vector<std::string>& paths, WorkForce::Priority priority = WorkForce::Priority::Normal);
+
+			/*
+			 * Stop loading an asset that is no longer needed. If its read has not finished it completes as cancelled,
+			 * and stays failed until it is unloaded. Returns false if it was not loading.
+			 */
+			bool cancel(const std::string& path);
+
+			/*
+			 * An asset that was requested, or any asset in a mounted archive, which is then loaded without copying.
+			 * Throws std::out_of_range if it is neither.
+			 */
 			const Asset& getAsset(AssetUUID uuid);
+
+			// The same as getAsset(), but returns the asset's handle. Resolve UUIDs once, and keep the handle.
+			AssetHandle<Asset> getHandle(AssetUUID uuid);
+
+			// Any thread, without locking. Returns nullptr if the asset has been removed since the handle was taken.
+			const Asset* get(AssetHandle<Asset> handle) const { return m_assets.get(handle); }
+
+			/*
+			 * Mark an asset as used this frame, at a distance from the camera (0 for assets that are not placed in
+			 * the world). The assets used least recently, and then furthest away, are evicted first.
+			 * Any thread, without locking. Requesting an asset through load() or getHandle() also counts as a use.
+			 */
+			void use(AssetHandle<Asset> handle, float distance = 0.0f);
+
+			// Report memory held for an asset outside of its data, eg. a GPU staging copy, against the staging budget
+			void setStagingSize(AssetHandle<Asset> handle, uint64_t bytes);
+
+			/*
+			 * Called for each asset as it is evicted, so that anything built from it (eg. a staging copy) can be freed.
+			 * Runs on the thread that evicted it, without the AssetManager locked. The asset stays readable until
+			 * no frame can be using it any more.
+			 */
+			void setEvictionCallback(std::function<void(const Asset&)> callback);
+
+			// Change a class's budgets, zero meaning no limit. Going over a budget is corrected over the next frames.
+			void setBudget(AssetClass assetClass, uint64_t cpuBytes, uint64_t stagingBytes);
+
+			/*
+			 * Evict the coldest assets of each class that is over budget, up to the per-frame limits, and destroy
+			 * assets that were evicted long enough ago that no frame can still be using them.
+			 * Call once per frame with the frame's number, normally through AssetResidencyJob. Not reentrant.
+			 */
+			void updateResidency(uint64_t frame);
+
+			// Evict an asset straight away, eg. to retry a failed load. Returns false if it is stale or still loading.
+			bool unload(AssetHandle<Asset> handle);
+
+			ResidencyStats residencyStats();
+
+			/*
+			 * Copy or decompress an archived asset straight into destination, eg. a mapped staging buffer, without it
+			 * becoming resident. Compressed blocks are decompressed on many workers at once. co_await it from a Task.
+			 * Returns false if no mounted archive has the asset. Throws std::logic_error if destination is not
+			 * archivedSize() bytes, and std::runtime_error if the asset is corrupt.
+			 */
+			WorkForce::Task<bool> readInto(const std::string& path, std::span<uint8_t> destination);
+			// The size of an archived asset once decompressed. Returns false if no mounted archive has it.
+			bool archivedSize(const std::string& path, uint64_t& size);
+
+			DecompressionStats decompressionStats() const;
+
+			/*
+			 * Watch the cooker's source folder and recook every loaded asset whose source, or anything it was cooked
+			 * from (see Cooker::dependents()), is saved. Recooking runs as Background work on the pool. The new
+			 * version replaces the old one behind the same handle when the next frame begins, so no frame sees
+			 * the change part way through. Frames already in flight may still hold the old version, which is kept
+			 * alive like an evicted asset. A source that fails to cook keeps the old version, and is reported on stderr.
+			 *
+			 * Must be called from the thread that starts frames. The cooker must outlive the AssetManager.
+			 * Returns false if hot reload was compiled out (see FRST_HOT_RELOAD), and throws std::runtime_error if the
+			 * folder cannot be watched.
+			 */
+			bool enableHotReload(const Cooker& cooker);
+
+			/*
+			 * Called for each asset replaced by a reload, on the thread starting frames, eg. to upload it again.
+			 * The old version goes to the eviction callback first.
+			 */
+			void setReloadCallback(std::function<void(const Asset&)> callback);
+
 		private:
-			std::unordered_map<std::string, AssetUUID> pathUUIDMap;
-			std::unordered_map<AssetUUID, Asset*, DontHash> assetMap;
+			// Find or create the asset. Sets isNew if it was created, and so needs starting.
+			Asset& findOrCreate(const std::string& path, bool& isNew);
+			// Create an asset, already loaded if an archive has it. m_assetMutex must be held.
+			// Throws std::logic_error if another path already has the AssetUUID.
+			Asset& create(const std::string& path, AssetUUID uuid);
+			// Find the most recently mounted archive holding an asset. m_assetMutex must be held.
+			const Archive* findArchived(AssetUUID uuid, const ArchiveEntry*& entry) const;
+			// Drop an asset from every lookup and budget, to be destroyed later. m_assetMutex must be held.
+			void evict(Asset& asset);
+			// Open the file and fill in the asset's read. Returns false (with the asset finished) if it cannot be read.
+			bool prepareRead(Asset& asset, WorkForce::Priority priority);
+			// Decompress a compressed archived asset into its own data, and finish loading it
+			WorkForce::Task<void> inflate(Asset& asset);
+			// Decompress every block of an entry into destination on the pool, and count it. False if it is corrupt.
+			WorkForce::Task<bool> decompress(const Archive& archive, const ArchiveEntry& entry, std::span<uint8_t> destination,
+				AssetClass assetClass);
+			// Track tasks spawned on the pool that use the AssetManager, and reads whose completion is still to run,
+			// which the destructor waits for
+			void beginTasks(size_t count);
+			void finishTask();
+
+			// Hot reload. Called on the watcher's thread with the source files that changed.
+			void sourcesChanged(const std::vector<std::string>& sources);
+			// Recook an asset and queue it to replace the loaded one, unless a newer request for it comes first
+			WorkForce::Task<void> reload(std::string path, uint64_t request);
+			// Swap reloaded assets in, before any work of the frame starts
+			void onBeginFrame(uint64_t frame) override;
+
+			WorkForce::WorkerPool& m_pool;
+			const std::string m_dataDirectory;
+
+			std::mutex m_assetMutex;
+			// In the order they were mounted. Declared before the assets, whose data may point into them.
+			std::vector<std::unique_ptr<Archive>> m_archives;
+			// Only used to resolve handles, assets themselves live in m_assets
+			std::unordered_map<std::string, AssetHandle<Asset>> m_pathHandleMap;
+			std::unordered_map<AssetUUID, AssetHandle<Asset>> m_uuidHandleMap;
+			HandleTable<Asset> m_assets;
+			// Evicted assets and the frame they were evicted in, oldest first, until no frame can be using them
+			std::deque<std::pair<uint64_t, std::unique_ptr<Asset>>> m_retired;
+
+			// Residency. The config and callback are guarded by m_assetMutex.
+			ResidencyConfig m_residency;
+			std::function<void(const Asset&)> m_evictionCallback;
+			// The last frame passed to updateResidency()
+			std::atomic<uint64_t> m_frame;
+			std::atomic<uint64_t> m_cpuBytes[ASSET_CLASS_COUNT];
+			std::atomic<uint64_t> m_stagingBytes[ASSET_CLASS_COUNT];
+			std::atomic<uint64_t> m_hits;
+			std::atomic<uint64_t> m_misses;
+			std::atomic<uint64_t> m_evictions;
+			std::atomic<uint64_t> m_evictedBytes;
+
+			std::atomic<uint64_t> m_decompressedAssets[ASSET_CLASS_COUNT];
+			std::atomic<uint64_t> m_compressedBytes[ASSET_CLASS_COUNT];
+			std::atomic<uint64_t> m_decompressedBytes[ASSET_CLASS_COUNT];
+			std::atomic<uint64_t> m_decompressionNanoseconds[ASSET_CLASS_COUNT];
+
+			// Hot reload. Requests and reloaded assets are guarded by m_assetMutex.
+			const Cooker* m_cooker;
+			std::function<void(const Asset&)> m_reloadCallback;
+			// The latest request for each path being recooked, so that an older cook finishing late is dropped
+			std::unordered_map<std::string, uint64_t> m_reloadRequests;
+			uint64_t m_nextReloadRequest;
+			// Cooked and waiting for the next frame
+			std::vector<std::unique_ptr<Asset>> m_reloaded;
+
+			// Reads, decompressions and recooks still running
+			std::mutex m_taskMutex;
+			std::condition_variable m_taskCondition;
+			size_t m_tasksRunning;
+			// Declared after everything it reports changes to
+			std::unique_ptr<AssetWatcher> m_watcher;
+
+			// Reset first thing in the destructor, which then waits for the completions of the reads it cancelled or drained
+			std::unique_ptr<AsyncIO> m_io;
 		};
 	}
-}
\ No newline at end of file
+}
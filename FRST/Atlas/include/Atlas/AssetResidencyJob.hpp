@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Atlas/AssetUpdateJob.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		class AssetResidencyJob : public AssetUpdateJob {
+			/*
+			 * Keeps the AssetManager within its residency budgets, by calling updateResidency() once per frame.
+			 * It runs in the background, so eviction only uses time that frames leave idle.
+			 */
+		public:
+			AssetResidencyJob(AssetManager& assetManager);
+			virtual ~AssetResidencyJob();
+
+			WorkForce::Task<void> executeAsync(WorkForce::JobContext& context) override;
+			WorkForce::Priority priority() const override { return WorkForce::Priority::Background; }
+			const char* name() const override { return "Asset residency"; }
+		};
+	}
+}
@@ -1,18 +1,40 @@
 #pragma once
 
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Atlas/ContentHash.hpp"
 
 
 namespace FRST {
 	namespace Atlas {
 		// We want to expose this type for other files, but without forcing them to import AssetManager.hpp.
 		struct AssetUUID {
-			std::size_t uuid;
+			/*
+			 * A 64 bit hash of an asset's path within the Data folder.
+			 *
+			 * The hash is ContentHash, FNV-1a followed by a 64 bit finalizer, which spreads FNV's weak low bits so that
+			 * the value can index hash tables directly. It only depends on the bytes of the path, so UUIDs are the same
+			 * for every run, compiler and platform, and can be stored in archives and caches.
+			 * Changing it invalidates everything that has been stored, so bump ArchiveHeader::VERSION if it changes.
+			 */
+			uint64_t uuid;
 
-			inline AssetUUID CreateAssetUUID(const std::string& path) {
-				return AssetUUID(std::hash<std::string>()(path));
+			static constexpr AssetUUID CreateAssetUUID(std::string_view path) {
+				return AssetUUID{ ContentHash().add(path).finish() };
 			}
+
+			constexpr bool operator==(const AssetUUID& other) const { return uuid == other.uuid; }
+			constexpr bool operator!=(const AssetUUID& other) const { return uuid != other.uuid; }
 		};
+
+		inline namespace AssetLiterals {
+			// "textures/tree/alpha.png"_asset is hashed at compile time
+			constexpr AssetUUID operator""_asset(const char* path, std::size_t length) {
+				return AssetUUID::CreateAssetUUID(std::string_view(path, length));
+			}
+		}
 	}
 }
 
@@ -23,7 +45,7 @@ namespace std {
 	struct hash<FRST::Atlas::AssetUUID> {
 		size_t operator()(const FRST::Atlas::AssetUUID& uuid) const {
 			// AssetUUID's are already hashed
-			return uuid.uuid;
+			return static_cast<size_t>(uuid.uuid);
 		}
 	};
-}
\ No newline at end of file
+}
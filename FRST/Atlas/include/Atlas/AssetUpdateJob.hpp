@@ -1,14 +1,15 @@
 #pragma once
 
-#include <WorkForce/Job.hpp>
+#include "WorkForce/AsyncJob.hpp"
 #include "Atlas/AssetManager.hpp"
 
 
 namespace FRST {
 	namespace Atlas {
-		class AssetUpdateJob : public WorkForce::Job {
+		class AssetUpdateJob : public WorkForce::AsyncJob {
 			/*
 			 * A task to update an asset in some way.
+			 * Asset jobs are coroutines, so they can co_await AssetManager::load() without blocking a worker on disk.
 			 */
 		public:
 			AssetUpdateJob(AssetManager& assetManager)
@@ -19,4 +20,4 @@ namespace FRST {
 			AssetManager& m_assetManager;
 		};
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace FRST {
+	namespace Atlas {
+		class AssetWatcher {
+		public:
+			/*
+			 * Watches a directory tree through inotify, on a thread of its own, and reports the files in it that are
+			 * written or moved in, as paths relative to the directory. Directories created or moved in later are watched
+			 * too. Should inotify drop events, every file in the tree is reported.
+			 *
+			 * Changes are held until none have arrived for settleTime and then reported together, so that an editor
+			 * saving through several writes and renames causes one report. onChange runs on the watcher's thread.
+			 *
+			 * Throws std::runtime_error if the directory cannot be watched.
+			 */
+			AssetWatcher(const std::string& directory, std::function<void(const std::vector<std::string>&)> onChange,
+				std::chrono::milliseconds settleTime = std::chrono::milliseconds(100));
+			// Stops the thread, waiting for a report in progress to finish
+			~AssetWatcher();
+
+			AssetWatcher(const AssetWatcher&) = delete;
+			AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+		private:
+			void run();
+			// Watch a directory and everything below it, and add any files already in it to changed
+			void watchTree(const std::string& relative, std::vector<std::string>* changed);
+			// Stop watching a directory and everything below it, or the whole tree for ""
+			void unwatchTree(const std::string& relative);
+
+			const std::string m_directory;
+			const std::function<void(const std::vector<std::string>&)> m_onChange;
+			const std::chrono::milliseconds m_settleTime;
+			int m_inotify;
+			// Written to by the destructor to stop the thread
+			int m_wake;
+			// Watch descriptor to the watched directory, relative to m_directory. Only the thread touches it once started.
+			std::unordered_map<int, std::string> m_watches;
+			std::thread m_thread;
+		};
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkForce/Priority.hpp"
+#include "WorkForce/WorkItem.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		class IoUring;
+
+		struct IORequest {
+			/*
+			 * One read from a file, handed to AsyncIO::submit().
+			 * The request is owned by the caller, and must stay alive and untouched until its completion has run.
+			 */
+			int fd = -1;
+			uint64_t offset = 0;
+			void* buffer = nullptr;
+			uint32_t size = 0;
+			WorkForce::Priority priority = WorkForce::Priority::Normal;
+
+			// Queued on the WorkerPool, with the request's priority, once the read has finished or been cancelled.
+			WorkForce::WorkItem* completion = nullptr;
+
+			// Filled in before the completion is queued. The number of bytes read, or a negative errno.
+			// Cancelled requests get -ECANCELED.
+			int64_t result = 0;
+
+		private:
+			friend class AsyncIO;
+
+			enum class State : uint8_t {
+				Idle,
+				Queued,
+				InFlight,
+				Done
+			};
+			// Guarded by the AsyncIO's mutex
+			State m_state = State::Idle;
+			// Whether an io_uring cancel has been asked for since it was submitted. Also guarded by the mutex.
+			bool m_cancelling = false;
+		};
+
+		struct AsyncIOConfig {
+			// The most reads that are handed to the kernel at once
+			uint32_t queueDepth = 64;
+			// Threads doing blocking preads when io_uring is not available
+			size_t fallbackThreads = 4;
+			// Always use the pread fallback, eg. to compare the two
+			bool disableIoUring = false;
+		};
+
+		class AsyncIO {
+		public:
+			/*
+			 * Asynchronous file reads, completing into the WorkerPool.
+			 *
+			 * On Linux with io_uring, one I/O thread owns the ring. It takes queued requests in priority order,
+			 * batches up to queueDepth of them into a single submission, and sleeps in the kernel until any of them
+			 * complete. Nothing ever blocks on an individual read. Where io_uring is unavailable (old kernels, or
+			 * blocked by a sandbox) a few threads serve the same queues with blocking preads instead.
+			 */
+			AsyncIO(WorkForce::WorkerPool& pool, const AsyncIOConfig& config = AsyncIOConfig());
+			// Cancels anything still queued and waits for reads already in flight
+			~AsyncIO();
+
+			AsyncIO(const AsyncIO&) = delete;
+			AsyncIO& operator=(const AsyncIO&) = delete;
+
+			// Queue reads. Safe to call from any thread. Batches are queued together, with one wakeup.
+			void submit(IORequest* request);
+			void submit(IORequest* const* requests, size_t count);
+
+			/*
+			 * Cancel a request that is no longer needed. Queued requests are always cancelled, and reads already
+			 * handed to io_uring are asked to stop. Returns false if the request had already completed, or is being
+			 * read by the fallback, in which case it completes normally. Either way its completion still runs.
+			 */
+			bool cancel(IORequest* request);
+
+			bool usesIoUring() const { return m_ring != nullptr; }
+
+		private:
+			void runRing();
+			void runFallback();
+			// Takes the highest priority queued request. m_mutex must be held.
+			IORequest* takeQueued();
+			void finish(IORequest* request, int64_t result);
+			void wakeRing();
+
+			WorkForce::WorkerPool& m_pool;
+			const AsyncIOConfig m_config;
+
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			// One queue per Priority
+			std::deque<IORequest*> m_queued[3];
+			// In-flight io_uring reads that should be cancelled
+			std::vector<IORequest*> m_toCancel;
+			size_t m_numInFlight;
+			bool m_stopping;
+			// Whether the ring thread is (about to be) asleep in the kernel, and needs waking for new work
+			bool m_ringWaiting;
+
+			std::unique_ptr<IoUring> m_ring;
+			std::vector<std::thread> m_threads;
+		};
+	}
+}
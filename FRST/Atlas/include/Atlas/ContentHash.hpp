@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+
+namespace FRST {
+	namespace Atlas {
+		class ContentHash {
+		public:
+			/*
+			 * A stable 64 bit hash, built up from any number of pieces: FNV-1a followed by a 64 bit finalizer.
+			 * Used for AssetUUIDs and to key caches on the content of files, so its output must never change
+			 * without invalidating what was stored with it.
+			 */
+			constexpr ContentHash()
+				: m_state(0xcbf29ce484222325ull) {}
+
+			constexpr ContentHash& add(std::string_view text) {
+				for (char c : text) {
+					addByte(static_cast<uint8_t>(c));
+				}
+				return *this;
+			}
+
+			ContentHash& add(std::span<const uint8_t> bytes) {
+				for (uint8_t byte : bytes) {
+					addByte(byte);
+				}
+				return *this;
+			}
+
+			constexpr ContentHash& add(uint64_t value) {
+				for (int i = 0; i < 8; i++) {
+					addByte(static_cast<uint8_t>(value >> (i * 8)));
+				}
+				return *this;
+			}
+
+			constexpr uint64_t finish() const {
+				uint64_t hash = m_state;
+				hash ^= hash >> 33;
+				hash *= 0xff51afd7ed558ccdull;
+				hash ^= hash >> 33;
+				hash *= 0xc4ceb9fe1a85ec53ull;
+				hash ^= hash >> 33;
+				return hash;
+			}
+
+		private:
+			constexpr void addByte(uint8_t byte) {
+				m_state ^= byte;
+				m_state *= 0x100000001b3ull;
+			}
+
+			uint64_t m_state;
+		};
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+namespace FRST {
+	namespace Atlas {
+		/*
+		 * The layouts of cooked assets, as written by FRST_cook and read by the runtime.
+		 * Cooked data is ready to hand to the GPU: the runtime only checks the header and takes views of the rest.
+		 * Everything is little endian, and every section starts 16 byte aligned from the start of the asset.
+		 */
+
+		enum class TextureFormat : uint32_t {
+			RGBA8,
+			// 4x4 blocks of 8 bytes, RGB with optional 1 bit alpha
+			BC1,
+			// 4x4 blocks of 16 bytes, BC1 colour with interpolated alpha
+			BC3,
+			// 4x4 blocks of 8 bytes, one interpolated channel, eg. a mask
+			BC4,
+			// 4x4 blocks of 16 bytes, two BC4 channels, eg. a normal map's X and Y
+			BC5,
+			// 4x4 blocks of 16 bytes, RGBA at much better quality than BC3
+			BC7
+		};
+
+		struct CookedTextureHeader {
+			static constexpr char MAGIC[4] = { 'F', 'T', 'E', 'X' };
+			static constexpr uint32_t VERSION = 1;
+			// The colour channels are sRGB encoded
+			static constexpr uint32_t FLAG_SRGB = 1 << 0;
+
+			char magic[4];
+			uint32_t version;
+			TextureFormat format;
+			uint32_t flags;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipCount;
+			uint32_t reserved;
+			// Followed by mipCount CookedMips, largest first
+		};
+
+		struct CookedMip {
+			// From the start of the asset
+			uint64_t offset;
+			uint64_t size;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		struct MeshVertex {
+			float position[3];
+			float normal[3];
+			float uv[2];
+		};
+
+		struct CookedMeshHeader {
+			static constexpr char MAGIC[4] = { 'F', 'M', 'S', 'H' };
+			static constexpr uint32_t VERSION = 2;
+
+			char magic[4];
+			uint32_t version;
+			uint32_t vertexCount;
+			// Triangle lists of 32 bit indices, ordered for the vertex cache and then to draw outer triangles first
+			uint32_t indexCount;
+			float boundsMin[3];
+			float boundsMax[3];
+			// From the start of the asset
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+
+			// The same triangles again, split into meshlets (see CookedMeshlet)
+			uint32_t meshletCount;
+			// 32 bit entries in the meshlet vertex table
+			uint32_t meshletVertexCount;
+			// Bytes in the meshlet triangle table
+			uint32_t meshletTriangleSize;
+			uint32_t reserved;
+			// From the start of the asset
+			uint64_t meshletOffset;
+			uint64_t meshletVertexOffset;
+			uint64_t meshletTriangleOffset;
+		};
+
+		/*
+		 * A small piece of a mesh that can be culled on its own, or drawn by one mesh shader workgroup.
+		 *
+		 * Its vertices are vertexCount entries of the meshlet vertex table from vertexOffset, each the index of
+		 * a mesh vertex. Its triangles are triangleCount triples of bytes in the triangle table from
+		 * triangleOffset, each indexing the meshlet's own vertices. Each meshlet's triangles start 4 byte aligned.
+		 */
+		struct CookedMeshlet {
+			static constexpr uint32_t MAX_VERTICES = 64;
+			static constexpr uint32_t MAX_TRIANGLES = 124;
+
+			uint32_t vertexOffset;
+			uint32_t vertexCount;
+			uint32_t triangleOffset;
+			uint32_t triangleCount;
+			// Bounding sphere
+			float center[3];
+			float radius;
+			// Normal cone. Every triangle faces away from viewers inside the cone behind its apex, see backfacing().
+			// coneCutoff is 2 when the triangles face too many ways for that to ever hold.
+			float coneApex[3];
+			float coneCutoff;
+			float coneAxis[3];
+			uint32_t reserved;
+
+			// Whether every triangle is back facing from a viewer at this position, so that the meshlet can be culled
+			bool backfacing(const float viewer[3]) const {
+				float direction[3] = { coneApex[0] - viewer[0], coneApex[1] - viewer[1], coneApex[2] - viewer[2] };
+				float along = direction[0] * coneAxis[0] + direction[1] * coneAxis[1] + direction[2] * coneAxis[2];
+				float lengthSquared = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+				// along / length >= coneCutoff, without the square root
+				return along >= 0.0f && along * along >= coneCutoff * coneCutoff * lengthSquared;
+			}
+		};
+
+		class TextureView {
+		public:
+			/*
+			 * A cooked texture, read in place.
+			 * Throws std::runtime_error if data is not a cooked texture of this version.
+			 */
+			explicit TextureView(std::span<const uint8_t> data);
+
+			const CookedTextureHeader& header() const { return *m_header; }
+			uint32_t mipCount() const { return m_header->mipCount; }
+			const CookedMip& mip(uint32_t level) const { return m_mips[level]; }
+			std::span<const uint8_t> mipData(uint32_t level) const { return m_data.subspan(m_mips[level].offset, m_mips[level].size); }
+
+		private:
+			std::span<const uint8_t> m_data;
+			const CookedTextureHeader* m_header;
+			const CookedMip* m_mips;
+		};
+
+		class MeshView {
+		public:
+			/*
+			 * A cooked mesh, read in place.
+			 * Throws std::runtime_error if data is not a cooked mesh of this version.
+			 */
+			explicit MeshView(std::span<const uint8_t> data);
+
+			const CookedMeshHeader& header() const { return *m_header; }
+			std::span<const MeshVertex> vertices() const { return m_vertices; }
+			std::span<const uint32_t> indices() const { return m_indices; }
+			std::span<const CookedMeshlet> meshlets() const { return m_meshlets; }
+			std::span<const uint32_t> meshletVertices() const { return m_meshletVertices; }
+			std::span<const uint8_t> meshletTriangles() const { return m_meshletTriangles; }
+
+		private:
+			const CookedMeshHeader* m_header;
+			std::span<const MeshVertex> m_vertices;
+			std::span<const uint32_t> m_indices;
+			std::span<const CookedMeshlet> m_meshlets;
+			std::span<const uint32_t> m_meshletVertices;
+			std::span<const uint8_t> m_meshletTriangles;
+		};
+
+		// The bytes a mip of a texture takes up in a format
+		uint64_t textureMipSize(TextureFormat format, uint32_t width, uint32_t height);
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Atlas/Archive.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		struct CookInput {
+			// Relative to the Data folder, and the path the cooked asset is loaded by
+			const std::string& path;
+			// Where the source file is on disk, for tools that need to read it themselves
+			const std::string& sourcePath;
+			std::span<const uint8_t> source;
+			// Cookers that read any other file, eg. an #include, add its path on disk here, so that the asset is
+			// recooked when that file changes too
+			std::vector<std::string>& dependencies;
+		};
+
+		class AssetCooker {
+		public:
+			/*
+			 * Turns one kind of source file into the form the runtime loads, so that nothing is decoded or converted
+			 * at load time. The Cooker runs cook() on every worker at once, so it must not change the AssetCooker.
+			 */
+			virtual ~AssetCooker() {}
+
+			// Part of every cache key, along with version()
+			virtual const char* name() const = 0;
+			// Bump whenever the output for the same source changes, so that cached results are not reused
+			virtual uint32_t version() const = 0;
+
+			virtual bool accepts(std::string_view path) const = 0;
+
+			// Throws std::runtime_error if the source cannot be cooked
+			virtual std::vector<uint8_t> cook(const CookInput& input) const = 0;
+		};
+
+		class CookCache {
+		public:
+			/*
+			 * Cooked results kept on disk by a hash of everything that went into them, so that unchanged sources are
+			 * never cooked twice, whichever output or machine they were cooked for. Safe to use from many threads.
+			 * The Cooker stores the hashes of an asset's dependencies alongside it, since they are not part of the key.
+			 */
+			explicit CookCache(const std::string& directory);
+
+			bool load(uint64_t key, std::vector<uint8_t>& data) const;
+			void store(uint64_t key, std::span<const uint8_t> data) const;
+
+		private:
+			std::string pathFor(uint64_t key) const;
+
+			const std::string m_directory;
+		};
+
+		struct CookerConfig {
+			std::string sourceDirectory = "Data/";
+			// Cooked assets are written here under the same paths as their sources. Empty to not write loose files.
+			std::string outputDirectory = "Cooked/";
+			// Also pack every cooked asset into this archive, for mounting with AssetManager. Empty for none.
+			std::string archivePath;
+			ArchiveCompression archiveCompression = ArchiveCompression::LZ4;
+			std::string cacheDirectory = "CookCache/";
+		};
+
+		struct CookReport {
+			size_t cooked = 0;
+			// Reused from the CookCache
+			size_t cached = 0;
+			// Files no cooker accepts, which are passed through unchanged
+			size_t copied = 0;
+			// One line for each source that could not be cooked
+			std::vector<std::string> errors;
+		};
+
+		class Cooker {
+		public:
+			/*
+			 * Cooks a whole Data folder on a WorkerPool, one source per task.
+			 * Each source goes to the first AssetCooker that accepts it, and is looked up in the CookCache by a hash
+			 * of its contents and the cooker's name and version before it is cooked.
+			 *
+			 * The files each asset was cooked from are remembered, and kept in the cache directory between runs, so that
+			 * a change to a shared file (eg. a shader include) can be traced back to every asset that needs recooking.
+			 */
+			Cooker(WorkForce::WorkerPool& pool, const CookerConfig& config);
+			~Cooker();
+
+			Cooker(const Cooker&) = delete;
+			Cooker& operator=(const Cooker&) = delete;
+
+			// Cookers are tried in the order they were added
+			void addCooker(std::unique_ptr<AssetCooker> cooker);
+			// The texture, mesh and shader cookers. shaderCompiler is the glslc to run.
+			void addDefaultCookers(const std::string& shaderCompiler = "glslc");
+
+			// Cook every file below the source directory. Must not be called from a worker.
+			CookReport cookAll();
+
+			/*
+			 * Cook one source, through the cache, without writing it anywhere. Any thread.
+			 * Sets fromCache if nothing had to be cooked. Throws std::runtime_error if it cannot be cooked.
+			 */
+			std::vector<uint8_t> cook(const std::string& path, bool& fromCache) const;
+
+			/*
+			 * The assets that were last cooked using a source, other than the source itself. Any thread.
+			 * Paths are relative to the source directory, as are dependencies inside it.
+			 */
+			std::vector<std::string> dependents(const std::string& source) const;
+
+			const CookerConfig& config() const { return m_config; }
+
+		private:
+			const AssetCooker* findCooker(std::string_view path) const;
+			void writeOutput(const std::string& path, std::span<const uint8_t> data) const;
+			// Relative to the source directory if it is inside it, so that the Data folder can move
+			std::string dependencyPath(const std::string& path) const;
+			// Whether every dependency still has the hash it was cooked with
+			bool dependenciesMatch(const std::vector<std::pair<std::string, uint64_t>>& dependencies) const;
+			void setDependencies(const std::string& path, std::vector<std::string> dependencies) const;
+			void loadDependencies();
+			void saveDependencies() const;
+
+			WorkForce::WorkerPool& m_pool;
+			const CookerConfig m_config;
+			const CookCache m_cache;
+			std::vector<std::unique_ptr<AssetCooker>> m_cookers;
+
+			// Asset path to the other sources it was cooked from, for every asset that has any
+			mutable std::mutex m_dependencyMutex;
+			mutable std::unordered_map<std::string, std::vector<std::string>> m_dependencies;
+		};
+
+		// Read a whole file. Throws std::runtime_error if it cannot be read.
+		std::vector<uint8_t> readFile(const std::string& path);
+		// Write a whole file, replacing it atomically. Throws std::runtime_error if it cannot be written.
+		void writeFile(const std::string& path, std::span<const uint8_t> data);
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "Atlas/AssetHandle.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		template<class T>
+		class HandleTable {
+		public:
+			/*
+			 * Owns objects and hands out AssetHandles to them.
+			 *
+			 * Slots live in fixed size chunks that never move once allocated, so get() is two array indexings and
+			 * a generation check, and can run on any thread without a lock while another thread inserts or removes.
+			 * Removed slots are reused, keeping the table dense.
+			 *
+			 * insert() and remove() must not race each other, the owner is expected to hold a lock around them.
+			 * A pointer from get() stays valid until its object is removed. remove() hands the object back rather
+			 * than destroying it, so that the owner can wait until no reader can still be using it.
+			 */
+			HandleTable()
+				: m_chunks(new std::atomic<Slot*>[MAX_CHUNKS])
+				, m_numSlots(0)
+				, m_freeHead(NO_SLOT)
+				, m_size(0) {
+				for (uint32_t chunk = 0; chunk < MAX_CHUNKS; chunk++) {
+					m_chunks[chunk].store(nullptr, std::memory_order_relaxed);
+				}
+			}
+
+			~HandleTable() {
+				for (uint32_t chunk = 0; chunk < MAX_CHUNKS; chunk++) {
+					Slot* slots = m_chunks[chunk].load(std::memory_order_relaxed);
+					if (!slots) {
+						break;
+					}
+					for (uint32_t i = 0; i < CHUNK_SIZE; i++) {
+						delete slots[i].object.load(std::memory_order_relaxed);
+					}
+					delete[] slots;
+				}
+			}
+
+			HandleTable(const HandleTable&) = delete;
+			HandleTable& operator=(const HandleTable&) = delete;
+
+			// Throws std::length_error if the table is full
+			AssetHandle<T> insert(std::unique_ptr<T> object) {
+				uint32_t index = m_freeHead;
+				Slot* slot;
+				if (index != NO_SLOT) {
+					slot = &this->slot(index);
+					m_freeHead = slot->nextFree;
+				} else {
+					if (m_numSlots == MAX_CHUNKS * CHUNK_SIZE) {
+						throw std::length_error("HandleTable: too many objects");
+					}
+					index = m_numSlots++;
+					if ((index & CHUNK_MASK) == 0) {
+						m_chunks[index >> CHUNK_BITS].store(new Slot[CHUNK_SIZE], std::memory_order_release);
+					}
+					slot = &this->slot(index);
+				}
+				m_size++;
+
+				// The handle is only published after this, so readers of it always find the object
+				slot->object.store(object.release(), std::memory_order_seq_cst);
+				return AssetHandle<T>{ index, slot->generation.load(std::memory_order_relaxed) };
+			}
+
+			// Returns nullptr if the handle was already stale
+			std::unique_ptr<T> remove(AssetHandle<T> handle) {
+				if (!get(handle)) {
+					return nullptr;
+				}
+				Slot& slot = this->slot(handle.index);
+				// Invalidate the handle before clearing the object. A reader that still sees the old generation
+				// after reading the object read it before it was cleared.
+				uint32_t generation = handle.generation + 1;
+				slot.generation.store(generation == 0 ? 1 : generation, std::memory_order_seq_cst);
+				T* object = slot.object.exchange(nullptr, std::memory_order_seq_cst);
+
+				slot.nextFree = m_freeHead;
+				m_freeHead = handle.index;
+				m_size--;
+				return std::unique_ptr<T>(object);
+			}
+
+			/*
+			 * Put a new object behind a handle, eg. a reloaded version of it. The handle stays valid, and get()
+			 * returns either object until this returns. Returns the old object, or nullptr (and takes nothing)
+			 * if the handle was already stale.
+			 */
+			std::unique_ptr<T> replace(AssetHandle<T> handle, std::unique_ptr<T> object) {
+				if (!get(handle)) {
+					return nullptr;
+				}
+				T* old = slot(handle.index).object.exchange(object.release(), std::memory_order_seq_cst);
+				return std::unique_ptr<T>(old);
+			}
+
+			// Any thread, without locking. Returns nullptr if the handle is stale or null.
+			T* get(AssetHandle<T> handle) const {
+				uint32_t chunk = handle.index >> CHUNK_BITS;
+				if (chunk >= MAX_CHUNKS) {
+					return nullptr;
+				}
+				Slot* slots = m_chunks[chunk].load(std::memory_order_acquire);
+				if (!slots) {
+					return nullptr;
+				}
+				const Slot& slot = slots[handle.index & CHUNK_MASK];
+				T* object = slot.object.load(std::memory_order_seq_cst);
+				if (slot.generation.load(std::memory_order_seq_cst) != handle.generation) {
+					return nullptr;
+				}
+				return object;
+			}
+
+			// The number of objects in the table
+			size_t size() const { return m_size; }
+
+		private:
+			static constexpr uint32_t CHUNK_BITS = 10;
+			static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+			static constexpr uint32_t CHUNK_MASK = CHUNK_SIZE - 1;
+			// Up to 4M objects, for a 32KB array of chunk pointers
+			static constexpr uint32_t MAX_CHUNKS = 1u << 12;
+			static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+			struct Slot {
+				std::atomic<T*> object{ nullptr };
+				std::atomic<uint32_t> generation{ 1 };
+				// Owner only, the next slot on the free list
+				uint32_t nextFree = NO_SLOT;
+			};
+
+			Slot& slot(uint32_t index) const {
+				return m_chunks[index >> CHUNK_BITS].load(std::memory_order_relaxed)[index & CHUNK_MASK];
+			}
+
+			std::unique_ptr<std::atomic<Slot*>[]> m_chunks;
+			// Owner only
+			uint32_t m_numSlots;
+			uint32_t m_freeHead;
+			size_t m_size;
+		};
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace FRST {
+	namespace Atlas {
+		// An uncompressed 8 bit per channel RGBA image, rows top to bottom, as the cooker works on them
+		struct Image {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<uint8_t> pixels;
+
+			uint8_t* pixel(uint32_t x, uint32_t y) { return &pixels[(size_t(y) * width + x) * 4]; }
+			const uint8_t* pixel(uint32_t x, uint32_t y) const { return &pixels[(size_t(y) * width + x) * 4]; }
+		};
+	}
+}
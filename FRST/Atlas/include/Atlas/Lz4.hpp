@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+namespace FRST {
+	namespace Atlas {
+		// The most compressLz4() can need for size bytes of input that do not compress
+		constexpr size_t lz4Bound(size_t size) { return size + size / 255 + 16; }
+
+		/*
+		 * Compress into the LZ4 block format, which any LZ4 decoder can read.
+		 * Favours speed over ratio: one greedy pass with a small hash table, as decompression speed is what matters.
+		 * Returns the compressed size, or 0 if it does not fit into destination.
+		 */
+		size_t compressLz4(std::span<const uint8_t> source, std::span<uint8_t> destination);
+
+		/*
+		 * Decompress an LZ4 block into destination, which must be exactly its decompressed size.
+		 * Every read and write is bounds checked. Returns false if the block is corrupt or the wrong size.
+		 */
+		bool decompressLz4(std::span<const uint8_t> source, std::span<uint8_t> destination);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Atlas/Cooker.hpp"
+#include "Atlas/CookedFormats.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		// A mesh in memory, as the mesh cooker builds it
+		struct Mesh {
+			std::vector<MeshVertex> vertices;
+			std::vector<uint32_t> indices;
+			// Filled in by buildMeshlets(), laid out as in the cooked mesh
+			std::vector<CookedMeshlet> meshlets;
+			std::vector<uint32_t> meshletVertices;
+			std::vector<uint8_t> meshletTriangles;
+		};
+
+		class MeshCooker : public AssetCooker {
+			/*
+			 * Cooks Wavefront OBJs into a single indexed triangle list, with identical corners merged into one vertex.
+			 * Polygons are fanned into triangles. Missing normals are generated from the faces, missing UVs are zero.
+			 * The mesh is then reordered and split into meshlets by optimizeMesh().
+			 */
+		public:
+			const char* name() const override { return "mesh"; }
+			uint32_t version() const override { return 2; }
+			bool accepts(std::string_view path) const override;
+			std::vector<uint8_t> cook(const CookInput& input) const override;
+		};
+
+		// Throws std::runtime_error if the OBJ cannot be parsed
+		Mesh parseObj(std::span<const uint8_t> source);
+		std::vector<uint8_t> serializeMesh(const Mesh& mesh);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Atlas/Image.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		/*
+		 * Decode a PNG into RGBA8. Every colour type and bit depth is supported, except interlaced images.
+		 * 16 bit channels are reduced to 8 bits. Throws std::runtime_error if the data is not a PNG it can read.
+		 */
+		Image decodePng(std::span<const uint8_t> data);
+
+		/*
+		 * Decompress a zlib stream (RFC 1950/1951). sizeHint is only used to reserve space.
+		 * Throws std::runtime_error if the stream is corrupt or truncated.
+		 */
+		std::vector<uint8_t> inflateZlib(std::span<const uint8_t> data, size_t sizeHint = 0);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace FRST {
+	namespace Atlas {
+		// Kinds of asset that get their own memory budgets
+		enum class AssetClass : uint8_t {
+			Texture,
+			Mesh,
+			Shader,
+			Other
+		};
+		constexpr size_t ASSET_CLASS_COUNT = 4;
+
+		// Decide an asset's class from its file extension
+		AssetClass classifyAsset(std::string_view path);
+
+		struct ResidencyConfig {
+			/*
+			 * Budgets for each AssetClass, in bytes. Zero means no limit.
+			 * CPU memory is what the asset's data takes up, whether read into memory or mapped from an archive.
+			 * Staging memory is reported by whatever uploads the asset, through AssetManager::setStagingSize().
+			 */
+			uint64_t cpuBudget[ASSET_CLASS_COUNT] = {};
+			uint64_t stagingBudget[ASSET_CLASS_COUNT] = {};
+
+			// Assets used within this many frames are never evicted. Must cover framesInFlight.
+			uint32_t minFramesUnused = 4;
+			// How far from the camera (in world units) an asset must be to count as much as one frame without use
+			float distancePerFrame = 16.0f;
+
+			// Eviction is spread across frames, so that a sudden drop in budget never stalls a frame
+			size_t maxEvictionsPerFrame = 64;
+			uint64_t maxEvictedBytesPerFrame = 64ull << 20;
+		};
+
+		struct ResidencyStats {
+			uint64_t cpuBytes[ASSET_CLASS_COUNT];
+			uint64_t cpuBudget[ASSET_CLASS_COUNT];
+			uint64_t stagingBytes[ASSET_CLASS_COUNT];
+			uint64_t stagingBudget[ASSET_CLASS_COUNT];
+			size_t residentAssets;
+
+			// Since the AssetManager was created. Hits are requests for assets that were already resident.
+			uint64_t hits;
+			uint64_t misses;
+			uint64_t evictions;
+			uint64_t evictedBytes;
+		};
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include "Atlas/Cooker.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		class ShaderCooker : public AssetCooker {
+			/*
+			 * Cooks GLSL (.vert, .frag, .comp, .geom, .tesc, .tese, or .glsl with a #pragma shader_stage) into SPIR-V
+			 * by running glslc, the shaderc command line compiler, on the source file.
+			 * Includes are searched for next to the source, and reported to the Cooker as dependencies.
+			 */
+		public:
+			explicit ShaderCooker(const std::string& compiler = "glslc");
+
+			const char* name() const override { return "shader"; }
+			uint32_t version() const override { return 1; }
+			bool accepts(std::string_view path) const override;
+			std::vector<uint8_t> cook(const CookInput& input) const override;
+
+		private:
+			const std::string m_compiler;
+		};
+	}
+}
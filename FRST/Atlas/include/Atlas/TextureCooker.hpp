@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Atlas/Cooker.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		class TextureCooker : public AssetCooker {
+			/*
+			 * Cooks PNGs into a full mip chain, filtered in linear light (see TextureKernels.hpp), and block compressed:
+			 *   - normal maps (named *_n.png or *_normal.png) to BC5, as X and Y for the shader to rebuild Z from
+			 *   - single channel masks (named *_mask.png) to BC4, from the red channel
+			 *   - anything else with alpha to BC7, other colour textures to BC1
+			 * Normal maps and masks are linear, everything else is sRGB colour.
+			 *
+			 * Alpha that is nearly all 0 or 255 is taken as an alpha tested cutout, like foliage, and its mips are
+			 * scaled to keep the coverage of the full image at ALPHA_TEST_THRESHOLD.
+			 */
+		public:
+			const char* name() const override { return "texture"; }
+			uint32_t version() const override { return 2; }
+			bool accepts(std::string_view path) const override;
+			std::vector<uint8_t> cook(const CookInput& input) const override;
+
+			// The alpha that shaders test cutouts against, 0.5
+			static constexpr uint8_t ALPHA_TEST_THRESHOLD = 128;
+		};
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Atlas/CookedFormats.hpp"
+#include "Atlas/Image.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+
+namespace FRST {
+	namespace Atlas {
+		/*
+		 * The instruction sets texture kernels are built for. Each kernel gives the same results on every level,
+		 * so the level only changes speed. bestSimdLevel() is the fastest one this CPU supports, and the kernels
+		 * below throw std::logic_error if given one it does not.
+		 */
+		enum class SimdLevel {
+			Scalar,
+			SSE41,
+			AVX2
+		};
+		SimdLevel bestSimdLevel();
+		// Whether a level was compiled in and this CPU can run it
+		bool isSimdLevelSupported(SimdLevel level);
+		const char* simdLevelName(SimdLevel level);
+
+		/*
+		 * An image as 14 bit linear light, 4 channels per texel, which mips are built in.
+		 * Averaging sRGB values directly darkens every mip, and rounding to 8 bits at each level adds up down the
+		 * chain, so the chain is built at this precision and each level converted back on its own.
+		 */
+		struct LinearImage {
+			static constexpr uint16_t MAX = (1 << 14) - 1;
+
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<uint16_t> texels;
+		};
+
+		// Alpha is always linear. srgb decides whether the colour channels are decoded from sRGB.
+		LinearImage toLinear(const Image& image, bool srgb);
+		Image fromLinear(const LinearImage& image, bool srgb);
+
+		/*
+		 * Halve an image in each dimension (down to 1), averaging 2x2 texels. Rows are split across pool's workers
+		 * if given. An odd last row or column is averaged with itself.
+		 */
+		LinearImage downsample(const LinearImage& image, WorkForce::WorkerPool* pool = nullptr, SimdLevel level = bestSimdLevel());
+
+		/*
+		 * The fraction of pixels an alpha test at threshold would keep.
+		 * Mips average alpha, so alpha tested foliage thins out with distance unless each mip is scaled back to
+		 * the coverage of the full image with scaleAlphaToCoverage().
+		 */
+		float alphaCoverage(const Image& image, uint8_t threshold);
+		void scaleAlphaToCoverage(Image& image, float coverage, uint8_t threshold, SimdLevel level = bestSimdLevel());
+
+		/*
+		 * Encode an image, padded to whole blocks by repeating its last row and column, into BC1, BC3, BC4 (red),
+		 * BC5 (red and green) or BC7 blocks. Rows of blocks are split across pool's workers if given.
+		 * Throws std::logic_error for formats that are not block compressed.
+		 */
+		std::vector<uint8_t> compressBlocks(const Image& image, TextureFormat format, WorkForce::WorkerPool* pool = nullptr,
+			SimdLevel level = bestSimdLevel());
+	}
+}
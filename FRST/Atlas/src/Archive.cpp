@@ -0,0 +1,209 @@
+#include "Atlas/Archive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Atlas/Lz4.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// Blobs are aligned for 4K pages, but the system's pages may be bigger
+			uintptr_t systemPageSize() {
+				static const uintptr_t size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+				return size;
+			}
+
+			// madvise() the pages covering size bytes from data
+			void advise(const uint8_t* data, uint64_t size, int advice) {
+				if (size == 0) {
+					return;
+				}
+				uintptr_t pageSize = systemPageSize();
+				uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+				uintptr_t end = begin + size;
+				begin &= ~(pageSize - 1);
+				madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+			}
+		}
+
+		Archive::Archive(const std::string& path)
+			: m_path(path)
+			, m_mapping(nullptr)
+			, m_mappingSize(0)
+			, m_header(nullptr)
+			, m_slots(nullptr)
+			, m_paths(nullptr) {
+			int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				throw std::runtime_error("Archive: cannot open " + path);
+			}
+			struct stat status;
+			if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(ArchiveHeader)) {
+				close(fd);
+				throw std::runtime_error("Archive: " + path + " is too small to be an archive");
+			}
+
+			m_mappingSize = static_cast<size_t>(status.st_size);
+			void* mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping keeps the file alive on its own
+			close(fd);
+			if (mapping == MAP_FAILED) {
+				throw std::runtime_error("Archive: cannot map " + path);
+			}
+			m_mapping = static_cast<const uint8_t*>(mapping);
+			m_header = reinterpret_cast<const ArchiveHeader*>(m_mapping);
+
+			// Check everything lookups rely on once, up front, so that they never need to
+			const ArchiveHeader& header = *m_header;
+			const char* problem = nullptr;
+			if (std::memcmp(header.magic, ArchiveHeader::MAGIC, sizeof(header.magic)) != 0) {
+				problem = "is not an archive";
+			} else if (header.version != ArchiveHeader::VERSION) {
+				problem = "was written by a different version";
+			} else if (header.fileSize != m_mappingSize) {
+				problem = "is truncated";
+			} else if (header.blockSize == 0) {
+				problem = "has no block size";
+			} else if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0
+					|| header.entryCount >= header.slotCount
+					|| header.indexOffset % alignof(ArchiveEntry) != 0
+					|| header.indexOffset > m_mappingSize
+					|| header.slotCount > (m_mappingSize - header.indexOffset) / sizeof(ArchiveEntry)
+					|| header.pathsOffset > m_mappingSize) {
+				problem = "has a corrupt index";
+			}
+			if (!problem) {
+				m_slots = reinterpret_cast<const ArchiveEntry*>(m_mapping + header.indexOffset);
+				m_paths = reinterpret_cast<const char*>(m_mapping + header.pathsOffset);
+				uint64_t pathsSize = m_mappingSize - header.pathsOffset;
+				uint64_t numEntries = 0;
+				for (const ArchiveEntry& entry : slots()) {
+					if (entry.empty()) {
+						continue;
+					}
+					numEntries++;
+					if (entry.offset > m_mappingSize || entry.storedSize > m_mappingSize - entry.offset
+							|| uint64_t(entry.pathOffset) + entry.pathLength > pathsSize) {
+						problem = "has an entry outside the file";
+						break;
+					}
+					// Blocks are checked as they are decompressed, but their table must fit
+					if (entry.compression == ArchiveCompression::None ? entry.storedSize != entry.size
+							: entry.compression != ArchiveCompression::LZ4
+								|| (entry.size + header.blockSize - 1) / header.blockSize > entry.storedSize / sizeof(uint64_t)) {
+						problem = "has an entry it cannot decompress";
+						break;
+					}
+				}
+				if (!problem && numEntries != header.entryCount) {
+					problem = "has a corrupt index";
+				}
+			}
+			if (problem) {
+				munmap(const_cast<uint8_t*>(m_mapping), m_mappingSize);
+				throw std::runtime_error("Archive: " + path + " " + problem);
+			}
+
+			// Lookups hop around the index and the paths, so readahead there only reads pages that are never used.
+			// Blobs keep it, as they are read front to back.
+			advise(m_mapping, sizeof(ArchiveHeader), MADV_RANDOM);
+			advise(m_mapping + header.indexOffset, header.slotCount * sizeof(ArchiveEntry), MADV_RANDOM);
+			advise(m_mapping + header.pathsOffset, m_mappingSize - header.pathsOffset, MADV_RANDOM);
+		}
+
+		Archive::~Archive() {
+			munmap(const_cast<uint8_t*>(m_mapping), m_mappingSize);
+		}
+
+		const ArchiveEntry* Archive::find(AssetUUID uuid) const {
+			uint64_t mask = m_header->slotCount - 1;
+			// The index is at most half full, so this always reaches an empty slot
+			for (uint64_t slot = uuid.uuid & mask;; slot = (slot + 1) & mask) {
+				const ArchiveEntry& entry = m_slots[slot];
+				if (entry.empty()) {
+					return nullptr;
+				}
+				if (entry.uuid == uuid.uuid) {
+					return &entry;
+				}
+			}
+		}
+
+		std::span<const uint8_t> Archive::data(const ArchiveEntry& entry) const {
+			if (entry.compressed()) {
+				throw std::logic_error("Archive: " + std::string(assetPath(entry)) + " is compressed, and must be decompressed");
+			}
+			return { m_mapping + entry.offset, static_cast<size_t>(entry.size) };
+		}
+
+		size_t Archive::blockCount(const ArchiveEntry& entry) const {
+			return static_cast<size_t>((entry.size + m_header->blockSize - 1) / m_header->blockSize);
+		}
+
+		bool Archive::decompressBlock(const ArchiveEntry& entry, size_t block, std::span<uint8_t> destination) const {
+			size_t blocks = blockCount(entry);
+			if (block >= blocks || destination.size() != entry.size) {
+				return false;
+			}
+			// The table is only 8 byte aligned if the blob is, which ArchiveHeader::ALIGNMENT guarantees
+			const uint64_t* ends = reinterpret_cast<const uint64_t*>(m_mapping + entry.offset);
+			uint64_t tableSize = blocks * sizeof(uint64_t);
+			uint64_t begin = block == 0 ? 0 : ends[block - 1];
+			uint64_t end = ends[block];
+			if (begin > end || end > entry.storedSize - tableSize) {
+				return false;
+			}
+
+			uint64_t blockBegin = uint64_t(block) * m_header->blockSize;
+			size_t blockSize = static_cast<size_t>(std::min<uint64_t>(m_header->blockSize, entry.size - blockBegin));
+			std::span<const uint8_t> stored(m_mapping + entry.offset + tableSize + begin, static_cast<size_t>(end - begin));
+			std::span<uint8_t> output = destination.subspan(static_cast<size_t>(blockBegin), blockSize);
+			if (stored.size() == output.size()) {
+				std::memcpy(output.data(), stored.data(), stored.size());
+				return true;
+			}
+			return decompressLz4(stored, output);
+		}
+
+		bool Archive::read(const ArchiveEntry& entry, std::span<uint8_t> destination) const {
+			if (destination.size() != entry.size) {
+				return false;
+			}
+			if (!entry.compressed()) {
+				std::memcpy(destination.data(), m_mapping + entry.offset, destination.size());
+				return true;
+			}
+			for (size_t block = 0; block < blockCount(entry); block++) {
+				if (!decompressBlock(entry, block, destination)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		std::string_view Archive::assetPath(const ArchiveEntry& entry) const {
+			return { m_paths + entry.pathOffset, entry.pathLength };
+		}
+
+		void Archive::willNeed(const ArchiveEntry& entry) const {
+			advise(m_mapping + entry.offset, entry.storedSize, MADV_WILLNEED);
+		}
+
+		void Archive::dontNeed(const ArchiveEntry& entry) const {
+			// Only drop pages wholly inside the entry, which may be shared with neighbours on bigger pages
+			uintptr_t pageSize = systemPageSize();
+			uintptr_t begin = (reinterpret_cast<uintptr_t>(m_mapping + entry.offset) + pageSize - 1) & ~(pageSize - 1);
+			uintptr_t end = (reinterpret_cast<uintptr_t>(m_mapping + entry.offset) + entry.storedSize) & ~(pageSize - 1);
+			if (begin < end) {
+				madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+			}
+		}
+	}
+}
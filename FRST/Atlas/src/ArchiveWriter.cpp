@@ -0,0 +1,172 @@
+#include "Atlas/ArchiveWriter.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "Atlas/Lz4.hpp"
+#include "WorkForce/Parallel.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			uint64_t alignUp(uint64_t value, uint64_t alignment) {
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+		}
+
+		ArchiveWriter::ArchiveWriter(ArchiveCompression compression, uint32_t blockSize)
+			: m_compression(compression)
+			, m_blockSize(blockSize) {
+			if (blockSize == 0) {
+				throw std::logic_error("ArchiveWriter: the block size must not be 0");
+			}
+		}
+
+		void ArchiveWriter::add(const std::string& path, std::vector<uint8_t> data) {
+			AssetUUID uuid = AssetUUID::CreateAssetUUID(path);
+			auto inserted = m_uuids.emplace(uuid, m_assets.size());
+			if (!inserted.second) {
+				const std::string& existing = m_assets[inserted.first->second].path;
+				if (existing == path) {
+					throw std::logic_error("ArchiveWriter: \"" + path + "\" was added twice");
+				}
+				throw std::logic_error("ArchiveWriter: \"" + path + "\" and \"" + existing + "\" have the same AssetUUID");
+			}
+			m_assets.push_back(PendingAsset{ path, uuid, std::move(data), {} });
+		}
+
+		uint64_t ArchiveWriter::totalSize() const {
+			uint64_t size = 0;
+			for (const PendingAsset& asset : m_assets) {
+				size += asset.data.size();
+			}
+			return size;
+		}
+
+		uint64_t ArchiveWriter::totalStoredSize() const {
+			uint64_t size = 0;
+			for (const PendingAsset& asset : m_assets) {
+				size += stored(asset).size();
+			}
+			return size;
+		}
+
+		void ArchiveWriter::compress(PendingAsset& asset) const {
+			asset.compressed.clear();
+			if (m_compression == ArchiveCompression::None || asset.data.empty()) {
+				return;
+			}
+			size_t blocks = (asset.data.size() + m_blockSize - 1) / m_blockSize;
+			std::vector<uint8_t> compressed(blocks * sizeof(uint64_t) + lz4Bound(m_blockSize) * blocks);
+			uint64_t* ends = reinterpret_cast<uint64_t*>(compressed.data());
+			size_t tableSize = blocks * sizeof(uint64_t);
+			uint64_t end = 0;
+			for (size_t block = 0; block < blocks; block++) {
+				std::span<const uint8_t> input(asset.data);
+				input = input.subspan(block * m_blockSize, std::min<size_t>(m_blockSize, input.size() - block * m_blockSize));
+				uint8_t* output = compressed.data() + tableSize + end;
+				// A block that does not shrink is stored raw, which the reader tells apart by its size
+				size_t size = compressLz4(input, std::span<uint8_t>(output, input.size() - 1));
+				if (size == 0) {
+					std::memcpy(output, input.data(), input.size());
+					size = input.size();
+				}
+				end += size;
+				ends[block] = end;
+			}
+			compressed.resize(tableSize + end);
+
+			// Decompressing costs time at load, so it has to save a useful amount of reading
+			if (compressed.size() < asset.data.size() - asset.data.size() / 16) {
+				asset.compressed = std::move(compressed);
+			}
+		}
+
+		void ArchiveWriter::write(const std::string& archivePath, WorkForce::WorkerPool* pool) {
+			if (pool) {
+				WorkForce::parallelFor(*pool, WorkForce::Range{ 0, m_assets.size() }, 1, [&](size_t index) {
+					compress(m_assets[index]);
+				});
+			} else {
+				for (PendingAsset& asset : m_assets) {
+					compress(asset);
+				}
+			}
+
+			ArchiveHeader header;
+			std::memcpy(header.magic, ArchiveHeader::MAGIC, sizeof(header.magic));
+			header.version = ArchiveHeader::VERSION;
+			header.alignment = ArchiveHeader::ALIGNMENT;
+			header.blockSize = m_blockSize;
+			header.reserved = 0;
+			header.entryCount = m_assets.size();
+			header.slotCount = 2;
+			while (header.slotCount < m_assets.size() * 2) {
+				header.slotCount <<= 1;
+			}
+			header.indexOffset = sizeof(ArchiveHeader);
+			header.pathsOffset = header.indexOffset + header.slotCount * sizeof(ArchiveEntry);
+
+			// The blobs start on the first aligned offset after the paths
+			std::vector<ArchiveEntry> slots(header.slotCount, ArchiveEntry{ 0, 0, 0, 0, 0, 0, ArchiveCompression::None, 0 });
+			std::string paths;
+			uint64_t pathsSize = 0;
+			uint64_t blobOffset = 0;
+			std::vector<uint64_t> blobOffsets;
+			blobOffsets.reserve(m_assets.size());
+			for (const PendingAsset& asset : m_assets) {
+				pathsSize += asset.path.size();
+				blobOffsets.push_back(blobOffset);
+				blobOffset = alignUp(blobOffset + stored(asset).size(), ArchiveHeader::ALIGNMENT);
+			}
+			uint64_t blobsOffset = alignUp(header.pathsOffset + pathsSize, ArchiveHeader::ALIGNMENT);
+			header.fileSize = blobsOffset + blobOffset;
+
+			uint64_t mask = header.slotCount - 1;
+			for (size_t i = 0; i < m_assets.size(); i++) {
+				const PendingAsset& asset = m_assets[i];
+				uint64_t slot = asset.uuid.uuid & mask;
+				while (!slots[slot].empty()) {
+					slot = (slot + 1) & mask;
+				}
+				slots[slot].uuid = asset.uuid.uuid;
+				slots[slot].offset = blobsOffset + blobOffsets[i];
+				slots[slot].size = asset.data.size();
+				slots[slot].storedSize = stored(asset).size();
+				slots[slot].compression = asset.compressed.empty() ? ArchiveCompression::None : m_compression;
+				slots[slot].pathOffset = static_cast<uint32_t>(paths.size());
+				slots[slot].pathLength = static_cast<uint32_t>(asset.path.size());
+				paths += asset.path;
+			}
+
+			std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+			if (!file) {
+				throw std::runtime_error("ArchiveWriter: cannot create " + archivePath);
+			}
+			static const char padding[ArchiveHeader::ALIGNMENT] = {};
+			uint64_t position = 0;
+			auto pad = [&](uint64_t to) {
+				file.write(padding, static_cast<std::streamsize>(to - position));
+				position = to;
+			};
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(ArchiveEntry)));
+			file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+			position = header.pathsOffset + paths.size();
+			for (size_t i = 0; i < m_assets.size(); i++) {
+				pad(blobsOffset + blobOffsets[i]);
+				const std::vector<uint8_t>& data = stored(m_assets[i]);
+				file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+				position += data.size();
+			}
+			pad(header.fileSize);
+
+			file.close();
+			if (!file) {
+				throw std::runtime_error("ArchiveWriter: failed writing " + archivePath);
+			}
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#include "Atlas/Asset.hpp"
+
+#include <cerrno>
+#include <unistd.h>
+
+#include "Atlas/AssetManager.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		Asset::Asset(const std::string& path, AssetUUID uuid, AssetClass assetClass, WorkForce::WorkerPool& pool)
+			: m_path(path)
+			, m_uuid(uuid)
+			, m_handle()
+			, m_class(assetClass)
+			, m_data()
+			, m_view()
+			, m_failed(false)
+			, m_cancelled(false)
+			, m_loaded(pool)
+			, m_archive(nullptr)
+			, m_archiveEntry(nullptr)
+			, m_lastUse(0)
+			, m_distance(0.0f)
+			, m_residentSize(0)
+			, m_stagingSize(0)
+			, m_residentCounter(nullptr)
+			, m_fd(-1)
+			, m_request()
+			, m_readCompletion() {
+			m_readCompletion.execute = &Asset::finishRead;
+			m_readCompletion.asset = this;
+			m_readCompletion.manager = nullptr;
+			m_request.completion = &m_readCompletion;
+		}
+
+		void Asset::finishRead(WorkForce::WorkItem* item, WorkForce::Worker&) {
+			Asset& asset = *static_cast<ReadCompletion*>(item)->asset;
+			close(asset.m_fd);
+			asset.m_fd = -1;
+
+			if (asset.m_request.result != static_cast<int64_t>(asset.m_data.size())) {
+				asset.m_failed = true;
+				asset.m_cancelled = asset.m_request.result == -ECANCELED;
+				asset.m_data.clear();
+				asset.m_data.shrink_to_fit();
+				// The budget was charged when the read started. Give it back, so that it only ever counts real data.
+				asset.m_residentCounter->fetch_sub(asset.m_residentSize, std::memory_order_relaxed);
+				asset.m_residentSize = 0;
+			}
+			asset.m_view = asset.m_data;
+			asset.m_loaded.set();
+			// Last, as the AssetManager may be destroyed as soon as no reads are outstanding
+			asset.m_readCompletion.manager->finishTask();
+		}
+	}
+}
@@ -0,0 +1,10 @@
+#include "Atlas/AssetLoadJob.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		AssetLoadJob::AssetLoadJob(AssetManager& assetManager)
+			: AssetUpdateJob(assetManager) {}
+
+		AssetLoadJob::~AssetLoadJob() {}
+	}
+}
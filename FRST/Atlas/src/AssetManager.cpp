@@ -0,0 +1,643 @@
+#include "Atlas/AssetManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "WorkForce/Parallel.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		AssetManager::AssetManager(WorkForce::WorkerPool& pool, const std::string& dataDirectory, const AsyncIOConfig& ioConfig,
+				const ResidencyConfig& residencyConfig)
+			: m_pool(pool)
+			, m_dataDirectory(dataDirectory)
+			, m_residency(residencyConfig)
+			, m_frame(0)
+			, m_hits(0)
+			, m_misses(0)
+			, m_evictions(0)
+			, m_evictedBytes(0)
+			, m_cooker(nullptr)
+			, m_nextReloadRequest(0)
+			, m_tasksRunning(0)
+			, m_io(new AsyncIO(pool, ioConfig)) {
+			for (size_t i = 0; i < ASSET_CLASS_COUNT; i++) {
+				m_cpuBytes[i].store(0, std::memory_order_relaxed);
+				m_stagingBytes[i].store(0, std::memory_order_relaxed);
+				m_decompressedAssets[i].store(0, std::memory_order_relaxed);
+				m_compressedBytes[i].store(0, std::memory_order_relaxed);
+				m_decompressedBytes[i].store(0, std::memory_order_relaxed);
+				m_decompressionNanoseconds[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		AssetManager::~AssetManager() {
+			// The I/O system only queues the completions of the reads it cancels or drains, which still use their assets.
+			// No more changes once the watcher is gone, and then no more reloads once the last cook has finished.
+			m_io.reset();
+			m_watcher.reset();
+			{
+				std::unique_lock<std::mutex> lock(m_taskMutex);
+				m_taskCondition.wait(lock, [this]() { return m_tasksRunning == 0; });
+			}
+			if (m_cooker) {
+				m_pool.removeFrameListener(this);
+			}
+		}
+
+		void AssetManager::mountArchive(const std::string& archivePath) {
+			std::unique_ptr<Archive> archive(new Archive(archivePath));
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+
+			// An archive may replace assets with the same path, eg. in a patch, but two paths sharing an AssetUUID
+			// would silently load the wrong data
+			for (const ArchiveEntry& entry : archive->slots()) {
+				if (entry.empty()) {
+					continue;
+				}
+				AssetUUID uuid{ entry.uuid };
+				std::string_view path = archive->assetPath(entry);
+				auto handle = m_uuidHandleMap.find(uuid);
+				if (handle != m_uuidHandleMap.end() && m_assets.get(handle->second)->path() != path) {
+					throw std::logic_error("AssetManager: \"" + std::string(path) + "\" in " + archivePath
+						+ " has the same AssetUUID as \"" + m_assets.get(handle->second)->path() + "\"");
+				}
+				const ArchiveEntry* existing;
+				const Archive* other = findArchived(uuid, existing);
+				if (other && other->assetPath(*existing) != path) {
+					throw std::logic_error("AssetManager: \"" + std::string(path) + "\" in " + archivePath
+						+ " has the same AssetUUID as \"" + std::string(other->assetPath(*existing)) + "\" in " + other->path());
+				}
+			}
+			m_archives.push_back(std::move(archive));
+		}
+
+		AssetLoad AssetManager::load(const std::string& path, WorkForce::Priority priority) {
+			bool isNew;
+			Asset& asset = findOrCreate(path, isNew);
+			if (isNew && prepareRead(asset, priority)) {
+				beginTasks(1);
+				m_io->submit(&asset.m_request);
+			}
+			return AssetLoad(asset);
+		}
+
+		void AssetManager::prefetch(const std::vector<std::string>& paths, WorkForce::Priority priority) {
+			std::vector<IORequest*> requests;
+			requests.reserve(paths.size());
+			for (const std::string& path : paths) {
+				bool isNew;
+				Asset& asset = findOrCreate(path, isNew);
+				if (asset.m_archive) {
+					asset.m_archive->willNeed(*asset.m_archiveEntry);
+				} else if (isNew && prepareRead(asset, priority)) {
+					requests.push_back(&asset.m_request);
+				}
+			}
+			beginTasks(requests.size());
+			m_io->submit(requests.data(), requests.size());
+		}
+
+		bool AssetManager::cancel(const std::string& path) {
+			Asset* asset;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				auto found = m_pathHandleMap.find(path);
+				if (found == m_pathHandleMap.end()) {
+					return false;
+				}
+				asset = m_assets.get(found->second);
+			}
+			return !asset->isLoaded() && m_io->cancel(&asset->m_request);
+		}
+
+		const Asset& AssetManager::getAsset(AssetUUID uuid) {
+			return *m_assets.get(getHandle(uuid));
+		}
+
+		AssetHandle<Asset> AssetManager::getHandle(AssetUUID uuid) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			auto found = m_uuidHandleMap.find(uuid);
+			if (found != m_uuidHandleMap.end()) {
+				m_hits.fetch_add(1, std::memory_order_relaxed);
+				use(found->second);
+				return found->second;
+			}
+
+			const ArchiveEntry* entry;
+			const Archive* archive = findArchived(uuid, entry);
+			if (!archive) {
+				throw std::out_of_range("AssetManager: no asset has this AssetUUID");
+			}
+			return create(std::string(archive->assetPath(*entry)), uuid).handle();
+		}
+
+		Asset& AssetManager::findOrCreate(const std::string& path, bool& isNew) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			auto found = m_pathHandleMap.find(path);
+			if (found != m_pathHandleMap.end()) {
+				isNew = false;
+				m_hits.fetch_add(1, std::memory_order_relaxed);
+				use(found->second);
+				return *m_assets.get(found->second);
+			}
+
+			Asset& asset = create(path, AssetUUID::CreateAssetUUID(path));
+			// Archived assets are already loaded, or being decompressed
+			isNew = !asset.m_archive;
+			return asset;
+		}
+
+		Asset& AssetManager::create(const std::string& path, AssetUUID uuid) {
+			auto collision = m_uuidHandleMap.find(uuid);
+			if (collision != m_uuidHandleMap.end()) {
+				throw std::logic_error("AssetManager: \"" + path + "\" has the same AssetUUID as \""
+					+ m_assets.get(collision->second)->path() + "\"");
+			}
+			const ArchiveEntry* entry;
+			const Archive* archive = findArchived(uuid, entry);
+			if (archive && archive->assetPath(*entry) != path) {
+				throw std::logic_error("AssetManager: \"" + path + "\" has the same AssetUUID as \""
+					+ std::string(archive->assetPath(*entry)) + "\" in " + archive->path());
+			}
+
+			Asset* asset = new Asset(path, uuid, classifyAsset(path), m_pool);
+			asset->m_handle = m_assets.insert(std::unique_ptr<Asset>(asset));
+			m_pathHandleMap.emplace(path, asset->m_handle);
+			m_uuidHandleMap.emplace(uuid, asset->m_handle);
+			asset->m_lastUse.store(m_frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			asset->m_residentCounter = &m_cpuBytes[static_cast<size_t>(asset->m_class)];
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+			if (archive) {
+				asset->m_archive = archive;
+				asset->m_archiveEntry = entry;
+				asset->m_residentSize = entry->size;
+				asset->m_residentCounter->fetch_add(entry->size, std::memory_order_relaxed);
+				// Start reading the blob in now, rather than a page per fault once it is first touched
+				archive->willNeed(*entry);
+				if (entry->compressed()) {
+					asset->m_data.resize(static_cast<size_t>(entry->size));
+					beginTasks(1);
+					WorkForce::spawn(m_pool, inflate(*asset));
+				} else {
+					// Nothing can be waiting on an asset that was only just created, so this is cheap to do under the lock
+					asset->m_view = archive->data(*entry);
+					asset->m_loaded.set();
+				}
+			}
+			return *asset;
+		}
+
+		const Archive* AssetManager::findArchived(AssetUUID uuid, const ArchiveEntry*& entry) const {
+			for (auto archive = m_archives.rbegin(); archive != m_archives.rend(); ++archive) {
+				entry = (*archive)->find(uuid);
+				if (entry) {
+					return archive->get();
+				}
+			}
+			return nullptr;
+		}
+
+		bool AssetManager::prepareRead(Asset& asset, WorkForce::Priority priority) {
+			// Opening is a metadata lookup that the kernel normally answers from cache, so it is done here
+			// rather than through the I/O system. Only the data itself is read asynchronously.
+			std::string path = m_dataDirectory + asset.path();
+			asset.m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			struct stat status;
+			if (asset.m_fd < 0 || fstat(asset.m_fd, &status) != 0 || status.st_size > static_cast<off_t>(UINT32_MAX)) {
+				if (asset.m_fd >= 0) {
+					close(asset.m_fd);
+					asset.m_fd = -1;
+				}
+				asset.m_failed = true;
+				asset.m_loaded.set();
+				return false;
+			}
+
+			asset.m_data.resize(static_cast<size_t>(status.st_size));
+			asset.m_residentSize = asset.m_data.size();
+			asset.m_residentCounter->fetch_add(asset.m_residentSize, std::memory_order_relaxed);
+			asset.m_request.fd = asset.m_fd;
+			asset.m_request.offset = 0;
+			asset.m_request.buffer = asset.m_data.data();
+			asset.m_request.size = static_cast<uint32_t>(status.st_size);
+			asset.m_request.priority = priority;
+			asset.m_readCompletion.manager = this;
+			return true;
+		}
+
+		void AssetManager::use(AssetHandle<Asset> handle, float distance) {
+			Asset* asset = m_assets.get(handle);
+			if (!asset) {
+				return;
+			}
+			// Many jobs may use the same asset each frame, so only write when something changes
+			uint64_t frame = m_frame.load(std::memory_order_relaxed);
+			if (asset->m_lastUse.load(std::memory_order_relaxed) != frame) {
+				asset->m_lastUse.store(frame, std::memory_order_relaxed);
+				asset->m_distance.store(distance, std::memory_order_relaxed);
+			} else if (distance < asset->m_distance.load(std::memory_order_relaxed)) {
+				asset->m_distance.store(distance, std::memory_order_relaxed);
+			}
+		}
+
+		void AssetManager::setStagingSize(AssetHandle<Asset> handle, uint64_t bytes) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			Asset* asset = m_assets.get(handle);
+			if (!asset) {
+				return;
+			}
+			std::atomic<uint64_t>& counter = m_stagingBytes[static_cast<size_t>(asset->m_class)];
+			counter.fetch_sub(asset->m_stagingSize, std::memory_order_relaxed);
+			counter.fetch_add(bytes, std::memory_order_relaxed);
+			asset->m_stagingSize = bytes;
+		}
+
+		void AssetManager::setEvictionCallback(std::function<void(const Asset&)> callback) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			m_evictionCallback = std::move(callback);
+		}
+
+		void AssetManager::setBudget(AssetClass assetClass, uint64_t cpuBytes, uint64_t stagingBytes) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			m_residency.cpuBudget[static_cast<size_t>(assetClass)] = cpuBytes;
+			m_residency.stagingBudget[static_cast<size_t>(assetClass)] = stagingBytes;
+		}
+
+		void AssetManager::updateResidency(uint64_t frame) {
+			m_frame.store(frame, std::memory_order_relaxed);
+
+			std::vector<std::unique_ptr<Asset>> destroyed;
+			std::vector<Asset*> evicted;
+			std::function<void(const Asset&)> callback;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+
+				// An asset evicted during frame F may have been looked up by any frame that was running at the time.
+				// The last of those has finished once frame F + 2 * framesInFlight has begun.
+				uint64_t retireFrames = 2 * m_pool.framesInFlight();
+				while (!m_retired.empty() && m_retired.front().first + retireFrames <= frame) {
+					destroyed.push_back(std::move(m_retired.front().second));
+					m_retired.pop_front();
+				}
+
+				auto isCpuOverBudget = [this](size_t assetClass) {
+					uint64_t budget = m_residency.cpuBudget[assetClass];
+					return budget && m_cpuBytes[assetClass].load(std::memory_order_relaxed) > budget;
+				};
+				auto isStagingOverBudget = [this](size_t assetClass) {
+					uint64_t budget = m_residency.stagingBudget[assetClass];
+					return budget && m_stagingBytes[assetClass].load(std::memory_order_relaxed) > budget;
+				};
+				// Evicting an asset only helps if it holds bytes in a budget its class is over
+				auto helpsBudget = [&](const Asset& asset) {
+					size_t assetClass = static_cast<size_t>(asset.m_class);
+					return (asset.m_residentSize > 0 && isCpuOverBudget(assetClass))
+						|| (asset.m_stagingSize > 0 && isStagingOverBudget(assetClass));
+				};
+				bool anyOverBudget = false;
+				for (size_t assetClass = 0; assetClass < ASSET_CLASS_COUNT; assetClass++) {
+					anyOverBudget |= isCpuOverBudget(assetClass) || isStagingOverBudget(assetClass);
+				}
+
+				if (anyOverBudget) {
+					// Only the coldest few are needed, so rank every candidate but only sort the front
+					struct Candidate {
+						float coldness;
+						Asset* asset;
+					};
+					std::vector<Candidate> candidates;
+					for (const auto& entry : m_uuidHandleMap) {
+						Asset* asset = m_assets.get(entry.second);
+						if (!asset->isLoaded() || !helpsBudget(*asset)) {
+							continue;
+						}
+						uint64_t lastUse = asset->m_lastUse.load(std::memory_order_relaxed);
+						if (lastUse + m_residency.minFramesUnused > frame) {
+							continue;
+						}
+						float coldness = static_cast<float>(frame - lastUse)
+							+ asset->m_distance.load(std::memory_order_relaxed) / m_residency.distancePerFrame;
+						candidates.push_back(Candidate{ coldness, asset });
+					}
+
+					size_t count = std::min(candidates.size(), m_residency.maxEvictionsPerFrame);
+					std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+						[](const Candidate& a, const Candidate& b) { return a.coldness > b.coldness; });
+
+					uint64_t evictedBytes = 0;
+					for (size_t i = 0; i < count && evictedBytes < m_residency.maxEvictedBytesPerFrame; i++) {
+						Asset& asset = *candidates[i].asset;
+						// Earlier evictions may already have brought the class back within budget
+						if (!helpsBudget(asset)) {
+							continue;
+						}
+						evictedBytes += asset.m_residentSize + asset.m_stagingSize;
+						evict(asset);
+						evicted.push_back(&asset);
+					}
+				}
+
+				if (!evicted.empty()) {
+					callback = m_evictionCallback;
+				}
+			}
+
+			if (callback) {
+				for (Asset* asset : evicted) {
+					callback(*asset);
+				}
+			}
+			// destroyed frees its assets here, outside of the lock
+		}
+
+		bool AssetManager::unload(AssetHandle<Asset> handle) {
+			Asset* asset;
+			std::function<void(const Asset&)> callback;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				asset = m_assets.get(handle);
+				if (!asset || !asset->isLoaded()) {
+					return false;
+				}
+				evict(*asset);
+				callback = m_evictionCallback;
+			}
+			if (callback) {
+				callback(*asset);
+			}
+			return true;
+		}
+
+		ResidencyStats AssetManager::residencyStats() {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			ResidencyStats stats;
+			for (size_t i = 0; i < ASSET_CLASS_COUNT; i++) {
+				stats.cpuBytes[i] = m_cpuBytes[i].load(std::memory_order_relaxed);
+				stats.cpuBudget[i] = m_residency.cpuBudget[i];
+				stats.stagingBytes[i] = m_stagingBytes[i].load(std::memory_order_relaxed);
+				stats.stagingBudget[i] = m_residency.stagingBudget[i];
+			}
+			stats.residentAssets = m_assets.size();
+			stats.hits = m_hits.load(std::memory_order_relaxed);
+			stats.misses = m_misses.load(std::memory_order_relaxed);
+			stats.evictions = m_evictions.load(std::memory_order_relaxed);
+			stats.evictedBytes = m_evictedBytes.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+		void AssetManager::evict(Asset& asset) {
+			size_t assetClass = static_cast<size_t>(asset.m_class);
+			m_cpuBytes[assetClass].fetch_sub(asset.m_residentSize, std::memory_order_relaxed);
+			m_stagingBytes[assetClass].fetch_sub(asset.m_stagingSize, std::memory_order_relaxed);
+			m_evictions.fetch_add(1, std::memory_order_relaxed);
+			m_evictedBytes.fetch_add(asset.m_residentSize + asset.m_stagingSize, std::memory_order_relaxed);
+
+			if (asset.m_archive) {
+				asset.m_archive->dontNeed(*asset.m_archiveEntry);
+			}
+			m_pathHandleMap.erase(asset.path());
+			m_uuidHandleMap.erase(asset.uuid());
+			// From here the asset's handle no longer resolves, but it stays alive until updateResidency() retires it
+			m_retired.emplace_back(m_frame.load(std::memory_order_relaxed), m_assets.remove(asset.handle()));
+		}
+
+		bool AssetManager::enableHotReload(const Cooker& cooker) {
+#ifdef FRST_HOT_RELOAD_ENABLED
+			if (m_cooker) {
+				return true;
+			}
+			m_watcher.reset(new AssetWatcher(cooker.config().sourceDirectory,
+				[this](const std::vector<std::string>& sources) { sourcesChanged(sources); }));
+			m_cooker = &cooker;
+			m_pool.addFrameListener(this);
+			return true;
+#else
+			(void)cooker;
+			return false;
+#endif
+		}
+
+		void AssetManager::setReloadCallback(std::function<void(const Asset&)> callback) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			m_reloadCallback = std::move(callback);
+		}
+
+		void AssetManager::sourcesChanged(const std::vector<std::string>& sources) {
+			// Cooked assets keep their source's path, so a source is the asset it cooks to, plus whatever includes it
+			std::vector<std::string> affected;
+			for (const std::string& source : sources) {
+				affected.push_back(source);
+				std::vector<std::string> dependents = m_cooker->dependents(source);
+				affected.insert(affected.end(), dependents.begin(), dependents.end());
+			}
+			std::sort(affected.begin(), affected.end());
+			affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+			// Only assets that are loaded need recooking now. The rest pick the change up when they are cooked next.
+			std::vector<std::pair<std::string, uint64_t>> reloads;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				for (std::string& path : affected) {
+					if (m_pathHandleMap.count(path)) {
+						uint64_t request = ++m_nextReloadRequest;
+						m_reloadRequests[path] = request;
+						reloads.emplace_back(std::move(path), request);
+					}
+				}
+			}
+			beginTasks(reloads.size());
+			for (auto& reload : reloads) {
+				WorkForce::spawn(m_pool, this->reload(std::move(reload.first), reload.second), WorkForce::Priority::Background);
+			}
+		}
+
+		WorkForce::Task<void> AssetManager::reload(std::string path, uint64_t request) {
+			std::unique_ptr<Asset> asset;
+			try {
+				bool fromCache;
+				std::vector<uint8_t> data = m_cooker->cook(path, fromCache);
+				asset.reset(new Asset(path, AssetUUID::CreateAssetUUID(path), classifyAsset(path), m_pool));
+				asset->m_data = std::move(data);
+				asset->m_view = asset->m_data;
+				asset->m_residentSize = asset->m_data.size();
+				asset->m_loaded.set();
+			} catch (const std::exception& e) {
+				std::cerr << "Hot reload of " << path << " failed: " << e.what() << std::endl;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				auto latest = m_reloadRequests.find(path);
+				if (latest != m_reloadRequests.end() && latest->second == request) {
+					m_reloadRequests.erase(latest);
+					if (asset) {
+						m_reloaded.push_back(std::move(asset));
+					}
+				}
+			}
+			finishTask();
+			co_return;
+		}
+
+		void AssetManager::onBeginFrame(uint64_t frame) {
+			std::vector<Asset*> replaced;
+			std::vector<Asset*> reloaded;
+			std::function<void(const Asset&)> evictionCallback;
+			std::function<void(const Asset&)> reloadCallback;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				if (m_reloaded.empty()) {
+					return;
+				}
+				std::vector<std::unique_ptr<Asset>> waiting;
+				for (std::unique_ptr<Asset>& asset : m_reloaded) {
+					auto found = m_pathHandleMap.find(asset->path());
+					if (found == m_pathHandleMap.end()) {
+						// Evicted or unloaded while it was cooking, and loads the new version if requested again
+						continue;
+					}
+					Asset* old = m_assets.get(found->second);
+					if (!old->isLoaded()) {
+						// Its first load is still being read, and may be waited on
+						waiting.push_back(std::move(asset));
+						continue;
+					}
+
+					// The new version takes over the old one's place in the budgets, but not its staging copy,
+					// which was built from the old data
+					size_t assetClass = static_cast<size_t>(old->m_class);
+					m_cpuBytes[assetClass].fetch_sub(old->m_residentSize, std::memory_order_relaxed);
+					m_stagingBytes[assetClass].fetch_sub(old->m_stagingSize, std::memory_order_relaxed);
+					m_cpuBytes[assetClass].fetch_add(asset->m_residentSize, std::memory_order_relaxed);
+					if (old->m_archive) {
+						old->m_archive->dontNeed(*old->m_archiveEntry);
+					}
+					asset->m_handle = old->m_handle;
+					asset->m_lastUse.store(old->m_lastUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					asset->m_distance.store(old->m_distance.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					asset->m_residentCounter = old->m_residentCounter;
+
+					reloaded.push_back(asset.get());
+					replaced.push_back(old);
+					// Jobs of older frames may still be using the old version, so it is retired like an evicted asset
+					m_retired.emplace_back(frame, m_assets.replace(old->m_handle, std::move(asset)));
+				}
+				m_reloaded = std::move(waiting);
+				evictionCallback = m_evictionCallback;
+				reloadCallback = m_reloadCallback;
+			}
+
+			for (size_t i = 0; i < reloaded.size(); i++) {
+				if (evictionCallback) {
+					evictionCallback(*replaced[i]);
+				}
+				if (reloadCallback) {
+					reloadCallback(*reloaded[i]);
+				}
+			}
+		}
+
+		WorkForce::Task<bool> AssetManager::readInto(const std::string& path, std::span<uint8_t> destination) {
+			const Archive* archive;
+			const ArchiveEntry* entry;
+			{
+				std::lock_guard<std::mutex> lock(m_assetMutex);
+				archive = findArchived(AssetUUID::CreateAssetUUID(path), entry);
+			}
+			if (!archive || archive->assetPath(*entry) != path) {
+				co_return false;
+			}
+			if (destination.size() != entry->size) {
+				throw std::logic_error("AssetManager: \"" + path + "\" needs " + std::to_string(entry->size) + " bytes to read into");
+			}
+			archive->willNeed(*entry);
+			if (!entry->compressed()) {
+				std::span<const uint8_t> data = archive->data(*entry);
+				std::copy(data.begin(), data.end(), destination.begin());
+				co_return true;
+			}
+			if (!co_await decompress(*archive, *entry, destination, classifyAsset(path))) {
+				throw std::runtime_error("AssetManager: \"" + path + "\" is corrupt in " + archive->path());
+			}
+			co_return true;
+		}
+
+		bool AssetManager::archivedSize(const std::string& path, uint64_t& size) {
+			std::lock_guard<std::mutex> lock(m_assetMutex);
+			const ArchiveEntry* entry;
+			const Archive* archive = findArchived(AssetUUID::CreateAssetUUID(path), entry);
+			if (!archive || archive->assetPath(*entry) != path) {
+				return false;
+			}
+			size = entry->size;
+			return true;
+		}
+
+		DecompressionStats AssetManager::decompressionStats() const {
+			DecompressionStats stats;
+			for (size_t i = 0; i < ASSET_CLASS_COUNT; i++) {
+				stats.assets[i] = m_decompressedAssets[i].load(std::memory_order_relaxed);
+				stats.compressedBytes[i] = m_compressedBytes[i].load(std::memory_order_relaxed);
+				stats.decompressedBytes[i] = m_decompressedBytes[i].load(std::memory_order_relaxed);
+				stats.nanoseconds[i] = m_decompressionNanoseconds[i].load(std::memory_order_relaxed);
+			}
+			return stats;
+		}
+
+		WorkForce::Task<void> AssetManager::inflate(Asset& asset) {
+			bool decompressed = co_await decompress(*asset.m_archive, *asset.m_archiveEntry, asset.m_data, asset.m_class);
+			if (!decompressed) {
+				// Nothing else touches the asset until it is loaded, as with a failed read
+				asset.m_failed = true;
+				asset.m_data.clear();
+				asset.m_data.shrink_to_fit();
+				asset.m_residentCounter->fetch_sub(asset.m_residentSize, std::memory_order_relaxed);
+				asset.m_residentSize = 0;
+			}
+			asset.m_view = asset.m_data;
+			asset.m_loaded.set();
+			finishTask();
+		}
+
+		WorkForce::Task<bool> AssetManager::decompress(const Archive& archive, const ArchiveEntry& entry, std::span<uint8_t> destination,
+				AssetClass assetClass) {
+			auto start = std::chrono::steady_clock::now();
+			std::atomic<bool> corrupt(false);
+			// One block per index. Blocks are big enough that splitting them further would cost more than it saves.
+			co_await WorkForce::parallelForAsync(m_pool, WorkForce::Range{ 0, archive.blockCount(entry) }, 1, [&](size_t block) {
+				if (!archive.decompressBlock(entry, block, destination)) {
+					corrupt.store(true, std::memory_order_relaxed);
+				}
+			});
+			if (corrupt.load(std::memory_order_relaxed)) {
+				co_return false;
+			}
+
+			size_t index = static_cast<size_t>(assetClass);
+			auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+			m_decompressedAssets[index].fetch_add(1, std::memory_order_relaxed);
+			m_compressedBytes[index].fetch_add(entry.storedSize, std::memory_order_relaxed);
+			m_decompressedBytes[index].fetch_add(entry.size, std::memory_order_relaxed);
+			m_decompressionNanoseconds[index].fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+			co_return true;
+		}
+
+		void AssetManager::beginTasks(size_t count) {
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			m_tasksRunning += count;
+		}
+
+		void AssetManager::finishTask() {
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			m_tasksRunning--;
+			m_taskCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#include "Atlas/AssetResidencyJob.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		AssetResidencyJob::AssetResidencyJob(AssetManager& assetManager)
+			: AssetUpdateJob(assetManager) {}
+
+		AssetResidencyJob::~AssetResidencyJob() {}
+
+		WorkForce::Task<void> AssetResidencyJob::executeAsync(WorkForce::JobContext& context) {
+			m_assetManager.updateResidency(context.frame());
+			co_return;
+		}
+	}
+}
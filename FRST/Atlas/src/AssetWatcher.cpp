@@ -0,0 +1,168 @@
+#include "Atlas/AssetWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// Creating a directory only matters for watching it, files are reported once they have been written.
+			// Moving one away only matters for dropping the watches below it.
+			constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE;
+		}
+
+		AssetWatcher::AssetWatcher(const std::string& directory, std::function<void(const std::vector<std::string>&)> onChange,
+				std::chrono::milliseconds settleTime)
+			: m_directory(directory)
+			, m_onChange(std::move(onChange))
+			, m_settleTime(settleTime)
+			, m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+			, m_wake(eventfd(0, EFD_CLOEXEC)) {
+			if (m_inotify < 0 || m_wake < 0) {
+				if (m_inotify >= 0) {
+					close(m_inotify);
+				}
+				if (m_wake >= 0) {
+					close(m_wake);
+				}
+				throw std::runtime_error("AssetWatcher: inotify is not available");
+			}
+			try {
+				watchTree("", nullptr);
+			} catch (...) {
+				close(m_inotify);
+				close(m_wake);
+				throw;
+			}
+			m_thread = std::thread(&AssetWatcher::run, this);
+		}
+
+		AssetWatcher::~AssetWatcher() {
+			uint64_t one = 1;
+			while (write(m_wake, &one, sizeof(one)) < 0 && errno == EINTR) {}
+			m_thread.join();
+			close(m_inotify);
+			close(m_wake);
+		}
+
+		void AssetWatcher::watchTree(const std::string& relative, std::vector<std::string>* changed) {
+			std::filesystem::path root(m_directory);
+			std::filesystem::path path = relative.empty() ? root : root / relative;
+			int watch = inotify_add_watch(m_inotify, path.c_str(), WATCH_MASK | IN_ONLYDIR);
+			if (watch < 0) {
+				if (relative.empty()) {
+					throw std::runtime_error("AssetWatcher: cannot watch " + m_directory);
+				}
+				// Already gone again
+				return;
+			}
+			m_watches[watch] = relative.empty() ? relative : relative + "/";
+
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(path, error)) {
+				std::string child = std::filesystem::relative(entry.path(), root).generic_string();
+				if (entry.is_directory(error)) {
+					watchTree(child, changed);
+				} else if (changed) {
+					// Written before the watch was in place, so no event will come for it
+					changed->push_back(std::move(child));
+				}
+			}
+		}
+
+		void AssetWatcher::unwatchTree(const std::string& relative) {
+			std::string prefix = relative.empty() ? relative : relative + "/";
+			for (auto watch = m_watches.begin(); watch != m_watches.end();) {
+				if (watch->second.compare(0, prefix.size(), prefix) == 0) {
+					// The IN_IGNORED this causes finds nothing left to erase
+					inotify_rm_watch(m_inotify, watch->first);
+					watch = m_watches.erase(watch);
+				} else {
+					++watch;
+				}
+			}
+		}
+
+		void AssetWatcher::run() {
+			using Clock = std::chrono::steady_clock;
+			std::vector<std::string> changed;
+			Clock::time_point settled;
+			alignas(inotify_event) char buffer[16 * 1024];
+
+			while (true) {
+				int timeout = -1;
+				if (!changed.empty()) {
+					auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(settled - Clock::now());
+					timeout = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+				}
+				pollfd fds[2] = { { m_inotify, POLLIN, 0 }, { m_wake, POLLIN, 0 } };
+				int ready = poll(fds, 2, timeout);
+				if (ready < 0 && errno != EINTR) {
+					return;
+				}
+				if (fds[1].revents & POLLIN) {
+					return;
+				}
+
+				if (fds[0].revents & POLLIN) {
+					ssize_t length;
+					while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+						for (char* next = buffer; next < buffer + length;) {
+							const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+							next += sizeof(inotify_event) + event->len;
+
+							if (event->mask & IN_Q_OVERFLOW) {
+								// Events were lost, so anything may have changed and directories may have moved
+								unwatchTree("");
+								try {
+									watchTree("", &changed);
+								} catch (const std::runtime_error&) {
+									// The directory itself is gone, so there is nothing left to watch
+									return;
+								}
+								continue;
+							}
+							auto watch = m_watches.find(event->wd);
+							if (event->mask & IN_IGNORED) {
+								if (watch != m_watches.end()) {
+									m_watches.erase(watch);
+								}
+								continue;
+							}
+							if (watch == m_watches.end() || event->len == 0) {
+								continue;
+							}
+							std::string path = watch->second + event->name;
+							if (event->mask & IN_ISDIR) {
+								if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+									watchTree(path, &changed);
+								} else if (event->mask & IN_MOVED_FROM) {
+									// Its watches would keep reporting under the old path. Moved within the tree,
+									// it is watched again from the IN_MOVED_TO.
+									unwatchTree(path);
+								}
+							} else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+								changed.push_back(std::move(path));
+							}
+						}
+					}
+					settled = Clock::now() + m_settleTime;
+				}
+
+				if (!changed.empty() && Clock::now() >= settled) {
+					std::sort(changed.begin(), changed.end());
+					changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+					m_onChange(changed);
+					changed.clear();
+				}
+			}
+		}
+	}
+}
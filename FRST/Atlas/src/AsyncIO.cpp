@@ -0,0 +1,508 @@
+#include "Atlas/AsyncIO.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
+namespace FRST {
+	namespace Atlas {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+		/*
+		 * A minimal io_uring, set up with raw syscalls so that liburing is not needed.
+		 * Only the I/O thread touches it, so the submission side needs no synchronization with other threads.
+		 */
+		class IoUring {
+		public:
+			// User data that marks the completions which are not reads
+			static const uint64_t WAKE_TAG = 1;
+			static const uint64_t CANCEL_TAG = 2;
+
+			// Returns nullptr if io_uring cannot be used here
+			static std::unique_ptr<IoUring> create(uint32_t entries) {
+				std::unique_ptr<IoUring> ring(new IoUring());
+				if (!ring->setup(entries)) {
+					return nullptr;
+				}
+				return ring;
+			}
+
+			~IoUring() {
+				if (m_sqes) {
+					munmap(m_sqes, m_sqesSize);
+				}
+				if (m_cqRing && m_cqRing != m_sqRing) {
+					munmap(m_cqRing, m_cqRingSize);
+				}
+				if (m_sqRing) {
+					munmap(m_sqRing, m_sqRingSize);
+				}
+				if (m_wakeFd >= 0) {
+					close(m_wakeFd);
+				}
+				if (m_fd >= 0) {
+					close(m_fd);
+				}
+			}
+
+			uint32_t capacity() const { return m_sqEntries; }
+
+			// Entries that can be prepared before the kernel has to consume some. Only grows until the next prepare.
+			uint32_t space() const {
+				uint32_t head = std::atomic_ref<uint32_t>(*m_sqHead).load(std::memory_order_acquire);
+				uint32_t tail = std::atomic_ref<uint32_t>(*m_sqTail).load(std::memory_order_relaxed);
+				return m_sqEntries - (tail - head);
+			}
+
+			// Wake the thread sleeping in wait()
+			void wake() {
+				uint64_t one = 1;
+				ssize_t written = write(m_wakeFd, &one, sizeof(one));
+				(void)written;
+			}
+
+			void prepareRead(IORequest* request) {
+				io_uring_sqe& sqe = nextSqe();
+				sqe.opcode = IORING_OP_READ;
+				sqe.fd = request->fd;
+				sqe.off = request->offset;
+				sqe.addr = reinterpret_cast<uint64_t>(request->buffer);
+				sqe.len = request->size;
+				sqe.user_data = reinterpret_cast<uint64_t>(request);
+			}
+
+			void prepareCancel(IORequest* request) {
+				io_uring_sqe& sqe = nextSqe();
+				sqe.opcode = IORING_OP_ASYNC_CANCEL;
+				sqe.fd = -1;
+				sqe.addr = reinterpret_cast<uint64_t>(request);
+				sqe.user_data = CANCEL_TAG;
+			}
+
+			/*
+			 * Submit everything prepared and sleep until at least one completion (or a wakeup) arrives.
+			 * Returns early, leaving the rest prepared, while the kernel holds back completions the CQ ring had no
+			 * room for (EBUSY); they only come through once the caller reaps, and retrying first would spin forever.
+			 */
+			void submitAndWait() {
+				if (!m_wakeArmed && space() > 0) {
+					io_uring_sqe& sqe = nextSqe();
+					sqe.opcode = IORING_OP_POLL_ADD;
+					sqe.fd = m_wakeFd;
+					sqe.poll_events = POLLIN;
+					sqe.user_data = WAKE_TAG;
+					m_wakeArmed = true;
+				}
+
+				while (true) {
+					long submitted = syscall(__NR_io_uring_enter, m_fd, m_prepared, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+					if (submitted >= 0) {
+						m_prepared -= std::min<uint32_t>(m_prepared, static_cast<uint32_t>(submitted));
+						if (m_prepared == 0) {
+							return;
+						}
+					} else if (errno == EBUSY || errno == EAGAIN) {
+						return;
+					} else if (errno != EINTR) {
+						m_prepared = 0;
+						return;
+					}
+				}
+			}
+
+			// Call function(userData, result) for every completion
+			template<class Function>
+			void reap(Function&& function) {
+				std::atomic_ref<uint32_t> headRef(*m_cqHead);
+				std::atomic_ref<uint32_t> tailRef(*m_cqTail);
+				uint32_t head = headRef.load(std::memory_order_relaxed);
+				uint32_t tail = tailRef.load(std::memory_order_acquire);
+				while (head != tail) {
+					const io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+					uint64_t userData = cqe.user_data;
+					int32_t result = cqe.res;
+					head++;
+					headRef.store(head, std::memory_order_release);
+
+					if (userData == WAKE_TAG) {
+						uint64_t count;
+						ssize_t readBytes = read(m_wakeFd, &count, sizeof(count));
+						(void)readBytes;
+						m_wakeArmed = false;
+					} else if (userData != CANCEL_TAG) {
+						function(userData, result);
+					}
+					tail = tailRef.load(std::memory_order_acquire);
+				}
+			}
+
+		private:
+			IoUring()
+				: m_fd(-1)
+				, m_wakeFd(-1)
+				, m_sqRing(nullptr)
+				, m_cqRing(nullptr)
+				, m_sqes(nullptr)
+				, m_sqRingSize(0)
+				, m_cqRingSize(0)
+				, m_sqesSize(0)
+				, m_sqEntries(0)
+				, m_prepared(0)
+				, m_wakeArmed(false) {}
+
+			bool setup(uint32_t entries) {
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+				m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+				if (m_fd < 0) {
+					return false;
+				}
+				// IORING_OP_READ arrived with RW_CUR_POS (5.6), and NODROP means completions are never lost
+				if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_RW_CUR_POS)) {
+					return false;
+				}
+
+				m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+				m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+				if (singleMap) {
+					m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+				}
+
+				m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+				if (m_sqRing == MAP_FAILED) {
+					m_sqRing = nullptr;
+					return false;
+				}
+				if (singleMap) {
+					m_cqRing = m_sqRing;
+				} else {
+					m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+					if (m_cqRing == MAP_FAILED) {
+						m_cqRing = nullptr;
+						return false;
+					}
+				}
+				m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+				if (sqes == MAP_FAILED) {
+					return false;
+				}
+				m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+				char* sq = static_cast<char*>(m_sqRing);
+				m_sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+				m_sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+				m_sqMask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+				m_sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+				char* cq = static_cast<char*>(m_cqRing);
+				m_cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+				m_cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+				m_cqMask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+				m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+				m_sqEntries = params.sq_entries;
+
+				m_wakeFd = eventfd(0, EFD_CLOEXEC);
+				return m_wakeFd >= 0;
+			}
+
+			// Callers check space() first, as the entry past the kernel's head is still being read
+			io_uring_sqe& nextSqe() {
+				if (space() == 0) {
+					throw std::logic_error("IoUring: the submission queue is full");
+				}
+				std::atomic_ref<uint32_t> tailRef(*m_sqTail);
+				uint32_t tail = tailRef.load(std::memory_order_relaxed);
+				uint32_t index = tail & *m_sqMask;
+				io_uring_sqe& sqe = m_sqes[index];
+				std::memset(&sqe, 0, sizeof(sqe));
+				m_sqArray[index] = index;
+				// The kernel only reads the entry once it sees the new tail
+				tailRef.store(tail + 1, std::memory_order_release);
+				m_prepared++;
+				return sqe;
+			}
+
+			int m_fd;
+			int m_wakeFd;
+			void* m_sqRing;
+			void* m_cqRing;
+			io_uring_sqe* m_sqes;
+			size_t m_sqRingSize;
+			size_t m_cqRingSize;
+			size_t m_sqesSize;
+			uint32_t m_sqEntries;
+
+			uint32_t* m_sqHead;
+			uint32_t* m_sqTail;
+			uint32_t* m_sqMask;
+			uint32_t* m_sqArray;
+			uint32_t* m_cqHead;
+			uint32_t* m_cqTail;
+			uint32_t* m_cqMask;
+			io_uring_cqe* m_cqes;
+
+			// Entries written since the last submit
+			uint32_t m_prepared;
+			// Whether a poll on m_wakeFd is in the ring
+			bool m_wakeArmed;
+		};
+#else
+		class IoUring {
+		public:
+			static const uint64_t WAKE_TAG = 1;
+			static const uint64_t CANCEL_TAG = 2;
+
+			static std::unique_ptr<IoUring> create(uint32_t) { return nullptr; }
+
+			uint32_t capacity() const { return 0; }
+			uint32_t space() const { return 0; }
+			void wake() {}
+			void prepareRead(IORequest*) {}
+			void prepareCancel(IORequest*) {}
+			void submitAndWait() {}
+			template<class Function>
+			void reap(Function&&) {}
+		};
+#endif
+
+		AsyncIO::AsyncIO(WorkForce::WorkerPool& pool, const AsyncIOConfig& config)
+			: m_pool(pool)
+			, m_config(config)
+			, m_numInFlight(0)
+			, m_stopping(false)
+			, m_ringWaiting(false)
+			, m_ring()
+			, m_threads() {
+			if (!m_config.disableIoUring) {
+				// Room for a full queue of reads, plus cancels and the wakeup poll
+				m_ring = IoUring::create(std::max(1u, m_config.queueDepth) * 2 + 8);
+			}
+
+			if (m_ring) {
+				m_threads.emplace_back(&AsyncIO::runRing, this);
+			} else {
+				for (size_t i = 0; i < std::max<size_t>(1, m_config.fallbackThreads); i++) {
+					m_threads.emplace_back(&AsyncIO::runFallback, this);
+				}
+			}
+		}
+
+		AsyncIO::~AsyncIO() {
+			std::vector<IORequest*> cancelled;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+				while (IORequest* request = takeQueued()) {
+					cancelled.push_back(request);
+				}
+			}
+			for (IORequest* request : cancelled) {
+				finish(request, -ECANCELED);
+			}
+
+			m_condition.notify_all();
+			wakeRing();
+			for (std::thread& thread : m_threads) {
+				thread.join();
+			}
+		}
+
+		void AsyncIO::submit(IORequest* request) {
+			submit(&request, 1);
+		}
+
+		void AsyncIO::submit(IORequest* const* requests, size_t count) {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				for (size_t i = 0; i < count; i++) {
+					requests[i]->m_state = IORequest::State::Queued;
+					requests[i]->m_cancelling = false;
+					m_queued[static_cast<size_t>(requests[i]->priority)].push_back(requests[i]);
+				}
+			}
+			if (m_ring) {
+				wakeRing();
+			} else if (count == 1) {
+				m_condition.notify_one();
+			} else {
+				m_condition.notify_all();
+			}
+		}
+
+		bool AsyncIO::cancel(IORequest* request) {
+			bool wasQueued;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				wasQueued = request->m_state == IORequest::State::Queued;
+				if (wasQueued) {
+					auto& queue = m_queued[static_cast<size_t>(request->priority)];
+					queue.erase(std::find(queue.begin(), queue.end(), request));
+					request->m_state = IORequest::State::Done;
+				} else if (request->m_state == IORequest::State::InFlight && m_ring) {
+					if (request->m_cancelling) {
+						// Already asked to stop
+						return true;
+					}
+					request->m_cancelling = true;
+					m_toCancel.push_back(request);
+				} else {
+					return false;
+				}
+			}
+
+			if (wasQueued) {
+				// It was never started, so nothing else will complete it
+				request->result = -ECANCELED;
+				if (request->completion) {
+					m_pool.submit(request->completion, request->priority);
+				}
+			} else {
+				wakeRing();
+			}
+			return true;
+		}
+
+		IORequest* AsyncIO::takeQueued() {
+			for (auto& queue : m_queued) {
+				if (!queue.empty()) {
+					IORequest* request = queue.front();
+					queue.pop_front();
+					return request;
+				}
+			}
+			return nullptr;
+		}
+
+		void AsyncIO::finish(IORequest* request, int64_t result) {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (request->m_state == IORequest::State::InFlight) {
+					m_numInFlight--;
+				}
+				request->m_state = IORequest::State::Done;
+			}
+			request->result = result;
+			if (request->completion) {
+				m_pool.submit(request->completion, request->priority);
+			}
+		}
+
+		void AsyncIO::wakeRing() {
+			if (!m_ring) {
+				return;
+			}
+			bool waiting;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				waiting = m_ringWaiting;
+				m_ringWaiting = false;
+			}
+			if (waiting) {
+				m_ring->wake();
+			}
+		}
+
+		void AsyncIO::runRing() {
+			std::vector<IORequest*> reads;
+			std::vector<IORequest*> cancels;
+			while (true) {
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (m_stopping && m_numInFlight == 0) {
+						return;
+					}
+
+					// Only prepare what fits next to entries the kernel has yet to take, keeping one for the wakeup poll
+					uint32_t room = m_ring->space();
+					room = room > 0 ? room - 1 : 0;
+
+					// Cancels first, as they make room. Any that do not fit wait for the next round.
+					size_t handled = 0;
+					for (; handled < m_toCancel.size() && cancels.size() < room; handled++) {
+						if (m_toCancel[handled]->m_state == IORequest::State::InFlight) {
+							cancels.push_back(m_toCancel[handled]);
+						}
+					}
+					m_toCancel.erase(m_toCancel.begin(), m_toCancel.begin() + handled);
+					room -= static_cast<uint32_t>(cancels.size());
+
+					// Fill the queue depth, most urgent first
+					while (m_numInFlight < m_config.queueDepth && reads.size() < room) {
+						IORequest* request = takeQueued();
+						if (!request) {
+							break;
+						}
+						request->m_state = IORequest::State::InFlight;
+						m_numInFlight++;
+						reads.push_back(request);
+					}
+
+					// From here on, anything new must wake us up
+					m_ringWaiting = true;
+				}
+
+				for (IORequest* request : reads) {
+					m_ring->prepareRead(request);
+				}
+				for (IORequest* request : cancels) {
+					m_ring->prepareCancel(request);
+				}
+				reads.clear();
+				cancels.clear();
+
+				m_ring->submitAndWait();
+				m_ring->reap([this](uint64_t userData, int32_t result) {
+					finish(reinterpret_cast<IORequest*>(userData), result);
+				});
+			}
+		}
+
+		void AsyncIO::runFallback() {
+			while (true) {
+				IORequest* request;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_condition.wait(lock, [this] {
+						return m_stopping || !m_queued[0].empty() || !m_queued[1].empty() || !m_queued[2].empty();
+					});
+					request = takeQueued();
+					if (!request) {
+						return;
+					}
+					request->m_state = IORequest::State::InFlight;
+					m_numInFlight++;
+				}
+
+				// Keep reading until the request is full or the file ends, like a single io_uring read of a regular file
+				int64_t total = 0;
+				while (total < request->size) {
+					ssize_t result = pread(request->fd, static_cast<char*>(request->buffer) + total,
+						request->size - total, static_cast<off_t>(request->offset + total));
+					if (result < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						total = -errno;
+						break;
+					}
+					if (result == 0) {
+						break;
+					}
+					total += result;
+				}
+				finish(request, total);
+			}
+		}
+	}
+}
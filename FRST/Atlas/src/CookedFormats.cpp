@@ -0,0 +1,80 @@
+#include "Atlas/CookedFormats.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// Whether [offset, offset + size) is inside data and suitably aligned for T
+			template<class T>
+			bool fits(std::span<const uint8_t> data, uint64_t offset, uint64_t count) {
+				return offset % alignof(T) == 0 && offset <= data.size() && count <= (data.size() - offset) / sizeof(T);
+			}
+		}
+
+		TextureView::TextureView(std::span<const uint8_t> data)
+			: m_data(data)
+			, m_header(reinterpret_cast<const CookedTextureHeader*>(data.data()))
+			, m_mips(reinterpret_cast<const CookedMip*>(data.data() + sizeof(CookedTextureHeader))) {
+			if (!fits<CookedTextureHeader>(data, 0, 1) || std::memcmp(m_header->magic, CookedTextureHeader::MAGIC, 4) != 0
+					|| m_header->version != CookedTextureHeader::VERSION) {
+				throw std::runtime_error("TextureView: not a cooked texture");
+			}
+			if (!fits<CookedMip>(data, sizeof(CookedTextureHeader), m_header->mipCount)) {
+				throw std::runtime_error("TextureView: truncated mip table");
+			}
+			for (uint32_t level = 0; level < m_header->mipCount; level++) {
+				const CookedMip& mip = m_mips[level];
+				if (!fits<uint8_t>(data, mip.offset, mip.size) || mip.size != textureMipSize(m_header->format, mip.width, mip.height)) {
+					throw std::runtime_error("TextureView: mip outside the texture");
+				}
+			}
+		}
+
+		MeshView::MeshView(std::span<const uint8_t> data)
+			: m_header(reinterpret_cast<const CookedMeshHeader*>(data.data())) {
+			if (!fits<CookedMeshHeader>(data, 0, 1) || std::memcmp(m_header->magic, CookedMeshHeader::MAGIC, 4) != 0
+					|| m_header->version != CookedMeshHeader::VERSION) {
+				throw std::runtime_error("MeshView: not a cooked mesh");
+			}
+			if (!fits<MeshVertex>(data, m_header->vertexOffset, m_header->vertexCount)
+					|| !fits<uint32_t>(data, m_header->indexOffset, m_header->indexCount)) {
+				throw std::runtime_error("MeshView: truncated mesh");
+			}
+			if (!fits<CookedMeshlet>(data, m_header->meshletOffset, m_header->meshletCount)
+					|| !fits<uint32_t>(data, m_header->meshletVertexOffset, m_header->meshletVertexCount)
+					|| !fits<uint8_t>(data, m_header->meshletTriangleOffset, m_header->meshletTriangleSize)) {
+				throw std::runtime_error("MeshView: truncated meshlets");
+			}
+			m_vertices = { reinterpret_cast<const MeshVertex*>(data.data() + m_header->vertexOffset), m_header->vertexCount };
+			m_indices = { reinterpret_cast<const uint32_t*>(data.data() + m_header->indexOffset), m_header->indexCount };
+			m_meshlets = { reinterpret_cast<const CookedMeshlet*>(data.data() + m_header->meshletOffset), m_header->meshletCount };
+			m_meshletVertices = { reinterpret_cast<const uint32_t*>(data.data() + m_header->meshletVertexOffset), m_header->meshletVertexCount };
+			m_meshletTriangles = { data.data() + m_header->meshletTriangleOffset, m_header->meshletTriangleSize };
+			for (const CookedMeshlet& meshlet : m_meshlets) {
+				if (meshlet.vertexCount > CookedMeshlet::MAX_VERTICES || meshlet.triangleCount > CookedMeshlet::MAX_TRIANGLES
+						|| meshlet.vertexOffset > m_meshletVertices.size() || meshlet.vertexCount > m_meshletVertices.size() - meshlet.vertexOffset
+						|| meshlet.triangleOffset > m_meshletTriangles.size() || meshlet.triangleCount * 3 > m_meshletTriangles.size() - meshlet.triangleOffset) {
+					throw std::runtime_error("MeshView: meshlet outside the mesh");
+				}
+			}
+		}
+
+		uint64_t textureMipSize(TextureFormat format, uint32_t width, uint32_t height) {
+			uint64_t blocks = uint64_t((width + 3) / 4) * ((height + 3) / 4);
+			switch (format) {
+			case TextureFormat::RGBA8:
+				return uint64_t(width) * height * 4;
+			case TextureFormat::BC1:
+			case TextureFormat::BC4:
+				return blocks * 8;
+			case TextureFormat::BC3:
+			case TextureFormat::BC5:
+			case TextureFormat::BC7:
+				return blocks * 16;
+			}
+			return 0;
+		}
+	}
+}
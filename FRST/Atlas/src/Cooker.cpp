@@ -0,0 +1,383 @@
+#include "Atlas/Cooker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "Atlas/ArchiveWriter.hpp"
+#include "Atlas/ContentHash.hpp"
+#include "Atlas/MeshCooker.hpp"
+#include "Atlas/ShaderCooker.hpp"
+#include "Atlas/TextureCooker.hpp"
+#include "WorkForce/Parallel.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		std::vector<uint8_t> readFile(const std::string& path) {
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file) {
+				throw std::runtime_error("cannot open " + path);
+			}
+			std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!file) {
+				throw std::runtime_error("cannot read " + path);
+			}
+			return data;
+		}
+
+		void writeFile(const std::string& path, std::span<const uint8_t> data) {
+			// Write beside the file and rename over it, so that nothing ever sees a partly written file,
+			// even with several writers at once
+			static std::atomic<uint64_t> s_counter(0);
+			std::string temporary = path + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(s_counter.fetch_add(1));
+			{
+				std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+				file.close();
+				if (!file) {
+					std::remove(temporary.c_str());
+					throw std::runtime_error("cannot write " + path);
+				}
+			}
+			std::error_code error;
+			std::filesystem::rename(temporary, path, error);
+			if (error) {
+				std::remove(temporary.c_str());
+				throw std::runtime_error("cannot write " + path + ": " + error.message());
+			}
+		}
+
+		namespace {
+			/*
+			 * Cache entries hold the dependencies the result was cooked from ahead of the result itself:
+			 *   uint32 magic, uint32 dependency count
+			 *   per dependency: uint64 content hash, uint32 path length, path
+			 *   the cooked bytes
+			 */
+			constexpr uint32_t CACHE_RECORD_MAGIC = 0x314b4346; // "FCK1"
+
+			using HashedDependencies = std::vector<std::pair<std::string, uint64_t>>;
+
+			template<class T>
+			void append(std::vector<uint8_t>& out, const T& value) {
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+				out.insert(out.end(), bytes, bytes + sizeof(T));
+			}
+
+			template<class T>
+			bool take(std::span<const uint8_t>& in, T& value) {
+				if (in.size() < sizeof(T)) {
+					return false;
+				}
+				std::memcpy(&value, in.data(), sizeof(T));
+				in = in.subspan(sizeof(T));
+				return true;
+			}
+
+			std::vector<uint8_t> packRecord(const HashedDependencies& dependencies, std::span<const uint8_t> cooked) {
+				std::vector<uint8_t> record;
+				append(record, CACHE_RECORD_MAGIC);
+				append(record, static_cast<uint32_t>(dependencies.size()));
+				for (const auto& dependency : dependencies) {
+					append(record, dependency.second);
+					append(record, static_cast<uint32_t>(dependency.first.size()));
+					record.insert(record.end(), dependency.first.begin(), dependency.first.end());
+				}
+				record.insert(record.end(), cooked.begin(), cooked.end());
+				return record;
+			}
+
+			// Returns false for anything that is not a whole record, eg. one written by an older Cooker
+			bool unpackRecord(std::span<const uint8_t> record, HashedDependencies& dependencies, std::vector<uint8_t>& cooked) {
+				uint32_t magic = 0;
+				uint32_t count = 0;
+				if (!take(record, magic) || magic != CACHE_RECORD_MAGIC || !take(record, count)) {
+					return false;
+				}
+				dependencies.clear();
+				for (uint32_t i = 0; i < count; i++) {
+					uint64_t hash = 0;
+					uint32_t length = 0;
+					if (!take(record, hash) || !take(record, length) || record.size() < length) {
+						return false;
+					}
+					dependencies.emplace_back(std::string(reinterpret_cast<const char*>(record.data()), length), hash);
+					record = record.subspan(length);
+				}
+				cooked.assign(record.begin(), record.end());
+				return true;
+			}
+
+			// Where the remembered dependencies are kept, between runs
+			std::string dependenciesFile(const CookerConfig& config) {
+				return (std::filesystem::path(config.cacheDirectory) / "dependencies").string();
+			}
+		}
+
+		CookCache::CookCache(const std::string& directory)
+			: m_directory(directory) {}
+
+		bool CookCache::load(uint64_t key, std::vector<uint8_t>& data) const {
+			try {
+				data = readFile(pathFor(key));
+				return true;
+			} catch (const std::runtime_error&) {
+				return false;
+			}
+		}
+
+		void CookCache::store(uint64_t key, std::span<const uint8_t> data) const {
+			std::filesystem::create_directories(m_directory);
+			writeFile(pathFor(key), data);
+		}
+
+		std::string CookCache::pathFor(uint64_t key) const {
+			char name[17];
+			std::snprintf(name, sizeof(name), "%016" PRIx64, key);
+			return (std::filesystem::path(m_directory) / name).string();
+		}
+
+		Cooker::Cooker(WorkForce::WorkerPool& pool, const CookerConfig& config)
+			: m_pool(pool)
+			, m_config(config)
+			, m_cache(config.cacheDirectory) {
+			loadDependencies();
+		}
+
+		Cooker::~Cooker() {}
+
+		void Cooker::addCooker(std::unique_ptr<AssetCooker> cooker) {
+			m_cookers.push_back(std::move(cooker));
+		}
+
+		void Cooker::addDefaultCookers(const std::string& shaderCompiler) {
+			addCooker(std::unique_ptr<AssetCooker>(new TextureCooker()));
+			addCooker(std::unique_ptr<AssetCooker>(new MeshCooker()));
+			addCooker(std::unique_ptr<AssetCooker>(new ShaderCooker(shaderCompiler)));
+		}
+
+		CookReport Cooker::cookAll() {
+			std::filesystem::path sourceDirectory(m_config.sourceDirectory);
+			std::vector<std::string> paths;
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(sourceDirectory)) {
+				if (entry.is_regular_file()) {
+					paths.push_back(std::filesystem::relative(entry.path(), sourceDirectory).generic_string());
+				}
+			}
+			// Sorted, so that archives come out the same every time
+			std::sort(paths.begin(), paths.end());
+
+			// Every source is about to say what it depends on again, and deleted ones should be forgotten
+			{
+				std::lock_guard<std::mutex> lock(m_dependencyMutex);
+				m_dependencies.clear();
+			}
+
+			CookReport report;
+			std::mutex reportMutex;
+			std::vector<std::vector<uint8_t>> archived(m_config.archivePath.empty() ? 0 : paths.size());
+
+			// One source per task. Sources vary wildly in cost, which the pool's stealing evens out.
+			WorkForce::parallelFor(m_pool, WorkForce::Range{ 0, paths.size() }, 1, [&](size_t index) {
+				const std::string& path = paths[index];
+				try {
+					bool fromCache = false;
+					std::vector<uint8_t> data = cook(path, fromCache);
+					writeOutput(path, data);
+
+					std::lock_guard<std::mutex> lock(reportMutex);
+					if (!findCooker(path)) {
+						report.copied++;
+					} else if (fromCache) {
+						report.cached++;
+					} else {
+						report.cooked++;
+					}
+					if (!archived.empty()) {
+						archived[index] = std::move(data);
+					}
+				} catch (const std::exception& e) {
+					std::lock_guard<std::mutex> lock(reportMutex);
+					report.errors.push_back(path + ": " + e.what());
+				}
+			});
+
+			if (!m_config.archivePath.empty() && report.errors.empty()) {
+				ArchiveWriter writer(m_config.archiveCompression);
+				for (size_t i = 0; i < paths.size(); i++) {
+					writer.add(paths[i], std::move(archived[i]));
+				}
+				std::filesystem::path archiveDirectory = std::filesystem::path(m_config.archivePath).parent_path();
+				if (!archiveDirectory.empty()) {
+					std::filesystem::create_directories(archiveDirectory);
+				}
+				writer.write(m_config.archivePath, &m_pool);
+			}
+			saveDependencies();
+			std::sort(report.errors.begin(), report.errors.end());
+			return report;
+		}
+
+		std::vector<uint8_t> Cooker::cook(const std::string& path, bool& fromCache) const {
+			std::string sourcePath = (std::filesystem::path(m_config.sourceDirectory) / path).string();
+			std::vector<uint8_t> source = readFile(sourcePath);
+			const AssetCooker* cooker = findCooker(path);
+			if (!cooker) {
+				fromCache = false;
+				setDependencies(path, {});
+				return source;
+			}
+
+			// Dependencies are not part of the key, as they are only known once cooked. Their hashes are checked instead.
+			uint64_t key = ContentHash().add(cooker->name()).add(uint64_t(cooker->version())).add(source).finish();
+			std::vector<uint8_t> record;
+			HashedDependencies hashed;
+			std::vector<uint8_t> cooked;
+			if (m_cache.load(key, record) && unpackRecord(record, hashed, cooked) && dependenciesMatch(hashed)) {
+				fromCache = true;
+			} else {
+				fromCache = false;
+				std::vector<std::string> dependencies;
+				cooked = cooker->cook(CookInput{ path, sourcePath, source, dependencies });
+
+				hashed.clear();
+				for (const std::string& dependency : dependencies) {
+					std::string relative = dependencyPath(dependency);
+					if (relative != path) {
+						hashed.emplace_back(relative, 0);
+					}
+				}
+				std::sort(hashed.begin(), hashed.end());
+				hashed.erase(std::unique(hashed.begin(), hashed.end()), hashed.end());
+				for (auto& dependency : hashed) {
+					std::filesystem::path onDisk(dependency.first);
+					if (onDisk.is_relative()) {
+						onDisk = std::filesystem::path(m_config.sourceDirectory) / onDisk;
+					}
+					dependency.second = ContentHash().add(readFile(onDisk.string())).finish();
+				}
+				m_cache.store(key, packRecord(hashed, cooked));
+			}
+
+			std::vector<std::string> dependencies;
+			for (auto& dependency : hashed) {
+				dependencies.push_back(std::move(dependency.first));
+			}
+			setDependencies(path, std::move(dependencies));
+			return cooked;
+		}
+
+		std::vector<std::string> Cooker::dependents(const std::string& source) const {
+			std::vector<std::string> assets;
+			std::lock_guard<std::mutex> lock(m_dependencyMutex);
+			for (const auto& asset : m_dependencies) {
+				if (std::find(asset.second.begin(), asset.second.end(), source) != asset.second.end()) {
+					assets.push_back(asset.first);
+				}
+			}
+			std::sort(assets.begin(), assets.end());
+			return assets;
+		}
+
+		std::string Cooker::dependencyPath(const std::string& path) const {
+			std::filesystem::path absolute = std::filesystem::weakly_canonical(path);
+			std::filesystem::path relative = absolute.lexically_relative(std::filesystem::weakly_canonical(m_config.sourceDirectory));
+			if (!relative.empty() && *relative.begin() != "..") {
+				return relative.generic_string();
+			}
+			return absolute.generic_string();
+		}
+
+		bool Cooker::dependenciesMatch(const HashedDependencies& dependencies) const {
+			for (const auto& dependency : dependencies) {
+				std::filesystem::path onDisk(dependency.first);
+				if (onDisk.is_relative()) {
+					onDisk = std::filesystem::path(m_config.sourceDirectory) / onDisk;
+				}
+				try {
+					if (ContentHash().add(readFile(onDisk.string())).finish() != dependency.second) {
+						return false;
+					}
+				} catch (const std::runtime_error&) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void Cooker::setDependencies(const std::string& path, std::vector<std::string> dependencies) const {
+			std::lock_guard<std::mutex> lock(m_dependencyMutex);
+			if (dependencies.empty()) {
+				m_dependencies.erase(path);
+			} else {
+				m_dependencies[path] = std::move(dependencies);
+			}
+		}
+
+		// One asset per line, followed by a tab indented line for each of its dependencies
+		void Cooker::loadDependencies() {
+			std::ifstream file(dependenciesFile(m_config));
+			std::string line;
+			std::vector<std::string>* dependencies = nullptr;
+			while (std::getline(file, line)) {
+				if (line.empty()) {
+					continue;
+				}
+				if (line[0] != '\t') {
+					dependencies = &m_dependencies[line];
+				} else if (dependencies) {
+					dependencies->push_back(line.substr(1));
+				}
+			}
+		}
+
+		void Cooker::saveDependencies() const {
+			std::ostringstream text;
+			{
+				std::lock_guard<std::mutex> lock(m_dependencyMutex);
+				std::vector<const std::string*> assets;
+				for (const auto& asset : m_dependencies) {
+					assets.push_back(&asset.first);
+				}
+				std::sort(assets.begin(), assets.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+				for (const std::string* asset : assets) {
+					text << *asset << '\n';
+					for (const std::string& dependency : m_dependencies.at(*asset)) {
+						text << '\t' << dependency << '\n';
+					}
+				}
+			}
+			std::string contents = text.str();
+			std::filesystem::create_directories(m_config.cacheDirectory);
+			writeFile(dependenciesFile(m_config), std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(contents.data()), contents.size()));
+		}
+
+		const AssetCooker* Cooker::findCooker(std::string_view path) const {
+			for (const auto& cooker : m_cookers) {
+				if (cooker->accepts(path)) {
+					return cooker.get();
+				}
+			}
+			return nullptr;
+		}
+
+		void Cooker::writeOutput(const std::string& path, std::span<const uint8_t> data) const {
+			if (m_config.outputDirectory.empty()) {
+				return;
+			}
+			std::filesystem::path output = std::filesystem::path(m_config.outputDirectory) / path;
+			std::filesystem::create_directories(output.parent_path());
+			writeFile(output.string(), data);
+		}
+	}
+}
@@ -0,0 +1,203 @@
+#include "Atlas/Lz4.hpp"
+
+#include <cstring>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// Matches are at least 4 bytes, and the format wants the last 5 bytes as literals,
+			// with no match starting in the last 12
+			constexpr size_t MIN_MATCH = 4;
+			constexpr size_t LAST_LITERALS = 5;
+			constexpr size_t MATCH_FIND_LIMIT = 12;
+			constexpr size_t MAX_OFFSET = 65535;
+			// 16KB of table, which stays in L1 while a block is compressed
+			constexpr int HASH_BITS = 12;
+
+			uint32_t read32(const uint8_t* bytes) {
+				uint32_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+
+			uint32_t hash(uint32_t sequence) {
+				return (sequence * 2654435761u) >> (32 - HASH_BITS);
+			}
+
+			// Writes sequences into the destination, failing once it is full
+			class SequenceWriter {
+			public:
+				explicit SequenceWriter(std::span<uint8_t> destination)
+					: m_out(destination.data())
+					, m_end(destination.data() + destination.size()) {}
+
+				size_t written(const uint8_t* begin) const { return static_cast<size_t>(m_out - begin); }
+
+				// A run of literals, followed by a match unless matchLength is 0
+				bool write(const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+					size_t needed = 1 + literalLength / 255 + 1 + literalLength + (matchLength ? 2 + matchLength / 255 + 1 : 0);
+					if (needed > static_cast<size_t>(m_end - m_out)) {
+						return false;
+					}
+					uint8_t* token = m_out++;
+					*token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+					writeLength(literalLength);
+					if (literalLength) {
+						std::memcpy(m_out, literals, literalLength);
+						m_out += literalLength;
+					}
+					if (matchLength) {
+						*m_out++ = static_cast<uint8_t>(offset);
+						*m_out++ = static_cast<uint8_t>(offset >> 8);
+						size_t length = matchLength - MIN_MATCH;
+						*token |= static_cast<uint8_t>(length < 15 ? length : 15);
+						writeLength(length);
+					}
+					return true;
+				}
+
+			private:
+				// The part of a length that does not fit into its 4 bits of the token
+				void writeLength(size_t length) {
+					if (length < 15) {
+						return;
+					}
+					for (length -= 15; length >= 255; length -= 255) {
+						*m_out++ = 255;
+					}
+					*m_out++ = static_cast<uint8_t>(length);
+				}
+
+				uint8_t* m_out;
+				uint8_t* const m_end;
+			};
+
+			// The rest of a length, after its 4 bits in the token
+			bool readLength(std::span<const uint8_t> source, size_t& position, size_t& length) {
+				uint8_t byte;
+				do {
+					if (position == source.size()) {
+						return false;
+					}
+					byte = source[position++];
+					length += byte;
+				} while (byte == 255);
+				return true;
+			}
+		}
+
+		size_t compressLz4(std::span<const uint8_t> source, std::span<uint8_t> destination) {
+			const uint8_t* input = source.data();
+			const size_t size = source.size();
+			SequenceWriter writer(destination);
+			size_t anchor = 0;
+
+			if (size > MATCH_FIND_LIMIT) {
+				uint32_t table[1 << HASH_BITS] = {};
+				const size_t matchEndLimit = size - LAST_LITERALS;
+				const size_t matchStartLimit = size - MATCH_FIND_LIMIT;
+				size_t position = 0;
+				while (position < matchStartLimit) {
+					uint32_t sequence = read32(input + position);
+					uint32_t& slot = table[hash(sequence)];
+					size_t candidate = slot;
+					slot = static_cast<uint32_t>(position);
+					if (candidate >= position || position - candidate > MAX_OFFSET || read32(input + candidate) != sequence) {
+						position++;
+						continue;
+					}
+
+					// Grow the match backwards into the pending literals, then forwards as far as it goes
+					while (position > anchor && candidate > 0 && input[position - 1] == input[candidate - 1]) {
+						position--;
+						candidate--;
+					}
+					size_t length = MIN_MATCH;
+					while (position + length < matchEndLimit && input[position + length] == input[candidate + length]) {
+						length++;
+					}
+					if (!writer.write(input + anchor, position - anchor, position - candidate, length)) {
+						return 0;
+					}
+					position += length;
+					anchor = position;
+					// Positions inside the match are skipped, but one near its end often starts the next match
+					if (position - 2 < matchStartLimit) {
+						table[hash(read32(input + position - 2))] = static_cast<uint32_t>(position - 2);
+					}
+				}
+			}
+
+			if (!writer.write(input + anchor, size - anchor, 0, 0)) {
+				return 0;
+			}
+			return writer.written(destination.data());
+		}
+
+		bool decompressLz4(std::span<const uint8_t> source, std::span<uint8_t> destination) {
+			uint8_t* output = destination.data();
+			const size_t outputSize = destination.size();
+			size_t in = 0;
+			size_t out = 0;
+			while (in < source.size()) {
+				uint8_t token = source[in++];
+
+				size_t literalLength = token >> 4;
+				if (literalLength == 15 && !readLength(source, in, literalLength)) {
+					return false;
+				}
+				if (literalLength <= 16 && source.size() - in >= 16 && outputSize - out >= 16) {
+					// Most runs are short, and a fixed size copy is a couple of instructions. Bytes past the run are
+					// overwritten by what follows it.
+					std::memcpy(output + out, source.data() + in, 16);
+				} else if (literalLength > source.size() - in || literalLength > outputSize - out) {
+					return false;
+				} else if (literalLength) {
+					std::memcpy(output + out, source.data() + in, literalLength);
+				}
+				in += literalLength;
+				out += literalLength;
+				if (in == source.size()) {
+					// The last sequence is only literals
+					return out == outputSize;
+				}
+
+				if (source.size() - in < 2) {
+					return false;
+				}
+				size_t offset = source[in] | (size_t(source[in + 1]) << 8);
+				in += 2;
+				size_t matchLength = token & 15;
+				if (matchLength == 15 && !readLength(source, in, matchLength)) {
+					return false;
+				}
+				matchLength += MIN_MATCH;
+				if (offset == 0 || offset > out || matchLength > outputSize - out) {
+					return false;
+				}
+
+				// Matches may overlap what they write, which repeats the last offset bytes
+				uint8_t* to = output + out;
+				const uint8_t* from = to - offset;
+				if (offset >= 8 && outputSize - out >= matchLength + 8) {
+					// Whole words, running up to 7 bytes past the match, which is safe with room left behind it
+					for (size_t i = 0; i < matchLength; i += 8) {
+						std::memcpy(to + i, from + i, 8);
+					}
+				} else if (offset >= matchLength) {
+					std::memcpy(to, from, matchLength);
+				} else if (offset >= 8) {
+					for (size_t i = 0; i < matchLength; i += 8) {
+						std::memcpy(to + i, from + i, matchLength - i < 8 ? matchLength - i : 8);
+					}
+				} else {
+					for (size_t i = 0; i < matchLength; i++) {
+						to[i] = from[i];
+					}
+				}
+				out += matchLength;
+			}
+			return false;
+		}
+	}
+}
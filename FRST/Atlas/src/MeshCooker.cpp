@@ -0,0 +1,231 @@
+#include "Atlas/MeshCooker.hpp"
+#include "Atlas/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			struct Corner {
+				int position;
+				int uv;
+				int normal;
+
+				bool operator==(const Corner& other) const {
+					return position == other.position && uv == other.uv && normal == other.normal;
+				}
+			};
+
+			struct CornerHash {
+				size_t operator()(const Corner& corner) const {
+					uint64_t hash = uint64_t(uint32_t(corner.position)) * 0x9e3779b97f4a7c15ull;
+					hash ^= uint64_t(uint32_t(corner.uv)) * 0xc2b2ae3d27d4eb4full + (hash >> 29);
+					hash ^= uint64_t(uint32_t(corner.normal)) * 0x165667b19e3779f9ull + (hash >> 32);
+					return static_cast<size_t>(hash);
+				}
+			};
+
+			// OBJ indices are 1 based, or negative to count back from the latest element
+			int resolveIndex(long index, size_t count, int line) {
+				long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+				if (index == 0 || resolved < 0 || resolved >= static_cast<long>(count)) {
+					throw std::runtime_error("OBJ line " + std::to_string(line) + ": index out of range");
+				}
+				return static_cast<int>(resolved);
+			}
+
+			// Parse a "v/vt/vn" corner. Missing parts are -1.
+			Corner parseCorner(const char*& cursor, size_t positions, size_t uvs, size_t normals, int line) {
+				Corner corner = { -1, -1, -1 };
+				char* end;
+				corner.position = resolveIndex(std::strtol(cursor, &end, 10), positions, line);
+				cursor = end;
+				if (*cursor == '/') {
+					cursor++;
+					if (*cursor != '/') {
+						corner.uv = resolveIndex(std::strtol(cursor, &end, 10), uvs, line);
+						cursor = end;
+					}
+					if (*cursor == '/') {
+						cursor++;
+						corner.normal = resolveIndex(std::strtol(cursor, &end, 10), normals, line);
+						cursor = end;
+					}
+				}
+				return corner;
+			}
+
+			void readFloats(const char* cursor, float* values, int count, int line) {
+				for (int i = 0; i < count; i++) {
+					char* end;
+					values[i] = std::strtof(cursor, &end);
+					if (end == cursor) {
+						throw std::runtime_error("OBJ line " + std::to_string(line) + ": expected a number");
+					}
+					cursor = end;
+				}
+			}
+		}
+
+		bool MeshCooker::accepts(std::string_view path) const {
+			return path.size() >= 4 && path.compare(path.size() - 4, 4, ".obj") == 0;
+		}
+
+		std::vector<uint8_t> MeshCooker::cook(const CookInput& input) const {
+			Mesh mesh = parseObj(input.source);
+			optimizeMesh(mesh);
+			return serializeMesh(mesh);
+		}
+
+		Mesh parseObj(std::span<const uint8_t> source) {
+			std::vector<float> positions;
+			std::vector<float> uvs;
+			std::vector<float> normals;
+			Mesh mesh;
+			std::unordered_map<Corner, uint32_t, CornerHash> cornerVertices;
+			bool missingNormals = false;
+
+			// strtol and friends need a terminator, so parse a copy one line at a time
+			std::string text(reinterpret_cast<const char*>(source.data()), source.size());
+			size_t lineStart = 0;
+			int lineNumber = 0;
+			std::vector<uint32_t> polygon;
+			while (lineStart < text.size()) {
+				size_t lineEnd = text.find('\n', lineStart);
+				if (lineEnd == std::string::npos) {
+					lineEnd = text.size();
+				}
+				if (lineEnd < text.size()) {
+					text[lineEnd] = '\0';
+				}
+				lineNumber++;
+				const char* line = &text[lineStart];
+				lineStart = lineEnd + 1;
+
+				while (*line == ' ' || *line == '\t') {
+					line++;
+				}
+				if (line[0] == 'v' && line[1] == ' ') {
+					float values[3];
+					readFloats(line + 2, values, 3, lineNumber);
+					positions.insert(positions.end(), values, values + 3);
+				} else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
+					float values[2];
+					readFloats(line + 3, values, 2, lineNumber);
+					uvs.insert(uvs.end(), values, values + 2);
+				} else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
+					float values[3];
+					readFloats(line + 3, values, 3, lineNumber);
+					normals.insert(normals.end(), values, values + 3);
+				} else if (line[0] == 'f' && line[1] == ' ') {
+					polygon.clear();
+					const char* cursor = line + 2;
+					for (;;) {
+						while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+							cursor++;
+						}
+						if (*cursor == '\0' || *cursor == '#') {
+							break;
+						}
+						Corner corner = parseCorner(cursor, positions.size() / 3, uvs.size() / 2, normals.size() / 3, lineNumber);
+						auto inserted = cornerVertices.emplace(corner, static_cast<uint32_t>(mesh.vertices.size()));
+						if (inserted.second) {
+							MeshVertex vertex = {};
+							std::memcpy(vertex.position, &positions[corner.position * 3], sizeof(vertex.position));
+							if (corner.uv >= 0) {
+								std::memcpy(vertex.uv, &uvs[corner.uv * 2], sizeof(vertex.uv));
+							}
+							if (corner.normal >= 0) {
+								std::memcpy(vertex.normal, &normals[corner.normal * 3], sizeof(vertex.normal));
+							} else {
+								missingNormals = true;
+							}
+							mesh.vertices.push_back(vertex);
+						}
+						polygon.push_back(inserted.first->second);
+					}
+					if (polygon.size() < 3) {
+						throw std::runtime_error("OBJ line " + std::to_string(lineNumber) + ": face with fewer than 3 corners");
+					}
+					for (size_t i = 1; i + 1 < polygon.size(); i++) {
+						mesh.indices.push_back(polygon[0]);
+						mesh.indices.push_back(polygon[i]);
+						mesh.indices.push_back(polygon[i + 1]);
+					}
+				}
+				// Everything else (objects, groups, materials, smoothing) does not affect the cooked mesh
+			}
+
+			if (missingNormals) {
+				// Area weighted face normals, summed into each vertex that has none
+				std::vector<float> generated(mesh.vertices.size() * 3, 0.0f);
+				for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+					const float* a = mesh.vertices[mesh.indices[i]].position;
+					const float* b = mesh.vertices[mesh.indices[i + 1]].position;
+					const float* c = mesh.vertices[mesh.indices[i + 2]].position;
+					float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+					float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+					float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+					for (size_t corner = 0; corner < 3; corner++) {
+						for (int k = 0; k < 3; k++) {
+							generated[mesh.indices[i + corner] * 3 + k] += normal[k];
+						}
+					}
+				}
+				for (const auto& entry : cornerVertices) {
+					if (entry.first.normal >= 0) {
+						continue;
+					}
+					float* normal = &generated[entry.second * 3];
+					float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+					for (int k = 0; k < 3; k++) {
+						mesh.vertices[entry.second].normal[k] = length > 0.0f ? normal[k] / length : 0.0f;
+					}
+				}
+			}
+			return mesh;
+		}
+
+		std::vector<uint8_t> serializeMesh(const Mesh& mesh) {
+			CookedMeshHeader header;
+			std::memcpy(header.magic, CookedMeshHeader::MAGIC, 4);
+			header.version = CookedMeshHeader::VERSION;
+			header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+			header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			for (int k = 0; k < 3; k++) {
+				header.boundsMin[k] = mesh.vertices.empty() ? 0.0f : INFINITY;
+				header.boundsMax[k] = mesh.vertices.empty() ? 0.0f : -INFINITY;
+			}
+			for (const MeshVertex& vertex : mesh.vertices) {
+				for (int k = 0; k < 3; k++) {
+					header.boundsMin[k] = std::min(header.boundsMin[k], vertex.position[k]);
+					header.boundsMax[k] = std::max(header.boundsMax[k], vertex.position[k]);
+				}
+			}
+			header.vertexOffset = (sizeof(CookedMeshHeader) + 15) & ~uint64_t(15);
+			header.indexOffset = (header.vertexOffset + sizeof(MeshVertex) * mesh.vertices.size() + 15) & ~uint64_t(15);
+			header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+			header.meshletVertexCount = static_cast<uint32_t>(mesh.meshletVertices.size());
+			header.meshletTriangleSize = static_cast<uint32_t>(mesh.meshletTriangles.size());
+			header.reserved = 0;
+			header.meshletOffset = (header.indexOffset + sizeof(uint32_t) * mesh.indices.size() + 15) & ~uint64_t(15);
+			header.meshletVertexOffset = (header.meshletOffset + sizeof(CookedMeshlet) * mesh.meshlets.size() + 15) & ~uint64_t(15);
+			header.meshletTriangleOffset = (header.meshletVertexOffset + sizeof(uint32_t) * mesh.meshletVertices.size() + 15) & ~uint64_t(15);
+
+			std::vector<uint8_t> out(header.meshletTriangleOffset + mesh.meshletTriangles.size(), 0);
+			std::memcpy(out.data(), &header, sizeof(header));
+			std::memcpy(out.data() + header.vertexOffset, mesh.vertices.data(), sizeof(MeshVertex) * mesh.vertices.size());
+			std::memcpy(out.data() + header.indexOffset, mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+			std::memcpy(out.data() + header.meshletOffset, mesh.meshlets.data(), sizeof(CookedMeshlet) * mesh.meshlets.size());
+			std::memcpy(out.data() + header.meshletVertexOffset, mesh.meshletVertices.data(), sizeof(uint32_t) * mesh.meshletVertices.size());
+			std::memcpy(out.data() + header.meshletTriangleOffset, mesh.meshletTriangles.data(), mesh.meshletTriangles.size());
+			return out;
+		}
+	}
+}
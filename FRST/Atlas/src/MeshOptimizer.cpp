@@ -0,0 +1,524 @@
+#include "Atlas/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// The triangles using each vertex, as ranges of one flat list
+			struct Adjacency {
+				std::vector<uint32_t> offsets;
+				std::vector<uint32_t> triangles;
+
+				Adjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+					: offsets(vertexCount + 1, 0)
+					, triangles(indices.size()) {
+					for (uint32_t index : indices) {
+						offsets[index + 1]++;
+					}
+					for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+						offsets[vertex + 1] += offsets[vertex];
+					}
+					std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+					for (size_t i = 0; i < indices.size(); i++) {
+						triangles[next[indices[i]]++] = static_cast<uint32_t>(i / 3);
+					}
+				}
+
+				uint32_t count(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+			};
+
+			// A FIFO vertex cache. A vertex is cached if fewer than cacheSize others were transformed since it was.
+			class CacheSimulator {
+			public:
+				CacheSimulator(size_t vertexCount, size_t cacheSize)
+					: m_transformedAt(vertexCount, 0)
+					, m_cacheSize(cacheSize)
+					, m_time(cacheSize + 1) {}
+
+				// Returns 1 if the vertex had to be transformed
+				uint32_t use(uint32_t vertex) {
+					if (m_time - m_transformedAt[vertex] > m_cacheSize) {
+						m_transformedAt[vertex] = m_time++;
+						return 1;
+					}
+					return 0;
+				}
+
+				uint32_t useTriangle(const uint32_t* triangle) {
+					return use(triangle[0]) + use(triangle[1]) + use(triangle[2]);
+				}
+
+				void flush() {
+					m_time += m_cacheSize + 1;
+				}
+
+			private:
+				std::vector<uint64_t> m_transformedAt;
+				uint64_t m_cacheSize;
+				uint64_t m_time;
+			};
+
+			struct Vector3 {
+				float x, y, z;
+
+				Vector3 operator+(const Vector3& other) const { return { x + other.x, y + other.y, z + other.z }; }
+				Vector3 operator-(const Vector3& other) const { return { x - other.x, y - other.y, z - other.z }; }
+				Vector3 operator*(float scale) const { return { x * scale, y * scale, z * scale }; }
+				float dot(const Vector3& other) const { return x * other.x + y * other.y + z * other.z; }
+				Vector3 cross(const Vector3& other) const { return { y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x }; }
+				float length() const { return std::sqrt(dot(*this)); }
+			};
+
+			Vector3 position(const std::vector<MeshVertex>& vertices, uint32_t index) {
+				const float* p = vertices[index].position;
+				return { p[0], p[1], p[2] };
+			}
+
+			// Spread the low 10 bits of a value out to every third bit
+			uint32_t spreadBits(uint32_t value) {
+				value &= 0x3ff;
+				value = (value | (value << 16)) & 0x030000ff;
+				value = (value | (value << 8)) & 0x0300f00f;
+				value = (value | (value << 4)) & 0x030c30c3;
+				value = (value | (value << 2)) & 0x09249249;
+				return value;
+			}
+
+			// Ritter's bounding sphere: the widest pair of axis extremes, grown to take in every point
+			void boundingSphere(const std::vector<Vector3>& points, float center[3], float& radius) {
+				Vector3 lowest[3] = { points[0], points[0], points[0] };
+				Vector3 highest[3] = { points[0], points[0], points[0] };
+				for (const Vector3& point : points) {
+					for (int axis = 0; axis < 3; axis++) {
+						const float* p = &point.x;
+						if (p[axis] < (&lowest[axis].x)[axis]) {
+							lowest[axis] = point;
+						}
+						if (p[axis] > (&highest[axis].x)[axis]) {
+							highest[axis] = point;
+						}
+					}
+				}
+				int widest = 0;
+				for (int axis = 1; axis < 3; axis++) {
+					if ((highest[axis] - lowest[axis]).length() > (highest[widest] - lowest[widest]).length()) {
+						widest = axis;
+					}
+				}
+				Vector3 middle = (lowest[widest] + highest[widest]) * 0.5f;
+				float size = (highest[widest] - lowest[widest]).length() * 0.5f;
+				for (const Vector3& point : points) {
+					float distance = (point - middle).length();
+					if (distance > size) {
+						float grown = (size + distance) * 0.5f;
+						middle = middle + (point - middle) * ((grown - size) / distance);
+						size = grown;
+					}
+				}
+				center[0] = middle.x;
+				center[1] = middle.y;
+				center[2] = middle.z;
+				radius = size;
+			}
+
+			void meshletBounds(const Mesh& mesh, CookedMeshlet& meshlet) {
+				std::vector<Vector3> points(meshlet.vertexCount);
+				for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+					points[i] = position(mesh.vertices, mesh.meshletVertices[meshlet.vertexOffset + i]);
+				}
+				boundingSphere(points, meshlet.center, meshlet.radius);
+				Vector3 center = { meshlet.center[0], meshlet.center[1], meshlet.center[2] };
+
+				const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+				std::vector<Vector3> normals;
+				std::vector<Vector3> corners;
+				Vector3 sum = { 0.0f, 0.0f, 0.0f };
+				for (uint32_t i = 0; i < meshlet.triangleCount; i++) {
+					Vector3 a = points[triangles[i * 3]];
+					Vector3 normal = (points[triangles[i * 3 + 1]] - a).cross(points[triangles[i * 3 + 2]] - a);
+					float length = normal.length();
+					// Degenerate triangles cannot be seen from anywhere, so do not widen the cone
+					if (length > 0.0f) {
+						normals.push_back(normal * (1.0f / length));
+						corners.push_back(a);
+						sum = sum + normals.back();
+					}
+				}
+
+				meshlet.coneApex[0] = center.x;
+				meshlet.coneApex[1] = center.y;
+				meshlet.coneApex[2] = center.z;
+				meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+				meshlet.coneCutoff = 2.0f;
+				float length = sum.length();
+				if (length < 1e-6f) {
+					return;
+				}
+				Vector3 axis = sum * (1.0f / length);
+				float minimumDot = 1.0f;
+				for (const Vector3& normal : normals) {
+					minimumDot = std::min(minimumDot, normal.dot(axis));
+				}
+				// Past about 84 degrees from the axis there is hardly anywhere left that sees only back faces
+				if (minimumDot <= 0.1f) {
+					return;
+				}
+				// Move the apex back along the axis until it is behind every triangle's plane
+				float back = 0.0f;
+				for (size_t i = 0; i < normals.size(); i++) {
+					back = std::max(back, (center - corners[i]).dot(normals[i]) / axis.dot(normals[i]));
+				}
+				Vector3 apex = center - axis * back;
+				meshlet.coneApex[0] = apex.x;
+				meshlet.coneApex[1] = apex.y;
+				meshlet.coneApex[2] = apex.z;
+				meshlet.coneAxis[0] = axis.x;
+				meshlet.coneAxis[1] = axis.y;
+				meshlet.coneAxis[2] = axis.z;
+				// The sine of the cone's angle: a viewer within 90 degrees minus that of the axis sees only back faces
+				meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+			}
+		}
+
+		void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize) {
+			size_t triangleCount = indices.size() / 3;
+			if (triangleCount == 0) {
+				return;
+			}
+			Adjacency adjacency(indices, vertexCount);
+			std::vector<uint32_t> live(vertexCount);
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+				live[vertex] = adjacency.count(vertex);
+			}
+			std::vector<uint64_t> transformedAt(vertexCount, 0);
+			uint64_t time = cacheSize + 1;
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<uint32_t> deadEnds;
+			std::vector<uint32_t> candidates;
+			std::vector<uint32_t> result;
+			result.reserve(triangleCount * 3);
+			uint32_t nextVertex = 0;
+
+			// Somewhere to carry on from once the current fan has nowhere good to go: a recently used vertex, or else
+			// the next one in order that still has triangles
+			auto skipDeadEnd = [&]() -> int64_t {
+				while (!deadEnds.empty()) {
+					uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+					if (live[vertex] > 0) {
+						return vertex;
+					}
+				}
+				for (; nextVertex < vertexCount; nextVertex++) {
+					if (live[nextVertex] > 0) {
+						return nextVertex;
+					}
+				}
+				return -1;
+			};
+
+			// Tipsify (Sander et al. 2007): emit every remaining triangle around one vertex at a time
+			for (int64_t fan = skipDeadEnd(); fan >= 0;) {
+				candidates.clear();
+				for (uint32_t i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; i++) {
+					uint32_t triangle = adjacency.triangles[i];
+					if (emitted[triangle]) {
+						continue;
+					}
+					emitted[triangle] = true;
+					for (int corner = 0; corner < 3; corner++) {
+						uint32_t vertex = indices[triangle * 3 + corner];
+						result.push_back(vertex);
+						deadEnds.push_back(vertex);
+						candidates.push_back(vertex);
+						live[vertex]--;
+						if (time - transformedAt[vertex] > cacheSize) {
+							transformedAt[vertex] = time++;
+						}
+					}
+				}
+
+				// Fan around the vertex that has been cached longest, but will still be cached after its own triangles
+				int64_t next = -1;
+				int64_t bestPriority = -1;
+				for (uint32_t vertex : candidates) {
+					if (live[vertex] == 0) {
+						continue;
+					}
+					int64_t priority = 0;
+					if (time - transformedAt[vertex] + 2 * live[vertex] <= cacheSize) {
+						priority = static_cast<int64_t>(time - transformedAt[vertex]);
+					}
+					if (priority > bestPriority) {
+						bestPriority = priority;
+						next = vertex;
+					}
+				}
+				fan = next >= 0 ? next : skipDeadEnd();
+			}
+			indices.swap(result);
+		}
+
+		void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold, size_t cacheSize) {
+			size_t triangleCount = indices.size() / 3;
+			if (triangleCount == 0) {
+				return;
+			}
+
+			// Hard boundaries, where every vertex of a triangle missed, are where the order jumped somewhere new
+			std::vector<uint32_t> misses(triangleCount);
+			std::vector<uint32_t> hardBoundaries;
+			CacheSimulator cache(vertices.size(), cacheSize);
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+				misses[triangle] = cache.useTriangle(&indices[triangle * 3]);
+				if (triangle == 0 || misses[triangle] == 3) {
+					hardBoundaries.push_back(triangle);
+				}
+			}
+			hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+			// Soft boundaries split those further, wherever a cluster starting with a cold cache has already
+			// come down to nearly the miss ratio of the whole
+			std::vector<uint32_t> clusters;
+			for (size_t hard = 0; hard + 1 < hardBoundaries.size(); hard++) {
+				uint32_t begin = hardBoundaries[hard];
+				uint32_t end = hardBoundaries[hard + 1];
+				uint32_t hardMisses = 0;
+				for (uint32_t triangle = begin; triangle < end; triangle++) {
+					hardMisses += misses[triangle];
+				}
+				float target = threshold * hardMisses / (end - begin);
+
+				cache.flush();
+				clusters.push_back(begin);
+				uint32_t clusterMisses = 0;
+				uint32_t clusterTriangles = 0;
+				for (uint32_t triangle = begin; triangle + 1 < end; triangle++) {
+					clusterMisses += cache.useTriangle(&indices[triangle * 3]);
+					clusterTriangles++;
+					if (clusterMisses <= target * clusterTriangles) {
+						cache.flush();
+						clusters.push_back(triangle + 1);
+						clusterMisses = 0;
+						clusterTriangles = 0;
+					}
+				}
+			}
+			clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+			Vector3 meshCentre = { 0.0f, 0.0f, 0.0f };
+			for (uint32_t vertex = 0; vertex < vertices.size(); vertex++) {
+				meshCentre = meshCentre + position(vertices, vertex);
+			}
+			meshCentre = meshCentre * (1.0f / std::max<size_t>(vertices.size(), 1));
+
+			// How far each cluster faces out from the centre: its area weighted centre along its average normal
+			std::vector<float> outwardness(clusters.size() - 1);
+			for (size_t cluster = 0; cluster + 1 < clusters.size(); cluster++) {
+				Vector3 centre = { 0.0f, 0.0f, 0.0f };
+				Vector3 normal = { 0.0f, 0.0f, 0.0f };
+				float area = 0.0f;
+				for (uint32_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++) {
+					Vector3 a = position(vertices, indices[triangle * 3]);
+					Vector3 b = position(vertices, indices[triangle * 3 + 1]);
+					Vector3 c = position(vertices, indices[triangle * 3 + 2]);
+					Vector3 weighted = (b - a).cross(c - a);
+					float triangleArea = weighted.length();
+					centre = centre + (a + b + c) * (triangleArea / 3.0f);
+					normal = normal + weighted;
+					area += triangleArea;
+				}
+				float normalLength = normal.length();
+				if (area > 0.0f && normalLength > 0.0f) {
+					outwardness[cluster] = (centre * (1.0f / area) - meshCentre).dot(normal * (1.0f / normalLength));
+				} else {
+					outwardness[cluster] = 0.0f;
+				}
+			}
+
+			std::vector<uint32_t> order(clusters.size() - 1);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				return outwardness[a] > outwardness[b];
+			});
+			std::vector<uint32_t> result;
+			result.reserve(indices.size());
+			for (uint32_t cluster : order) {
+				result.insert(result.end(), indices.begin() + size_t(clusters[cluster]) * 3, indices.begin() + size_t(clusters[cluster + 1]) * 3);
+			}
+			indices.swap(result);
+		}
+
+		void optimizeVertexFetch(Mesh& mesh) {
+			std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+			std::vector<MeshVertex> vertices;
+			vertices.reserve(mesh.vertices.size());
+			for (uint32_t& index : mesh.indices) {
+				if (remap[index] == UINT32_MAX) {
+					remap[index] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(mesh.vertices[index]);
+				}
+				index = remap[index];
+			}
+			// Vertices that no triangle uses are dropped
+			mesh.vertices.swap(vertices);
+		}
+
+		void buildMeshlets(Mesh& mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+			if (maxVertices < 3 || maxVertices > 256 || maxTriangles == 0) {
+				throw std::logic_error("buildMeshlets: meshlets need 3 to 256 vertices and at least one triangle");
+			}
+			mesh.meshlets.clear();
+			mesh.meshletVertices.clear();
+			mesh.meshletTriangles.clear();
+			const std::vector<uint32_t>& indices = mesh.indices;
+			uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			if (triangleCount == 0) {
+				return;
+			}
+			Adjacency adjacency(indices, mesh.vertices.size());
+
+			std::vector<Vector3> centres(triangleCount);
+			Vector3 lowest = { INFINITY, INFINITY, INFINITY };
+			Vector3 highest = { -INFINITY, -INFINITY, -INFINITY };
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+				Vector3 centre = (position(mesh.vertices, indices[triangle * 3]) + position(mesh.vertices, indices[triangle * 3 + 1])
+					+ position(mesh.vertices, indices[triangle * 3 + 2])) * (1.0f / 3.0f);
+				centres[triangle] = centre;
+				lowest = { std::min(lowest.x, centre.x), std::min(lowest.y, centre.y), std::min(lowest.z, centre.z) };
+				highest = { std::max(highest.x, centre.x), std::max(highest.y, centre.y), std::max(highest.z, centre.z) };
+			}
+			// Where nothing connected is left to grow into, meshlets carry on with the next triangle along a Morton curve
+			std::vector<uint32_t> mortonCodes(triangleCount);
+			Vector3 extent = highest - lowest;
+			float scale = 1023.0f / std::max({ extent.x, extent.y, extent.z, 1e-20f });
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+				Vector3 cell = (centres[triangle] - lowest) * scale;
+				mortonCodes[triangle] = spreadBits(static_cast<uint32_t>(cell.x)) | (spreadBits(static_cast<uint32_t>(cell.y)) << 1)
+					| (spreadBits(static_cast<uint32_t>(cell.z)) << 2);
+			}
+			std::vector<uint32_t> spatialOrder(triangleCount);
+			std::iota(spatialOrder.begin(), spatialOrder.end(), 0);
+			std::stable_sort(spatialOrder.begin(), spatialOrder.end(), [&](uint32_t a, uint32_t b) {
+				return mortonCodes[a] < mortonCodes[b];
+			});
+			size_t nextSpatial = 0;
+
+			std::vector<bool> assigned(triangleCount, false);
+			// The meshlet that last made a triangle a candidate, so each is only listed once per meshlet
+			std::vector<uint32_t> candidateOf(triangleCount, UINT32_MAX);
+			std::vector<int32_t> localIndex(mesh.vertices.size(), -1);
+			std::vector<uint32_t> candidates;
+			CookedMeshlet meshlet = {};
+			Vector3 centreSum = { 0.0f, 0.0f, 0.0f };
+
+			auto newVertices = [&](uint32_t triangle) {
+				return (localIndex[indices[triangle * 3]] < 0) + (localIndex[indices[triangle * 3 + 1]] < 0) + (localIndex[indices[triangle * 3 + 2]] < 0);
+			};
+			auto add = [&](uint32_t triangle) {
+				assigned[triangle] = true;
+				for (int corner = 0; corner < 3; corner++) {
+					uint32_t vertex = indices[triangle * 3 + corner];
+					if (localIndex[vertex] < 0) {
+						localIndex[vertex] = static_cast<int32_t>(meshlet.vertexCount++);
+						mesh.meshletVertices.push_back(vertex);
+					}
+					mesh.meshletTriangles.push_back(static_cast<uint8_t>(localIndex[vertex]));
+					for (uint32_t i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++) {
+						uint32_t neighbour = adjacency.triangles[i];
+						if (!assigned[neighbour] && candidateOf[neighbour] != mesh.meshlets.size()) {
+							candidateOf[neighbour] = static_cast<uint32_t>(mesh.meshlets.size());
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+				meshlet.triangleCount++;
+				centreSum = centreSum + centres[triangle];
+			};
+			auto finish = [&]() {
+				meshletBounds(mesh, meshlet);
+				for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+					localIndex[mesh.meshletVertices[meshlet.vertexOffset + i]] = -1;
+				}
+				mesh.meshlets.push_back(meshlet);
+				// The next meshlet's triangles start 4 byte aligned
+				mesh.meshletTriangles.resize((mesh.meshletTriangles.size() + 3) & ~size_t(3), 0);
+				meshlet = {};
+				meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+				meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+				centreSum = { 0.0f, 0.0f, 0.0f };
+				candidates.clear();
+			};
+
+			for (uint32_t remaining = triangleCount; remaining > 0;) {
+				int64_t best = -1;
+				if (meshlet.triangleCount < maxTriangles) {
+					// Grow through shared vertices, taking whatever adds fewest new vertices, then stays closest
+					Vector3 centre = centreSum * (1.0f / std::max(meshlet.triangleCount, 1u));
+					int bestNew = 4;
+					float bestDistance = 0.0f;
+					for (size_t i = 0; i < candidates.size();) {
+						uint32_t triangle = candidates[i];
+						if (assigned[triangle]) {
+							candidates[i] = candidates.back();
+							candidates.pop_back();
+							continue;
+						}
+						i++;
+						int added = newVertices(triangle);
+						if (meshlet.vertexCount + added > maxVertices) {
+							continue;
+						}
+						Vector3 offset = centres[triangle] - centre;
+						float distance = offset.dot(offset);
+						if (added < bestNew || (added == bestNew && distance < bestDistance)) {
+							best = triangle;
+							bestNew = added;
+							bestDistance = distance;
+						}
+					}
+					if (best < 0) {
+						while (assigned[spatialOrder[nextSpatial]]) {
+							nextSpatial++;
+						}
+						uint32_t triangle = spatialOrder[nextSpatial];
+						if (meshlet.vertexCount + newVertices(triangle) <= maxVertices) {
+							best = triangle;
+						}
+					}
+				}
+				if (best < 0) {
+					finish();
+					continue;
+				}
+				add(static_cast<uint32_t>(best));
+				remaining--;
+			}
+			finish();
+		}
+
+		void optimizeMesh(Mesh& mesh) {
+			optimizeVertexCache(mesh.indices, mesh.vertices.size());
+			optimizeOverdraw(mesh.indices, mesh.vertices);
+			optimizeVertexFetch(mesh);
+			buildMeshlets(mesh);
+		}
+
+		float averageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize) {
+			size_t triangleCount = indices.size() / 3;
+			if (triangleCount == 0) {
+				return 0.0f;
+			}
+			CacheSimulator cache(vertexCount, cacheSize);
+			uint64_t misses = 0;
+			for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+				misses += cache.useTriangle(&indices[triangle * 3]);
+			}
+			return float(double(misses) / triangleCount);
+		}
+	}
+}
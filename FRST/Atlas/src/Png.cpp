@@ -0,0 +1,423 @@
+#include "Atlas/Png.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			// Reads a deflate stream least significant bit first, one byte at a time
+			class BitReader {
+			public:
+				BitReader(std::span<const uint8_t> data)
+					: m_data(data)
+					, m_position(0)
+					, m_buffer(0)
+					, m_count(0) {}
+
+				uint32_t bits(int count) {
+					while (m_count < count) {
+						if (m_position == m_data.size()) {
+							throw std::runtime_error("inflate: stream is truncated");
+						}
+						m_buffer |= uint32_t(m_data[m_position++]) << m_count;
+						m_count += 8;
+					}
+					uint32_t value = m_buffer & ((1u << count) - 1);
+					m_buffer >>= count;
+					m_count -= count;
+					return value;
+				}
+
+				// Drop the rest of the current byte, for stored blocks. Never more than 7 bits are buffered.
+				void alignToByte() {
+					m_buffer = 0;
+					m_count = 0;
+				}
+
+				std::span<const uint8_t> take(size_t size) {
+					if (size > m_data.size() - m_position) {
+						throw std::runtime_error("inflate: stream is truncated");
+					}
+					std::span<const uint8_t> bytes = m_data.subspan(m_position, size);
+					m_position += size;
+					return bytes;
+				}
+
+			private:
+				std::span<const uint8_t> m_data;
+				size_t m_position;
+				uint32_t m_buffer;
+				int m_count;
+			};
+
+			// A canonical Huffman code, decoded a bit at a time. This is slow, but only the cooker decodes PNGs.
+			struct Huffman {
+				uint16_t counts[16];
+				uint16_t symbols[288];
+
+				void build(const uint8_t* lengths, int numSymbols) {
+					std::memset(counts, 0, sizeof(counts));
+					for (int symbol = 0; symbol < numSymbols; symbol++) {
+						counts[lengths[symbol]]++;
+					}
+					int left = 1;
+					for (int length = 1; length < 16; length++) {
+						left = (left << 1) - counts[length];
+						if (left < 0) {
+							throw std::runtime_error("inflate: over-subscribed Huffman code");
+						}
+					}
+					uint16_t offsets[16];
+					offsets[1] = 0;
+					for (int length = 1; length < 15; length++) {
+						offsets[length + 1] = offsets[length] + counts[length];
+					}
+					for (int symbol = 0; symbol < numSymbols; symbol++) {
+						if (lengths[symbol] != 0) {
+							symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+						}
+					}
+				}
+
+				int decode(BitReader& reader) const {
+					int code = 0;
+					int first = 0;
+					int index = 0;
+					for (int length = 1; length < 16; length++) {
+						code |= static_cast<int>(reader.bits(1));
+						int count = counts[length];
+						if (code - first < count) {
+							return symbols[index + code - first];
+						}
+						index += count;
+						first = (first + count) << 1;
+						code <<= 1;
+					}
+					throw std::runtime_error("inflate: invalid Huffman code");
+				}
+			};
+
+			const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+				67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+				5, 5, 5, 5, 0 };
+			const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+				513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9,
+				10, 10, 11, 11, 12, 12, 13, 13 };
+
+			void inflateBlock(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<uint8_t>& out) {
+				for (;;) {
+					int symbol = literals.decode(reader);
+					if (symbol < 256) {
+						out.push_back(static_cast<uint8_t>(symbol));
+						continue;
+					}
+					if (symbol == 256) {
+						return;
+					}
+					symbol -= 257;
+					if (symbol >= 29) {
+						throw std::runtime_error("inflate: invalid length");
+					}
+					size_t length = LENGTH_BASE[symbol] + reader.bits(LENGTH_EXTRA[symbol]);
+					int distanceSymbol = distances.decode(reader);
+					if (distanceSymbol >= 30) {
+						throw std::runtime_error("inflate: invalid distance");
+					}
+					size_t distance = DISTANCE_BASE[distanceSymbol] + reader.bits(DISTANCE_EXTRA[distanceSymbol]);
+					if (distance > out.size()) {
+						throw std::runtime_error("inflate: distance before the start of the stream");
+					}
+					// Copies may overlap themselves, so go a byte at a time
+					size_t from = out.size() - distance;
+					for (size_t i = 0; i < length; i++) {
+						out.push_back(out[from + i]);
+					}
+				}
+			}
+
+			void readDynamicCodes(BitReader& reader, Huffman& literals, Huffman& distances) {
+				static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+				int numLiterals = static_cast<int>(reader.bits(5)) + 257;
+				int numDistances = static_cast<int>(reader.bits(5)) + 1;
+				int numCodeLengths = static_cast<int>(reader.bits(4)) + 4;
+				if (numLiterals > 286 || numDistances > 30) {
+					throw std::runtime_error("inflate: too many codes");
+				}
+
+				uint8_t lengths[320] = {};
+				for (int i = 0; i < numCodeLengths; i++) {
+					lengths[ORDER[i]] = static_cast<uint8_t>(reader.bits(3));
+				}
+				Huffman codeLengths;
+				codeLengths.build(lengths, 19);
+
+				int total = numLiterals + numDistances;
+				for (int i = 0; i < total;) {
+					int symbol = codeLengths.decode(reader);
+					if (symbol < 16) {
+						lengths[i++] = static_cast<uint8_t>(symbol);
+						continue;
+					}
+					uint8_t value = 0;
+					int repeat;
+					if (symbol == 16) {
+						if (i == 0) {
+							throw std::runtime_error("inflate: repeat with no previous length");
+						}
+						value = lengths[i - 1];
+						repeat = 3 + static_cast<int>(reader.bits(2));
+					} else if (symbol == 17) {
+						repeat = 3 + static_cast<int>(reader.bits(3));
+					} else {
+						repeat = 11 + static_cast<int>(reader.bits(7));
+					}
+					if (i + repeat > total) {
+						throw std::runtime_error("inflate: too many lengths");
+					}
+					while (repeat--) {
+						lengths[i++] = value;
+					}
+				}
+				literals.build(lengths, numLiterals);
+				distances.build(lengths + numLiterals, numDistances);
+			}
+
+			uint32_t readBigEndian(const uint8_t* bytes) {
+				return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+			}
+
+			uint8_t paeth(int a, int b, int c) {
+				int p = a + b - c;
+				int pa = p > a ? p - a : a - p;
+				int pb = p > b ? p - b : b - p;
+				int pc = p > c ? p - c : c - p;
+				if (pa <= pb && pa <= pc) {
+					return static_cast<uint8_t>(a);
+				}
+				return static_cast<uint8_t>(pb <= pc ? b : c);
+			}
+		}
+
+		std::vector<uint8_t> inflateZlib(std::span<const uint8_t> data, size_t sizeHint) {
+			if (data.size() < 2 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+				throw std::runtime_error("inflate: not a zlib stream");
+			}
+			BitReader reader(data.subspan(2));
+			std::vector<uint8_t> out;
+			out.reserve(sizeHint);
+
+			Huffman fixedLiterals;
+			Huffman fixedDistances;
+			bool builtFixed = false;
+			bool last;
+			do {
+				last = reader.bits(1) != 0;
+				uint32_t type = reader.bits(2);
+				if (type == 0) {
+					reader.alignToByte();
+					std::span<const uint8_t> header = reader.take(4);
+					uint32_t length = uint32_t(header[0]) | (uint32_t(header[1]) << 8);
+					if ((length ^ 0xffff) != (uint32_t(header[2]) | (uint32_t(header[3]) << 8))) {
+						throw std::runtime_error("inflate: corrupt stored block");
+					}
+					std::span<const uint8_t> bytes = reader.take(length);
+					out.insert(out.end(), bytes.begin(), bytes.end());
+				} else if (type == 1) {
+					if (!builtFixed) {
+						uint8_t lengths[288];
+						std::memset(lengths, 8, 144);
+						std::memset(lengths + 144, 9, 112);
+						std::memset(lengths + 256, 7, 24);
+						std::memset(lengths + 280, 8, 8);
+						fixedLiterals.build(lengths, 288);
+						std::memset(lengths, 5, 30);
+						fixedDistances.build(lengths, 30);
+						builtFixed = true;
+					}
+					inflateBlock(reader, fixedLiterals, fixedDistances, out);
+				} else if (type == 2) {
+					Huffman literals;
+					Huffman distances;
+					readDynamicCodes(reader, literals, distances);
+					inflateBlock(reader, literals, distances, out);
+				} else {
+					throw std::runtime_error("inflate: invalid block type");
+				}
+			} while (!last);
+			return out;
+		}
+
+		Image decodePng(std::span<const uint8_t> data) {
+			static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			if (data.size() < 8 || std::memcmp(data.data(), SIGNATURE, 8) != 0) {
+				throw std::runtime_error("PNG: bad signature");
+			}
+
+			uint32_t width = 0;
+			uint32_t height = 0;
+			int bitDepth = 0;
+			int colourType = -1;
+			uint8_t palette[256][4];
+			uint32_t paletteSize = 0;
+			// A tRNS colour key for grey and RGB images, at the image's bit depth
+			bool hasColourKey = false;
+			uint16_t colourKey[3] = {};
+			std::vector<uint8_t> compressed;
+
+			size_t position = 8;
+			for (;;) {
+				if (data.size() - position < 12) {
+					throw std::runtime_error("PNG: truncated chunk");
+				}
+				uint32_t length = readBigEndian(&data[position]);
+				const uint8_t* type = &data[position + 4];
+				if (length > data.size() - position - 12) {
+					throw std::runtime_error("PNG: truncated chunk");
+				}
+				const uint8_t* body = &data[position + 8];
+				position += 12 + size_t(length);
+
+				if (std::memcmp(type, "IHDR", 4) == 0) {
+					if (length != 13) {
+						throw std::runtime_error("PNG: bad header");
+					}
+					width = readBigEndian(body);
+					height = readBigEndian(body + 4);
+					bitDepth = body[8];
+					colourType = body[9];
+					if (body[12] != 0) {
+						throw std::runtime_error("PNG: interlaced images are not supported");
+					}
+				} else if (std::memcmp(type, "PLTE", 4) == 0) {
+					paletteSize = std::min<uint32_t>(length / 3, 256);
+					for (uint32_t i = 0; i < paletteSize; i++) {
+						palette[i][0] = body[i * 3];
+						palette[i][1] = body[i * 3 + 1];
+						palette[i][2] = body[i * 3 + 2];
+						palette[i][3] = 255;
+					}
+				} else if (std::memcmp(type, "tRNS", 4) == 0) {
+					if (colourType == 3) {
+						for (uint32_t i = 0; i < length && i < paletteSize; i++) {
+							palette[i][3] = body[i];
+						}
+					} else if (colourType == 0 && length >= 2) {
+						hasColourKey = true;
+						colourKey[0] = static_cast<uint16_t>((body[0] << 8) | body[1]);
+					} else if (colourType == 2 && length >= 6) {
+						hasColourKey = true;
+						for (int c = 0; c < 3; c++) {
+							colourKey[c] = static_cast<uint16_t>((body[c * 2] << 8) | body[c * 2 + 1]);
+						}
+					}
+				} else if (std::memcmp(type, "IDAT", 4) == 0) {
+					compressed.insert(compressed.end(), body, body + length);
+				} else if (std::memcmp(type, "IEND", 4) == 0) {
+					break;
+				} else if (!(type[0] & 0x20)) {
+					throw std::runtime_error("PNG: unknown critical chunk " + std::string(reinterpret_cast<const char*>(type), 4));
+				}
+			}
+
+			int channels;
+			switch (colourType) {
+			case 0: channels = 1; break;
+			case 2: channels = 3; break;
+			case 3: channels = 1; break;
+			case 4: channels = 2; break;
+			case 6: channels = 4; break;
+			default: throw std::runtime_error("PNG: missing or bad header");
+			}
+			bool validDepth = bitDepth == 8 || (bitDepth == 16 && colourType != 3)
+				|| ((bitDepth == 1 || bitDepth == 2 || bitDepth == 4) && (colourType == 0 || colourType == 3));
+			if (!validDepth || width == 0 || height == 0 || width > (1u << 16) || height > (1u << 16)) {
+				throw std::runtime_error("PNG: unsupported size or bit depth");
+			}
+			if (colourType == 3 && paletteSize == 0) {
+				throw std::runtime_error("PNG: missing palette");
+			}
+
+			size_t stride = (size_t(width) * channels * bitDepth + 7) / 8;
+			size_t pixelBytes = std::max<size_t>(1, size_t(channels) * bitDepth / 8);
+			std::vector<uint8_t> raw = inflateZlib(compressed, (stride + 1) * height);
+			if (raw.size() < (stride + 1) * height) {
+				throw std::runtime_error("PNG: not enough image data");
+			}
+
+			// Undo each row's filter, dropping the filter bytes
+			std::vector<uint8_t> rows(stride * height);
+			for (uint32_t y = 0; y < height; y++) {
+				uint8_t filter = raw[y * (stride + 1)];
+				const uint8_t* in = &raw[y * (stride + 1) + 1];
+				uint8_t* row = &rows[y * stride];
+				const uint8_t* previous = y > 0 ? &rows[(y - 1) * stride] : nullptr;
+				for (size_t i = 0; i < stride; i++) {
+					int left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+					int up = previous ? previous[i] : 0;
+					int upLeft = previous && i >= pixelBytes ? previous[i - pixelBytes] : 0;
+					int predicted;
+					switch (filter) {
+					case 0: predicted = 0; break;
+					case 1: predicted = left; break;
+					case 2: predicted = up; break;
+					case 3: predicted = (left + up) / 2; break;
+					case 4: predicted = paeth(left, up, upLeft); break;
+					default: throw std::runtime_error("PNG: bad filter");
+					}
+					row[i] = static_cast<uint8_t>(in[i] + predicted);
+				}
+			}
+
+			Image image;
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(size_t(width) * height * 4);
+			uint32_t maxSample = (1u << bitDepth) - 1;
+			for (uint32_t y = 0; y < height; y++) {
+				const uint8_t* row = &rows[y * stride];
+				auto sample = [&](uint32_t index) -> uint32_t {
+					if (bitDepth == 8) {
+						return row[index];
+					}
+					if (bitDepth == 16) {
+						return (uint32_t(row[index * 2]) << 8) | row[index * 2 + 1];
+					}
+					uint32_t bit = index * bitDepth;
+					return (row[bit / 8] >> (8 - bitDepth - bit % 8)) & maxSample;
+				};
+				auto to8 = [&](uint32_t value) -> uint8_t {
+					return static_cast<uint8_t>(bitDepth == 16 ? value >> 8 : value * 255 / maxSample);
+				};
+
+				for (uint32_t x = 0; x < width; x++) {
+					uint8_t* pixel = image.pixel(x, y);
+					uint32_t first = x * channels;
+					if (colourType == 3) {
+						uint32_t index = sample(first);
+						if (index >= paletteSize) {
+							throw std::runtime_error("PNG: palette index out of range");
+						}
+						std::memcpy(pixel, palette[index], 4);
+					} else if (colourType == 0 || colourType == 4) {
+						uint32_t grey = sample(first);
+						pixel[0] = pixel[1] = pixel[2] = to8(grey);
+						pixel[3] = colourType == 4 ? to8(sample(first + 1)) : (hasColourKey && grey == colourKey[0] ? 0 : 255);
+					} else {
+						uint32_t rgb[3] = { sample(first), sample(first + 1), sample(first + 2) };
+						for (int c = 0; c < 3; c++) {
+							pixel[c] = to8(rgb[c]);
+						}
+						bool keyed = hasColourKey && rgb[0] == colourKey[0] && rgb[1] == colourKey[1] && rgb[2] == colourKey[2];
+						pixel[3] = colourType == 6 ? to8(sample(first + 3)) : (keyed ? 0 : 255);
+					}
+				}
+			}
+			return image;
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#include "Atlas/Residency.hpp"
+
+#include <cctype>
+#include <string>
+
+namespace FRST {
+	namespace Atlas {
+		AssetClass classifyAsset(std::string_view path) {
+			size_t dot = path.rfind('.');
+			if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos) {
+				return AssetClass::Other;
+			}
+			std::string extension(path.substr(dot + 1));
+			for (char& c : extension) {
+				c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			}
+
+			if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp"
+					|| extension == "hdr" || extension == "dds" || extension == "ktx" || extension == "ktx2") {
+				return AssetClass::Texture;
+			}
+			if (extension == "obj" || extension == "gltf" || extension == "glb" || extension == "fbx" || extension == "mesh") {
+				return AssetClass::Mesh;
+			}
+			if (extension == "spv" || extension == "glsl" || extension == "vert" || extension == "frag" || extension == "comp") {
+				return AssetClass::Shader;
+			}
+			return AssetClass::Other;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#include "Atlas/ShaderCooker.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace FRST {
+	namespace Atlas {
+		ShaderCooker::ShaderCooker(const std::string& compiler)
+			: m_compiler(compiler) {}
+
+		namespace {
+			// The prerequisites of a Makefile rule as written by glslc -MD, ie. everything after the first ": "
+			std::vector<std::string> parseDepfile(const std::string& text) {
+				std::vector<std::string> files;
+				size_t colon = text.find(": ");
+				if (colon == std::string::npos) {
+					return files;
+				}
+				std::string file;
+				for (size_t i = colon + 2; i < text.size(); i++) {
+					char c = text[i];
+					if (c == '\\' && i + 1 < text.size()) {
+						// An escaped space is part of the name, an escaped newline continues the rule
+						if (text[i + 1] != '\n') {
+							file += text[i + 1];
+						}
+						i++;
+					} else if (c == ' ' || c == '\t' || c == '\n') {
+						if (!file.empty()) {
+							files.push_back(std::move(file));
+							file.clear();
+						}
+					} else {
+						file += c;
+					}
+				}
+				if (!file.empty()) {
+					files.push_back(std::move(file));
+				}
+				return files;
+			}
+		}
+
+		bool ShaderCooker::accepts(std::string_view path) const {
+			static const char* const EXTENSIONS[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese", ".glsl" };
+			for (const char* extension : EXTENSIONS) {
+				std::string_view suffix(extension);
+				if (path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::vector<uint8_t> ShaderCooker::cook(const CookInput& input) const {
+			std::string output = (std::filesystem::temp_directory_path() / "FRST_cook_XXXXXX").string();
+			int fd = mkstemp(output.data());
+			if (fd < 0) {
+				throw std::runtime_error("cannot create a temporary file");
+			}
+			close(fd);
+			// Which files were #included, so that changing one recooks this shader
+			std::string depfile = output + ".d";
+
+			std::string includeDirectory = "-I" + std::filesystem::path(input.sourcePath).parent_path().string();
+			const char* arguments[] = {
+				m_compiler.c_str(), "-O", "--target-env=vulkan1.0", includeDirectory.c_str(),
+				"-MD", "-MF", depfile.c_str(), "-o", output.c_str(), input.sourcePath.c_str(), nullptr
+			};
+
+			// Only the worker running this cook waits, the rest keep cooking
+			pid_t process;
+			int status = 0;
+			int error = posix_spawnp(&process, m_compiler.c_str(), nullptr, nullptr, const_cast<char* const*>(arguments), environ);
+			if (error == 0 && waitpid(process, &status, 0) < 0) {
+				error = errno;
+			}
+			if (error != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				std::remove(output.c_str());
+				std::remove(depfile.c_str());
+				if (error != 0) {
+					throw std::runtime_error("cannot run " + m_compiler);
+				}
+				throw std::runtime_error(m_compiler + " failed");
+			}
+
+			std::vector<uint8_t> spirv = readFile(output);
+			std::remove(output.c_str());
+			try {
+				std::vector<uint8_t> dependencies = readFile(depfile);
+				for (std::string& file : parseDepfile(std::string(dependencies.begin(), dependencies.end()))) {
+					input.dependencies.push_back(std::move(file));
+				}
+			} catch (const std::runtime_error&) {
+				// Nothing to track beyond the source itself
+			}
+			std::remove(depfile.c_str());
+			return spirv;
+		}
+	}
+}
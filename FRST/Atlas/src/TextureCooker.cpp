@@ -0,0 +1,90 @@
+#include "Atlas/TextureCooker.hpp"
+
+#include <cstring>
+
+#include "Atlas/Png.hpp"
+#include "Atlas/TextureKernels.hpp"
+#include "WorkForce/Worker.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			bool endsWith(std::string_view text, std::string_view suffix) {
+				return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+			}
+		}
+
+		bool TextureCooker::accepts(std::string_view path) const {
+			return endsWith(path, ".png");
+		}
+
+		std::vector<uint8_t> TextureCooker::cook(const CookInput& input) const {
+			Image image = decodePng(input.source);
+			bool hasAlpha = false;
+			size_t binaryAlpha = 0;
+			for (size_t i = 3; i < image.pixels.size(); i += 4) {
+				hasAlpha |= image.pixels[i] != 255;
+				binaryAlpha += image.pixels[i] == 0 || image.pixels[i] == 255;
+			}
+			bool isNormalMap = endsWith(input.path, "_n.png") || endsWith(input.path, "_normal.png");
+			bool isMask = endsWith(input.path, "_mask.png");
+			bool srgb = !isNormalMap && !isMask;
+			// Alpha that is nearly all fully on or off is a cutout, like foliage, rather than something blended
+			bool isCutout = hasAlpha && binaryAlpha * 10 >= (image.pixels.size() / 4) * 9;
+
+			WorkForce::Worker* worker = WorkForce::Worker::current();
+			WorkForce::WorkerPool* pool = worker ? &worker->pool() : nullptr;
+
+			// The chain is filtered in linear light at 14 bits, and each level only rounded back to 8 bits on its own
+			std::vector<Image> mips;
+			LinearImage linear = toLinear(image, srgb);
+			mips.push_back(std::move(image));
+			while (linear.width > 1 || linear.height > 1) {
+				linear = downsample(linear, pool);
+				mips.push_back(fromLinear(linear, srgb));
+			}
+			if (isCutout) {
+				float coverage = alphaCoverage(mips[0], ALPHA_TEST_THRESHOLD);
+				for (size_t level = 1; level < mips.size(); level++) {
+					scaleAlphaToCoverage(mips[level], coverage, ALPHA_TEST_THRESHOLD);
+				}
+			}
+
+			TextureFormat format = TextureFormat::BC1;
+			if (isNormalMap) {
+				format = TextureFormat::BC5;
+			} else if (isMask) {
+				format = TextureFormat::BC4;
+			} else if (hasAlpha) {
+				format = TextureFormat::BC7;
+			}
+
+			CookedTextureHeader header;
+			std::memcpy(header.magic, CookedTextureHeader::MAGIC, 4);
+			header.version = CookedTextureHeader::VERSION;
+			header.format = format;
+			header.flags = srgb ? CookedTextureHeader::FLAG_SRGB : 0;
+			header.width = mips[0].width;
+			header.height = mips[0].height;
+			header.mipCount = static_cast<uint32_t>(mips.size());
+			header.reserved = 0;
+
+			std::vector<CookedMip> table(mips.size());
+			uint64_t offset = (sizeof(CookedTextureHeader) + sizeof(CookedMip) * mips.size() + 15) & ~uint64_t(15);
+			std::vector<std::vector<uint8_t>> blocks(mips.size());
+			for (size_t level = 0; level < mips.size(); level++) {
+				blocks[level] = compressBlocks(mips[level], header.format, pool);
+				table[level] = CookedMip{ offset, blocks[level].size(), mips[level].width, mips[level].height };
+				offset = (offset + blocks[level].size() + 15) & ~uint64_t(15);
+			}
+
+			std::vector<uint8_t> out(offset, 0);
+			std::memcpy(out.data(), &header, sizeof(header));
+			std::memcpy(out.data() + sizeof(header), table.data(), sizeof(CookedMip) * table.size());
+			for (size_t level = 0; level < mips.size(); level++) {
+				std::memcpy(out.data() + table[level].offset, blocks[level].data(), blocks[level].size());
+			}
+			return out;
+		}
+	}
+}
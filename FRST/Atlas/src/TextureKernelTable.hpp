@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRST_TEXTURE_KERNELS_X86
+#endif
+
+
+namespace FRST {
+	namespace Atlas {
+		/*
+		 * The inner loops of TextureKernels.hpp, once per SimdLevel. Everything around them (block gathering,
+		 * endpoint fitting, bit packing) is shared, so each table must give exactly the scalar results.
+		 *
+		 * The SIMD tables are built with their instruction set enabled for the whole file. Those files must not
+		 * use inline functions from other headers (eg. std::min), which the linker could pick over the scalar
+		 * copies and run on CPUs without the instruction set.
+		 */
+		struct TextureKernelTable {
+			// Average each 2x2 texels of two rows of 4 channel 14 bit texels into outWidth texels.
+			// An odd last column is averaged with itself.
+			void (*downsampleRows)(const uint16_t* row0, const uint16_t* row1, uint32_t inWidth, uint16_t* out, uint32_t outWidth);
+			// Scale the alpha of count RGBA8 pixels by scale / 256, rounding down and saturating at 255
+			void (*scaleAlpha)(uint8_t* pixels, size_t count, uint32_t scale);
+			/*
+			 * For each of 16 RGBA pixels, the index of the palette entry with the least squared error over its first
+			 * channels (3 or 4). Ties go to the first entry. paletteSize is at most 16.
+			 */
+			void (*fitColours)(const uint8_t pixels[16][4], const uint8_t palette[][4], int paletteSize, int channels, uint8_t indices[16]);
+			// For each of 16 values, the index of the nearest of 8 palette values. Ties go to the first entry.
+			void (*fitValues)(const uint8_t values[16], const uint8_t palette[8], uint8_t indices[16]);
+		};
+
+		extern const TextureKernelTable scalarTextureKernels;
+#if defined(FRST_TEXTURE_KERNELS_X86)
+		extern const TextureKernelTable sse41TextureKernels;
+		extern const TextureKernelTable avx2TextureKernels;
+#endif
+	}
+}
@@ -0,0 +1,634 @@
+#include "Atlas/TextureKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "TextureKernelTable.hpp"
+#include "WorkForce/Parallel.hpp"
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			void downsampleRowsScalar(const uint16_t* row0, const uint16_t* row1, uint32_t inWidth, uint16_t* out, uint32_t outWidth) {
+				for (uint32_t x = 0; x < outWidth; x++) {
+					uint32_t x0 = std::min(x * 2, inWidth - 1) * 4;
+					uint32_t x1 = std::min(x * 2 + 1, inWidth - 1) * 4;
+					for (int c = 0; c < 4; c++) {
+						out[x * 4 + c] = static_cast<uint16_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+					}
+				}
+			}
+
+			void scaleAlphaScalar(uint8_t* pixels, size_t count, uint32_t scale) {
+				for (size_t i = 0; i < count; i++) {
+					pixels[i * 4 + 3] = static_cast<uint8_t>(std::min<uint32_t>((pixels[i * 4 + 3] * scale) >> 8, 255));
+				}
+			}
+
+			void fitColoursScalar(const uint8_t pixels[16][4], const uint8_t palette[][4], int paletteSize, int channels, uint8_t indices[16]) {
+				for (int i = 0; i < 16; i++) {
+					int best = 0;
+					int bestError = 1 << 30;
+					for (int p = 0; p < paletteSize; p++) {
+						int error = 0;
+						for (int c = 0; c < channels; c++) {
+							int d = pixels[i][c] - palette[p][c];
+							error += d * d;
+						}
+						if (error < bestError) {
+							bestError = error;
+							best = p;
+						}
+					}
+					indices[i] = static_cast<uint8_t>(best);
+				}
+			}
+
+			void fitValuesScalar(const uint8_t values[16], const uint8_t palette[8], uint8_t indices[16]) {
+				for (int i = 0; i < 16; i++) {
+					int best = 0;
+					for (int p = 1; p < 8; p++) {
+						if (std::abs(values[i] - palette[p]) < std::abs(values[i] - palette[best])) {
+							best = p;
+						}
+					}
+					indices[i] = static_cast<uint8_t>(best);
+				}
+			}
+
+			const TextureKernelTable& kernelTable(SimdLevel level) {
+				if (!isSimdLevelSupported(level)) {
+					throw std::logic_error(std::string("TextureKernels: ") + simdLevelName(level) + " is not supported on this CPU");
+				}
+				switch (level) {
+#if defined(FRST_TEXTURE_KERNELS_X86)
+				case SimdLevel::SSE41:
+					return sse41TextureKernels;
+				case SimdLevel::AVX2:
+					return avx2TextureKernels;
+#endif
+				default:
+					return scalarTextureKernels;
+				}
+			}
+
+			struct LinearTables {
+				uint16_t fromSrgb[256];
+				uint16_t fromUnorm[256];
+				uint8_t toSrgb[LinearImage::MAX + 1];
+				uint8_t toUnorm[LinearImage::MAX + 1];
+			};
+
+			const LinearTables& linearTables() {
+				static const LinearTables tables = [] {
+					LinearTables tables;
+					for (int i = 0; i < 256; i++) {
+						double value = i / 255.0;
+						double linear = value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+						tables.fromSrgb[i] = static_cast<uint16_t>(std::lround(linear * LinearImage::MAX));
+						tables.fromUnorm[i] = static_cast<uint16_t>((i * LinearImage::MAX + 127) / 255);
+					}
+					for (int i = 0; i <= LinearImage::MAX; i++) {
+						double linear = double(i) / LinearImage::MAX;
+						double value = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+						tables.toSrgb[i] = static_cast<uint8_t>(std::lround(value * 255.0));
+						tables.toUnorm[i] = static_cast<uint8_t>((i * 255 + LinearImage::MAX / 2) / LinearImage::MAX);
+					}
+					return tables;
+				}();
+				return tables;
+			}
+
+			uint16_t packRGB565(const float colour[3]) {
+				int r = std::clamp(static_cast<int>(std::lround(colour[0] * 31.0f / 255.0f)), 0, 31);
+				int g = std::clamp(static_cast<int>(std::lround(colour[1] * 63.0f / 255.0f)), 0, 63);
+				int b = std::clamp(static_cast<int>(std::lround(colour[2] * 31.0f / 255.0f)), 0, 31);
+				return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+			}
+
+			void unpackRGB565(uint16_t packed, uint8_t colour[4]) {
+				int r = (packed >> 11) & 31;
+				int g = (packed >> 5) & 63;
+				int b = packed & 31;
+				colour[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+				colour[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+				colour[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+				colour[3] = 255;
+			}
+
+			// BC1 colour endpoints from the extremes of the block along its principal axis, in 4 colour mode
+			void encodeColourBlock(const uint8_t block[16][4], uint8_t* out, const TextureKernelTable& kernels) {
+				float mean[3] = {};
+				for (int i = 0; i < 16; i++) {
+					for (int c = 0; c < 3; c++) {
+						mean[c] += block[i][c] / 16.0f;
+					}
+				}
+				float covariance[6] = {};
+				for (int i = 0; i < 16; i++) {
+					float d[3] = { block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2] };
+					covariance[0] += d[0] * d[0];
+					covariance[1] += d[0] * d[1];
+					covariance[2] += d[0] * d[2];
+					covariance[3] += d[1] * d[1];
+					covariance[4] += d[1] * d[2];
+					covariance[5] += d[2] * d[2];
+				}
+				// A few rounds of power iteration find the principal axis well enough for 4 colours
+				float axis[3] = { 1.0f, 1.0f, 1.0f };
+				for (int round = 0; round < 4; round++) {
+					float next[3] = {
+						covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+						covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+						covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+					};
+					float length = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]) });
+					if (length < 1e-6f) {
+						break;
+					}
+					for (int c = 0; c < 3; c++) {
+						axis[c] = next[c] / length;
+					}
+				}
+
+				float minProjection = 1e30f;
+				float maxProjection = -1e30f;
+				int minIndex = 0;
+				int maxIndex = 0;
+				for (int i = 0; i < 16; i++) {
+					float projection = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+					if (projection < minProjection) {
+						minProjection = projection;
+						minIndex = i;
+					}
+					if (projection > maxProjection) {
+						maxProjection = projection;
+						maxIndex = i;
+					}
+				}
+				float maxColour[3] = { float(block[maxIndex][0]), float(block[maxIndex][1]), float(block[maxIndex][2]) };
+				float minColour[3] = { float(block[minIndex][0]), float(block[minIndex][1]), float(block[minIndex][2]) };
+				uint16_t colour0 = packRGB565(maxColour);
+				uint16_t colour1 = packRGB565(minColour);
+				// colour0 > colour1 selects 4 colour mode. Equal endpoints can only be a flat block, so index 0 everywhere.
+				if (colour0 < colour1) {
+					std::swap(colour0, colour1);
+				}
+
+				uint8_t palette[4][4];
+				unpackRGB565(colour0, palette[0]);
+				unpackRGB565(colour1, palette[1]);
+				for (int c = 0; c < 4; c++) {
+					palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+					palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+				}
+
+				uint32_t indices = 0;
+				if (colour0 != colour1) {
+					uint8_t fit[16];
+					kernels.fitColours(block, palette, 4, 3, fit);
+					for (int i = 0; i < 16; i++) {
+						indices |= uint32_t(fit[i]) << (i * 2);
+					}
+				}
+				out[0] = static_cast<uint8_t>(colour0);
+				out[1] = static_cast<uint8_t>(colour0 >> 8);
+				out[2] = static_cast<uint8_t>(colour1);
+				out[3] = static_cast<uint8_t>(colour1 >> 8);
+				std::memcpy(out + 4, &indices, 4);
+			}
+
+			// BC4 (and BC3 alpha): 8 values interpolated between the block's extremes
+			void encodeValueBlock(const uint8_t values[16], uint8_t* out, const TextureKernelTable& kernels) {
+				int value0 = 0;
+				int value1 = 255;
+				for (int i = 0; i < 16; i++) {
+					value0 = std::max<int>(value0, values[i]);
+					value1 = std::min<int>(value1, values[i]);
+				}
+				uint8_t palette[8] = { static_cast<uint8_t>(value0), static_cast<uint8_t>(value1) };
+				for (int p = 1; p < 7; p++) {
+					palette[p + 1] = static_cast<uint8_t>(((7 - p) * value0 + p * value1) / 7);
+				}
+
+				uint64_t indices = 0;
+				if (value0 != value1) {
+					uint8_t fit[16];
+					kernels.fitValues(values, palette, fit);
+					for (int i = 0; i < 16; i++) {
+						indices |= uint64_t(fit[i]) << (i * 3);
+					}
+				}
+				out[0] = static_cast<uint8_t>(value0);
+				out[1] = static_cast<uint8_t>(value1);
+				for (int i = 0; i < 6; i++) {
+					out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+				}
+			}
+
+			void encodeChannelBlock(const uint8_t block[16][4], int channel, uint8_t* out, const TextureKernelTable& kernels) {
+				uint8_t values[16];
+				for (int i = 0; i < 16; i++) {
+					values[i] = block[i][channel];
+				}
+				encodeValueBlock(values, out, kernels);
+			}
+
+			// BC7 mode 6: one subset of RGBA endpoints at 7 bits plus a shared low bit each, and 16 weights
+			constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			struct BC7Endpoints {
+				uint8_t colour[2][4]; // 7 bits
+				uint8_t pBit[2];
+			};
+
+			// The closest 7 bit values and low bit to an endpoint
+			void quantiseEndpoint(const float endpoint[4], uint8_t colour[4], uint8_t& pBit) {
+				float bestError = 1e30f;
+				for (int p = 0; p < 2; p++) {
+					uint8_t quantised[4];
+					float error = 0.0f;
+					for (int c = 0; c < 4; c++) {
+						quantised[c] = static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround((endpoint[c] - p) / 2.0f)), 0, 127));
+						float d = float(quantised[c] * 2 + p) - endpoint[c];
+						error += d * d;
+					}
+					if (error < bestError) {
+						bestError = error;
+						std::memcpy(colour, quantised, 4);
+						pBit = static_cast<uint8_t>(p);
+					}
+				}
+			}
+
+			BC7Endpoints quantiseEndpoints(const float endpoints[2][4]) {
+				BC7Endpoints result;
+				quantiseEndpoint(endpoints[0], result.colour[0], result.pBit[0]);
+				quantiseEndpoint(endpoints[1], result.colour[1], result.pBit[1]);
+				return result;
+			}
+
+			// Fit the block to the endpoints' palette, returning the summed squared error
+			int fitBC7(const uint8_t block[16][4], const BC7Endpoints& endpoints, uint8_t indices[16], const TextureKernelTable& kernels) {
+				uint8_t palette[16][4];
+				for (int p = 0; p < 16; p++) {
+					for (int c = 0; c < 4; c++) {
+						int e0 = endpoints.colour[0][c] * 2 + endpoints.pBit[0];
+						int e1 = endpoints.colour[1][c] * 2 + endpoints.pBit[1];
+						palette[p][c] = static_cast<uint8_t>(((64 - BC7_WEIGHTS[p]) * e0 + BC7_WEIGHTS[p] * e1 + 32) >> 6);
+					}
+				}
+				kernels.fitColours(block, palette, 16, 4, indices);
+				int error = 0;
+				for (int i = 0; i < 16; i++) {
+					for (int c = 0; c < 4; c++) {
+						int d = block[i][c] - palette[indices[i]][c];
+						error += d * d;
+					}
+				}
+				return error;
+			}
+
+			class BitWriter {
+			public:
+				explicit BitWriter(uint8_t* out)
+					: m_out(out)
+					, m_position(0) {}
+
+				void write(uint32_t value, int bits) {
+					for (int i = 0; i < bits; i++, m_position++) {
+						m_out[m_position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (m_position & 7));
+					}
+				}
+
+			private:
+				uint8_t* m_out;
+				int m_position;
+			};
+
+			/*
+			 * Endpoints from the extremes of the block along its principal RGBA axis, then refined once by least
+			 * squares against the weights that fit picked.
+			 */
+			void encodeBC7Block(const uint8_t block[16][4], uint8_t* out, const TextureKernelTable& kernels) {
+				float mean[4] = {};
+				for (int i = 0; i < 16; i++) {
+					for (int c = 0; c < 4; c++) {
+						mean[c] += block[i][c] / 16.0f;
+					}
+				}
+				float covariance[4][4] = {};
+				for (int i = 0; i < 16; i++) {
+					for (int a = 0; a < 4; a++) {
+						for (int b = a; b < 4; b++) {
+							covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+						}
+					}
+				}
+				int widest = 0;
+				for (int a = 0; a < 4; a++) {
+					for (int b = 0; b < a; b++) {
+						covariance[a][b] = covariance[b][a];
+					}
+					if (covariance[a][a] > covariance[widest][widest]) {
+						widest = a;
+					}
+				}
+				// Starting from the channel that varies most, rather than the diagonal, which an axis like
+				// (1, -1, 0, 0) would be orthogonal to
+				float axis[4] = {};
+				axis[widest] = 1.0f;
+				for (int round = 0; round < 6; round++) {
+					float next[4] = {};
+					for (int a = 0; a < 4; a++) {
+						for (int b = 0; b < 4; b++) {
+							next[a] += covariance[a][b] * axis[b];
+						}
+					}
+					float length = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]), std::fabs(next[3]) });
+					if (length < 1e-6f) {
+						break;
+					}
+					for (int c = 0; c < 4; c++) {
+						axis[c] = next[c] / length;
+					}
+				}
+				float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+
+				float minProjection = 0.0f;
+				float maxProjection = 0.0f;
+				for (int i = 0; i < 16; i++) {
+					float projection = 0.0f;
+					for (int c = 0; c < 4; c++) {
+						projection += (block[i][c] - mean[c]) * axis[c];
+					}
+					minProjection = std::min(minProjection, projection / lengthSquared);
+					maxProjection = std::max(maxProjection, projection / lengthSquared);
+				}
+				float endpoints[2][4];
+				for (int c = 0; c < 4; c++) {
+					endpoints[0][c] = mean[c] + axis[c] * minProjection;
+					endpoints[1][c] = mean[c] + axis[c] * maxProjection;
+				}
+
+				BC7Endpoints best = quantiseEndpoints(endpoints);
+				uint8_t indices[16];
+				int bestError = fitBC7(block, best, indices, kernels);
+
+				// Least squares endpoints for the chosen weights, per channel
+				float a = 0.0f;
+				float b = 0.0f;
+				float d = 0.0f;
+				float x0[4] = {};
+				float x1[4] = {};
+				for (int i = 0; i < 16; i++) {
+					float w = BC7_WEIGHTS[indices[i]] / 64.0f;
+					a += (1.0f - w) * (1.0f - w);
+					b += (1.0f - w) * w;
+					d += w * w;
+					for (int c = 0; c < 4; c++) {
+						x0[c] += (1.0f - w) * block[i][c];
+						x1[c] += w * block[i][c];
+					}
+				}
+				float determinant = a * d - b * b;
+				if (bestError > 0 && std::fabs(determinant) > 1e-3f) {
+					for (int c = 0; c < 4; c++) {
+						endpoints[0][c] = std::clamp((d * x0[c] - b * x1[c]) / determinant, 0.0f, 255.0f);
+						endpoints[1][c] = std::clamp((a * x1[c] - b * x0[c]) / determinant, 0.0f, 255.0f);
+					}
+					BC7Endpoints refined = quantiseEndpoints(endpoints);
+					uint8_t refinedIndices[16];
+					int error = fitBC7(block, refined, refinedIndices, kernels);
+					if (error < bestError) {
+						best = refined;
+						std::memcpy(indices, refinedIndices, 16);
+					}
+				}
+
+				// The first index has an implied top bit of 0, so swap the endpoints if it would need it
+				if (indices[0] & 8) {
+					std::swap(best.colour[0], best.colour[1]);
+					std::swap(best.pBit[0], best.pBit[1]);
+					for (int i = 0; i < 16; i++) {
+						indices[i] = static_cast<uint8_t>(15 - indices[i]);
+					}
+				}
+
+				std::memset(out, 0, 16);
+				BitWriter writer(out);
+				writer.write(1 << 6, 7);
+				for (int c = 0; c < 4; c++) {
+					writer.write(best.colour[0][c], 7);
+					writer.write(best.colour[1][c], 7);
+				}
+				writer.write(best.pBit[0], 1);
+				writer.write(best.pBit[1], 1);
+				writer.write(indices[0], 3);
+				for (int i = 1; i < 16; i++) {
+					writer.write(indices[i], 4);
+				}
+			}
+		}
+
+		const TextureKernelTable scalarTextureKernels = {
+			downsampleRowsScalar,
+			scaleAlphaScalar,
+			fitColoursScalar,
+			fitValuesScalar
+		};
+
+		SimdLevel bestSimdLevel() {
+			static const SimdLevel best = isSimdLevelSupported(SimdLevel::AVX2) ? SimdLevel::AVX2
+				: isSimdLevelSupported(SimdLevel::SSE41) ? SimdLevel::SSE41 : SimdLevel::Scalar;
+			return best;
+		}
+
+		bool isSimdLevelSupported(SimdLevel level) {
+			switch (level) {
+			case SimdLevel::Scalar:
+				return true;
+#if defined(FRST_TEXTURE_KERNELS_X86)
+			case SimdLevel::SSE41:
+				return __builtin_cpu_supports("sse4.1");
+			case SimdLevel::AVX2:
+				return __builtin_cpu_supports("avx2");
+#endif
+			default:
+				return false;
+			}
+		}
+
+		const char* simdLevelName(SimdLevel level) {
+			switch (level) {
+			case SimdLevel::Scalar:
+				return "scalar";
+			case SimdLevel::SSE41:
+				return "SSE4.1";
+			case SimdLevel::AVX2:
+				return "AVX2";
+			}
+			return "unknown";
+		}
+
+		LinearImage toLinear(const Image& image, bool srgb) {
+			const LinearTables& tables = linearTables();
+			const uint16_t* colour = srgb ? tables.fromSrgb : tables.fromUnorm;
+			LinearImage result;
+			result.width = image.width;
+			result.height = image.height;
+			result.texels.resize(image.pixels.size());
+			for (size_t i = 0; i < image.pixels.size(); i += 4) {
+				result.texels[i] = colour[image.pixels[i]];
+				result.texels[i + 1] = colour[image.pixels[i + 1]];
+				result.texels[i + 2] = colour[image.pixels[i + 2]];
+				result.texels[i + 3] = tables.fromUnorm[image.pixels[i + 3]];
+			}
+			return result;
+		}
+
+		Image fromLinear(const LinearImage& image, bool srgb) {
+			const LinearTables& tables = linearTables();
+			const uint8_t* colour = srgb ? tables.toSrgb : tables.toUnorm;
+			Image result;
+			result.width = image.width;
+			result.height = image.height;
+			result.pixels.resize(image.texels.size());
+			for (size_t i = 0; i < image.texels.size(); i += 4) {
+				result.pixels[i] = colour[image.texels[i]];
+				result.pixels[i + 1] = colour[image.texels[i + 1]];
+				result.pixels[i + 2] = colour[image.texels[i + 2]];
+				result.pixels[i + 3] = tables.toUnorm[image.texels[i + 3]];
+			}
+			return result;
+		}
+
+		LinearImage downsample(const LinearImage& image, WorkForce::WorkerPool* pool, SimdLevel level) {
+			const TextureKernelTable& kernels = kernelTable(level);
+			LinearImage result;
+			result.width = std::max(1u, image.width / 2);
+			result.height = std::max(1u, image.height / 2);
+			result.texels.resize(size_t(result.width) * result.height * 4);
+
+			auto row = [&](size_t y) {
+				size_t y0 = std::min<size_t>(y * 2, image.height - 1);
+				size_t y1 = std::min<size_t>(y * 2 + 1, image.height - 1);
+				kernels.downsampleRows(&image.texels[y0 * image.width * 4], &image.texels[y1 * image.width * 4], image.width,
+					&result.texels[y * result.width * 4], result.width);
+			};
+			if (pool) {
+				// Around 16K texels per piece of work, so that small mips are not worth splitting
+				size_t grain = std::max<size_t>(1, 16384 / result.width);
+				WorkForce::parallelFor(*pool, WorkForce::Range{ 0, result.height }, grain, row);
+			} else {
+				for (size_t y = 0; y < result.height; y++) {
+					row(y);
+				}
+			}
+			return result;
+		}
+
+		float alphaCoverage(const Image& image, uint8_t threshold) {
+			size_t count = image.pixels.size() / 4;
+			if (count == 0) {
+				return 0.0f;
+			}
+			size_t covered = 0;
+			for (size_t i = 3; i < image.pixels.size(); i += 4) {
+				covered += image.pixels[i] >= threshold;
+			}
+			return float(double(covered) / count);
+		}
+
+		void scaleAlphaToCoverage(Image& image, float coverage, uint8_t threshold, SimdLevel level) {
+			const TextureKernelTable& kernels = kernelTable(level);
+			size_t count = image.pixels.size() / 4;
+			if (count == 0 || threshold == 0) {
+				return;
+			}
+			size_t histogram[256] = {};
+			for (size_t i = 3; i < image.pixels.size(); i += 4) {
+				histogram[image.pixels[i]]++;
+			}
+
+			// The alpha that, as the threshold, would keep as many pixels as wanted. Scaling it up (or down) to
+			// the real threshold then keeps those pixels.
+			double target = double(coverage) * count;
+			size_t covered = 0;
+			int bestAlpha = 255;
+			double bestDistance = 1e30;
+			for (int alpha = 255; alpha >= 1; alpha--) {
+				covered += histogram[alpha];
+				double distance = std::fabs(double(covered) - target);
+				if (distance < bestDistance || (distance == bestDistance && std::abs(alpha - threshold) < std::abs(bestAlpha - threshold))) {
+					bestDistance = distance;
+					bestAlpha = alpha;
+				}
+			}
+			if (bestAlpha == threshold) {
+				return;
+			}
+			// Rounded up, so that bestAlpha itself lands on the threshold
+			uint32_t scale = (uint32_t(threshold) * 256 + bestAlpha - 1) / bestAlpha;
+			kernels.scaleAlpha(image.pixels.data(), count, scale);
+		}
+
+		std::vector<uint8_t> compressBlocks(const Image& image, TextureFormat format, WorkForce::WorkerPool* pool, SimdLevel level) {
+			if (format == TextureFormat::RGBA8) {
+				throw std::logic_error("compressBlocks: RGBA8 is not block compressed");
+			}
+			const TextureKernelTable& kernels = kernelTable(level);
+			uint32_t blocksWide = (image.width + 3) / 4;
+			uint32_t blocksHigh = (image.height + 3) / 4;
+			size_t blockSize = textureMipSize(format, 4, 4);
+			std::vector<uint8_t> out(size_t(blocksWide) * blocksHigh * blockSize);
+
+			auto row = [&](size_t by) {
+				uint8_t block[16][4];
+				for (uint32_t bx = 0; bx < blocksWide; bx++) {
+					// Edge blocks repeat the last row and column
+					for (uint32_t i = 0; i < 16; i++) {
+						uint32_t x = std::min(bx * 4 + i % 4, image.width - 1);
+						uint32_t y = std::min(uint32_t(by) * 4 + i / 4, image.height - 1);
+						std::memcpy(block[i], image.pixel(x, y), 4);
+					}
+					uint8_t* destination = &out[(by * blocksWide + bx) * blockSize];
+					switch (format) {
+					case TextureFormat::BC1:
+						encodeColourBlock(block, destination, kernels);
+						break;
+					case TextureFormat::BC3:
+						encodeChannelBlock(block, 3, destination, kernels);
+						encodeColourBlock(block, destination + 8, kernels);
+						break;
+					case TextureFormat::BC4:
+						encodeChannelBlock(block, 0, destination, kernels);
+						break;
+					case TextureFormat::BC5:
+						encodeChannelBlock(block, 0, destination, kernels);
+						encodeChannelBlock(block, 1, destination + 8, kernels);
+						break;
+					case TextureFormat::BC7:
+						encodeBC7Block(block, destination, kernels);
+						break;
+					default:
+						break;
+					}
+				}
+			};
+			if (pool) {
+				// Around 64 blocks per piece of work
+				size_t grain = std::max<size_t>(1, 64 / blocksWide);
+				WorkForce::parallelFor(*pool, WorkForce::Range{ 0, blocksHigh }, grain, row);
+			} else {
+				for (size_t by = 0; by < blocksHigh; by++) {
+					row(by);
+				}
+			}
+			return out;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+// Built with -mavx2. See TextureKernelTable.hpp for why this file includes almost nothing.
+#include "TextureKernelTable.hpp"
+
+#if defined(FRST_TEXTURE_KERNELS_X86)
+
+#include <immintrin.h>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			void downsampleRowsAVX2(const uint16_t* row0, const uint16_t* row1, uint32_t inWidth, uint16_t* out, uint32_t outWidth) {
+				const __m256i round = _mm256_set1_epi16(2);
+				// Whole 2x2 footprints, four output texels at a time. 14 bit texels leave room to sum four in 16 bits.
+				uint32_t pairs = inWidth / 2 < outWidth ? inWidth / 2 : outWidth;
+				uint32_t x = 0;
+				for (; x + 4 <= pairs; x += 4) {
+					__m256i a = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x * 8)),
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x * 8)));
+					__m256i b = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x * 8 + 16)),
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x * 8 + 16)));
+					// Unpacking works within 128 bit lanes, giving outputs 0, 2, 1, 3
+					__m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(a, b), _mm256_unpackhi_epi64(a, b));
+					sum = _mm256_permute4x64_epi64(sum, _MM_SHUFFLE(3, 1, 2, 0));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), _mm256_srli_epi16(_mm256_add_epi16(sum, round), 2));
+				}
+				for (; x < outWidth; x++) {
+					uint32_t x0 = x * 2 < inWidth ? x * 2 : inWidth - 1;
+					uint32_t x1 = x * 2 + 1 < inWidth ? x * 2 + 1 : inWidth - 1;
+					for (uint32_t c = 0; c < 4; c++) {
+						out[x * 4 + c] = static_cast<uint16_t>((row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) >> 2);
+					}
+				}
+			}
+
+			void scaleAlphaAVX2(uint8_t* pixels, size_t count, uint32_t scale) {
+				const __m256i factor = _mm256_set1_epi32(static_cast<int>(scale));
+				const __m256i maximum = _mm256_set1_epi32(255);
+				const __m256i colourMask = _mm256_set1_epi32(0x00ffffff);
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8) {
+					__m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+					__m256i alpha = _mm256_min_epu32(_mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(texels, 24), factor), 8), maximum);
+					texels = _mm256_or_si256(_mm256_and_si256(texels, colourMask), _mm256_slli_epi32(alpha, 24));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), texels);
+				}
+				for (; i < count; i++) {
+					uint32_t alpha = (pixels[i * 4 + 3] * scale) >> 8;
+					pixels[i * 4 + 3] = static_cast<uint8_t>(alpha < 255 ? alpha : 255);
+				}
+			}
+
+			/*
+			 * As fitColoursSSE41, with four pixels per register. The horizontal add works within 128 bit lanes, so
+			 * errors come out as pixels 0, 1, 4, 5, 2, 3, 6, 7 and are put back in order at the end.
+			 */
+			void fitColoursAVX2(const uint8_t pixels[16][4], const uint8_t palette[][4], int paletteSize, int channels, uint8_t indices[16]) {
+				const __m256i channelMask = channels == 4 ? _mm256_set1_epi32(-1) : _mm256_set1_epi64x(0x0000ffffffffffff);
+				__m256i wide[4];
+				for (int k = 0; k < 4; k++) {
+					wide[k] = _mm256_and_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels[k * 4]))), channelMask);
+				}
+
+				__m256i bestError[2];
+				__m256i bestIndex[2];
+				for (int k = 0; k < 2; k++) {
+					bestError[k] = _mm256_set1_epi32(0x7fffffff);
+					bestIndex[k] = _mm256_setzero_si256();
+				}
+				for (int p = 0; p < paletteSize; p++) {
+					int entry;
+					__builtin_memcpy(&entry, palette[p], 4);
+					__m256i colour = _mm256_and_si256(_mm256_cvtepu8_epi16(_mm_set1_epi32(entry)), channelMask);
+					__m256i index = _mm256_set1_epi32(p);
+					for (int k = 0; k < 2; k++) {
+						__m256i d0 = _mm256_sub_epi16(wide[k * 2], colour);
+						__m256i d1 = _mm256_sub_epi16(wide[k * 2 + 1], colour);
+						__m256i error = _mm256_hadd_epi32(_mm256_madd_epi16(d0, d0), _mm256_madd_epi16(d1, d1));
+						__m256i better = _mm256_cmpgt_epi32(bestError[k], error);
+						bestError[k] = _mm256_min_epi32(error, bestError[k]);
+						bestIndex[k] = _mm256_blendv_epi8(bestIndex[k], index, better);
+					}
+				}
+				const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+				__m256i first = _mm256_permutevar8x32_epi32(bestIndex[0], order);
+				__m256i second = _mm256_permutevar8x32_epi32(bestIndex[1], order);
+				// Packing is also per lane: 0-3, 8-11, 4-7, 12-15 as 16 bits
+				__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+				__m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bytes);
+			}
+
+			// 16 values fill one 128 bit register, so this is the SSE4.1 version, VEX encoded
+			void fitValuesAVX2(const uint8_t values[16], const uint8_t palette[8], uint8_t indices[16]) {
+				const __m128i allOnes = _mm_set1_epi32(-1);
+				__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+				__m128i entry = _mm_set1_epi8(static_cast<char>(palette[0]));
+				__m128i bestError = _mm_or_si128(_mm_subs_epu8(value, entry), _mm_subs_epu8(entry, value));
+				__m128i bestIndex = _mm_setzero_si128();
+				for (int p = 1; p < 8; p++) {
+					entry = _mm_set1_epi8(static_cast<char>(palette[p]));
+					__m128i error = _mm_or_si128(_mm_subs_epu8(value, entry), _mm_subs_epu8(entry, value));
+					__m128i better = _mm_xor_si128(_mm_cmpeq_epi8(_mm_max_epu8(error, bestError), error), allOnes);
+					bestError = _mm_min_epu8(error, bestError);
+					bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi8(static_cast<char>(p)), better);
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+			}
+		}
+
+		const TextureKernelTable avx2TextureKernels = {
+			downsampleRowsAVX2,
+			scaleAlphaAVX2,
+			fitColoursAVX2,
+			fitValuesAVX2
+		};
+	}
+}
+
+#endif
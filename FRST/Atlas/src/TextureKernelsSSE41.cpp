@@ -0,0 +1,115 @@
+// Built with -msse4.1. See TextureKernelTable.hpp for why this file includes almost nothing.
+#include "TextureKernelTable.hpp"
+
+#if defined(FRST_TEXTURE_KERNELS_X86)
+
+#include <immintrin.h>
+
+namespace FRST {
+	namespace Atlas {
+		namespace {
+			void downsampleRowsSSE41(const uint16_t* row0, const uint16_t* row1, uint32_t inWidth, uint16_t* out, uint32_t outWidth) {
+				const __m128i round = _mm_set1_epi16(2);
+				// Whole 2x2 footprints, two output texels at a time. 14 bit texels leave room to sum four in 16 bits.
+				uint32_t pairs = inWidth / 2 < outWidth ? inWidth / 2 : outWidth;
+				uint32_t x = 0;
+				for (; x + 2 <= pairs; x += 2) {
+					__m128i a = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8)));
+					__m128i b = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 8)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 8)));
+					__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_srli_epi16(_mm_add_epi16(sum, round), 2));
+				}
+				for (; x < outWidth; x++) {
+					uint32_t x0 = x * 2 < inWidth ? x * 2 : inWidth - 1;
+					uint32_t x1 = x * 2 + 1 < inWidth ? x * 2 + 1 : inWidth - 1;
+					for (uint32_t c = 0; c < 4; c++) {
+						out[x * 4 + c] = static_cast<uint16_t>((row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) >> 2);
+					}
+				}
+			}
+
+			void scaleAlphaSSE41(uint8_t* pixels, size_t count, uint32_t scale) {
+				const __m128i factor = _mm_set1_epi32(static_cast<int>(scale));
+				const __m128i maximum = _mm_set1_epi32(255);
+				const __m128i colourMask = _mm_set1_epi32(0x00ffffff);
+				size_t i = 0;
+				for (; i + 4 <= count; i += 4) {
+					__m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+					__m128i alpha = _mm_min_epu32(_mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(texels, 24), factor), 8), maximum);
+					texels = _mm_or_si128(_mm_and_si128(texels, colourMask), _mm_slli_epi32(alpha, 24));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), texels);
+				}
+				for (; i < count; i++) {
+					uint32_t alpha = (pixels[i * 4 + 3] * scale) >> 8;
+					pixels[i * 4 + 3] = static_cast<uint8_t>(alpha < 255 ? alpha : 255);
+				}
+			}
+
+			/*
+			 * Pixels are widened to 16 bits, two per register, so that _mm_madd_epi16 squares and sums channel pairs.
+			 * A horizontal add of two registers then gives 4 pixels' errors, in order.
+			 */
+			void fitColoursSSE41(const uint8_t pixels[16][4], const uint8_t palette[][4], int paletteSize, int channels, uint8_t indices[16]) {
+				const __m128i channelMask = channels == 4 ? _mm_set1_epi32(-1) : _mm_set1_epi64x(0x0000ffffffffffff);
+				__m128i wide[8];
+				for (int k = 0; k < 4; k++) {
+					__m128i four = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels[k * 4]));
+					wide[k * 2] = _mm_and_si128(_mm_cvtepu8_epi16(four), channelMask);
+					wide[k * 2 + 1] = _mm_and_si128(_mm_cvtepu8_epi16(_mm_srli_si128(four, 8)), channelMask);
+				}
+
+				__m128i bestError[4];
+				__m128i bestIndex[4];
+				for (int k = 0; k < 4; k++) {
+					bestError[k] = _mm_set1_epi32(0x7fffffff);
+					bestIndex[k] = _mm_setzero_si128();
+				}
+				for (int p = 0; p < paletteSize; p++) {
+					int entry;
+					__builtin_memcpy(&entry, palette[p], 4);
+					__m128i colour = _mm_and_si128(_mm_cvtepu8_epi16(_mm_set1_epi32(entry)), channelMask);
+					__m128i index = _mm_set1_epi32(p);
+					for (int k = 0; k < 4; k++) {
+						__m128i d0 = _mm_sub_epi16(wide[k * 2], colour);
+						__m128i d1 = _mm_sub_epi16(wide[k * 2 + 1], colour);
+						__m128i error = _mm_hadd_epi32(_mm_madd_epi16(d0, d0), _mm_madd_epi16(d1, d1));
+						__m128i better = _mm_cmplt_epi32(error, bestError[k]);
+						bestError[k] = _mm_min_epi32(error, bestError[k]);
+						bestIndex[k] = _mm_blendv_epi8(bestIndex[k], index, better);
+					}
+				}
+				__m128i low = _mm_packs_epi32(bestIndex[0], bestIndex[1]);
+				__m128i high = _mm_packs_epi32(bestIndex[2], bestIndex[3]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_packus_epi16(low, high));
+			}
+
+			void fitValuesSSE41(const uint8_t values[16], const uint8_t palette[8], uint8_t indices[16]) {
+				const __m128i allOnes = _mm_set1_epi32(-1);
+				__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+				__m128i entry = _mm_set1_epi8(static_cast<char>(palette[0]));
+				__m128i bestError = _mm_or_si128(_mm_subs_epu8(value, entry), _mm_subs_epu8(entry, value));
+				__m128i bestIndex = _mm_setzero_si128();
+				for (int p = 1; p < 8; p++) {
+					entry = _mm_set1_epi8(static_cast<char>(palette[p]));
+					__m128i error = _mm_or_si128(_mm_subs_epu8(value, entry), _mm_subs_epu8(entry, value));
+					// Unsigned error < bestError, as not max(error, bestError) == error
+					__m128i better = _mm_xor_si128(_mm_cmpeq_epi8(_mm_max_epu8(error, bestError), error), allOnes);
+					bestError = _mm_min_epu8(error, bestError);
+					bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi8(static_cast<char>(p)), better);
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+			}
+		}
+
+		const TextureKernelTable sse41TextureKernels = {
+			downsampleRowsSSE41,
+			scaleAlphaSSE41,
+			fitColoursSSE41,
+			fitValuesSSE41
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Packs a Data folder into an archive that AssetManager::mountArchive() can map.
+ *
+ *   Atlas_pack <data directory> <archive>            pack every file below the directory, LZ4 compressed
+ *   Atlas_pack --store <data directory> <archive>    the same, but without compressing anything
+ *   Atlas_pack --list <archive>                      print the contents of an archive
+ *
+ * Assets are stored under their path relative to the data directory, with '/' separators, which is the same
+ * path that is passed to AssetManager::load(). Files are packed in path order, so that a folder's files sit
+ * next to each other in the archive.
+ */
+
+#include "Atlas/Archive.hpp"
+#include "Atlas/ArchiveWriter.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace FRST::Atlas;
+
+namespace {
+	int usage() {
+		std::fprintf(stderr, "usage: Atlas_pack [--store] <data directory> <archive>\n       Atlas_pack --list <archive>\n");
+		return 2;
+	}
+
+	int list(const std::string& archivePath) {
+		Archive archive(archivePath);
+		std::vector<const ArchiveEntry*> entries;
+		for (const ArchiveEntry& entry : archive.slots()) {
+			if (!entry.empty()) {
+				entries.push_back(&entry);
+			}
+		}
+		std::sort(entries.begin(), entries.end(), [](const ArchiveEntry* a, const ArchiveEntry* b) {
+			return a->offset < b->offset;
+		});
+		for (const ArchiveEntry* entry : entries) {
+			std::string_view path = archive.assetPath(*entry);
+			std::printf("%016" PRIx64 " %12" PRIu64 " %12" PRIu64 " %s %.*s\n", entry->uuid, entry->size, entry->storedSize,
+				entry->compressed() ? "lz4 " : "none", static_cast<int>(path.size()), path.data());
+		}
+		std::printf("%zu assets\n", archive.size());
+		return 0;
+	}
+
+	int pack(const std::filesystem::path& dataDirectory, const std::string& archivePath, ArchiveCompression compression) {
+		std::vector<std::filesystem::path> files;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(dataDirectory)) {
+			if (entry.is_regular_file()) {
+				files.push_back(entry.path());
+			}
+		}
+		std::sort(files.begin(), files.end());
+
+		ArchiveWriter writer(compression);
+		for (const std::filesystem::path& file : files) {
+			std::ifstream stream(file, std::ios::binary);
+			if (!stream) {
+				std::fprintf(stderr, "cannot read %s\n", file.c_str());
+				return 1;
+			}
+			std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+			writer.add(std::filesystem::relative(file, dataDirectory).generic_string(), std::move(data));
+		}
+		writer.write(archivePath);
+		std::printf("packed %zu assets (%" PRIu64 " bytes, %" PRIu64 " stored) into %s\n", writer.size(), writer.totalSize(),
+			writer.totalStoredSize(), archivePath.c_str());
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	try {
+		if (argc == 3 && std::string(argv[1]) == "--list") {
+			return list(argv[2]);
+		}
+		if (argc == 4 && std::string(argv[1]) == "--store") {
+			return pack(argv[2], argv[3], ArchiveCompression::None);
+		}
+		if (argc == 3) {
+			return pack(argv[1], argv[2], ArchiveCompression::LZ4);
+		}
+		return usage();
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
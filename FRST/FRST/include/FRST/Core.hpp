@@ -1,11 +1,16 @@
 #pragma once
 
 #include "SDL.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
 #include <vulkan/vulkan.hpp>
 
 #include "Interactions/ControllerManager.hpp"
 #include "Interactions/InputEvent.hpp"
 #include "Interactions/WindowSystem.hpp"
+#include "WorkForce/SpscRing.hpp"
+#include "WorkForce/WorkerPool.hpp"
 
 
 namespace FRST {
@@ -18,8 +23,20 @@ namespace FRST {
 		~Core() noexcept;
 
 		// Run the game
+		// Must be called on the thread that created the window, which then collects input until the game quits.
+		// Frames run on a thread of their own.
+		// Throws std::runtime_error if input was being recorded and the recording could not be written in full.
 		void run();
 
+		// Record all input to path while the game runs. Call before run().
+		// Throws std::runtime_error if the file cannot be created.
+		void recordInput(const std::string& path);
+
+		// Take input from a recording at path instead of from SDL, and quit once all of it has been used. Call before run().
+		// A fast replay steps frames through the recording at a fixed rate, so that every run gets the same frames.
+		// Throws std::runtime_error if the recording cannot be read.
+		void replayInput(const std::string& path, Interactions::WindowSystem::ReplaySpeed speed);
+
 		// Quit the game
 		// This tells the gameloop to quit. It may actually take some time (up to a full frame) to actually quit the game.
 		// The implementation will preferrably be decoupled from the job scheduling system
@@ -27,10 +44,27 @@ namespace FRST {
 		void quit();
 
 	private:
+		// A second of events from an 8 kHz mouse, in case frames stall
+		static constexpr size_t INPUT_RING_CAPACITY = 8192;
+		// How long the input thread waits for SDL before checking whether the game is still running
+		static constexpr int INPUT_WAIT_MS = 1;
+		// How far each frame of a fast replay moves through the recording: the live loop's pacing
+		static constexpr uint64_t REPLAY_FRAME_NS = 10000000;
+
+		// The input thread: collects events as SDL receives them, handles the immediate ones,
+		// and hands game events to the frame thread through m_inputEvents
+		void collectInput();
+		// The frame thread: takes each frame's events, builds its InputState and starts its jobs
+		void runFrames();
+
 		Interactions::WindowSystem m_ws;
 		Interactions::ControllerManager m_controllerManager;
+		WorkForce::WorkerPool m_workerPool;
+
+		// Timestamped game events, from the input thread to the frame thread
+		WorkForce::SpscRing<Interactions::InputEvent> m_inputEvents;
 
 		// Whether the game is currently running
-		bool m_running;
+		std::atomic<bool> m_running;
 	};
 }
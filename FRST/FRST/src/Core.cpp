@@ -1,10 +1,18 @@
 #include "FRST/Core.hpp"
+#include <Interactions/InputEventRing.hpp>
 #include <Interactions/InputState.hpp>
+#include <WorkForce/Trace.hpp>
+
+#include <thread>
+#include <vector>
 
 namespace FRST {
 	Core::Core(vk::Instance* instance, vk::SurfaceKHR* surface, SDL_Window* window)
 		: m_ws(window)
-		, m_controllerManager() {
+		, m_controllerManager()
+		, m_workerPool()
+		, m_inputEvents(INPUT_RING_CAPACITY)
+		, m_running(false) {
 	}
 
 	Core::~Core() noexcept {
@@ -12,48 +20,121 @@ namespace FRST {
 
 	void Core::run() {
 		m_running = true;
-		int total_events = 0;
+		// SDL only hands the window's events to the thread that created it, so that thread collects input
+		// and frames move to another one. Input is then sampled as it arrives instead of once per frame.
+		std::thread frames(&Core::runFrames, this);
+		collectInput();
+		frames.join();
+		m_ws.stopRecording();
+	}
+
+	void Core::recordInput(const std::string& path) {
+		m_ws.startRecording(path);
+	}
+
+	void Core::replayInput(const std::string& path, Interactions::WindowSystem::ReplaySpeed speed) {
+		m_ws.startReplay(path, speed);
+	}
 
-		// Queues for handling events
-		std::queue<Interactions::InputEvent*> gameEvents;
-		std::queue<Interactions::InputEvent*> immediateEvents;
+	void Core::collectInput() {
+		WorkForce::Trace::setThreadName("Input");
 
-		Interactions::InputState* lastFrameState = new Interactions::InputState();
+		// Game events stay here only while the frame thread is too far behind to take them
+		std::vector<Interactions::InputEvent> gameEvents;
+		gameEvents.reserve(INPUT_RING_CAPACITY);
+		std::vector<Interactions::InputEvent> immediateEvents;
+		immediateEvents.reserve(64);
 
 		while (m_running) {
+			{
+				FRST_TRACE_SCOPE("Poll events");
+				m_ws.waitForEvents(gameEvents, immediateEvents, INPUT_WAIT_MS);
 
-			int num_events = m_ws.getPendingEvents(gameEvents, immediateEvents);
+				// Handle immediate events
+				for (const Interactions::InputEvent& event : immediateEvents) {
+					if (event.isControllerModificationEvent()) {
+						m_controllerManager.handleControllerEvent(event);
+					} else if (event.isWindowEvent()) {
+						m_ws.handleWindowEvent(event);
+					} else if (event.control.type == Interactions::InputEvent::Type::QUIT) {
+						// We quit here on this thread to hopefully exit well when the user asks us to.
+						// A replay quits once the frame thread has used all of it instead, which a fast one may not have yet.
+						if (!m_ws.isReplaying()) {
+							quit();
+						}
+					}
+				}
+				immediateEvents.clear();
+			}
 
-			// Handle immediate events
-			while (!immediateEvents.empty()) {
-				Interactions::InputEvent* event = immediateEvents.front();
-				immediateEvents.pop();
+			// Hand game events over in order. Whatever does not fit waits for the next round, so that this
+			// thread keeps pumping SDL (and noticing QUIT) even while frames stall.
+			size_t handed = 0;
+			while (handed < gameEvents.size() && m_inputEvents.push(gameEvents[handed])) {
+				handed++;
+			}
+			gameEvents.erase(gameEvents.begin(), gameEvents.begin() + handed);
 
-				if (event->isControllerModificationEvent()) {
-					m_controllerManager.handleControllerEvent(event);
-				} else if (event->isWindowEvent()) {
-					m_ws.handleWindowEvent(event);
-				} else if (event->control.type == Interactions::InputEvent::Type::QUIT) {
-					// We quit here on this thread to hopefully exit well when the user asks us to.
-					quit();
+			// A replay ends the game once the frame thread has taken all of it
+			if (m_ws.replayFinished() && gameEvents.empty() && m_inputEvents.empty()) {
+				quit();
+			}
+		}
+	}
+
+	void Core::runFrames() {
+		size_t total_events = 0;
+		WorkForce::Trace::setThreadName("Main");
+
+		// Game events are kept for as long as a frame that reads them may still be running.
+		// The buffers are reused every frame, so taking events does not allocate once they have grown.
+		Interactions::InputEventRing gameEvents(m_workerPool.framesInFlight() + 1);
+
+		// Input state is a few KB of plain arrays, so each frame copies the last one and applies its events
+		Interactions::InputState lastFrameState;
+
+		// Fast replays sample input at fixed steps through the recording, so that frames do not depend on timing
+		bool fixedStep = m_ws.isReplaying() && m_ws.replaySpeed() == Interactions::WindowSystem::ReplaySpeed::AsFastAsPossible;
+		uint64_t replayTime = m_ws.replayStartTime();
+
+		while (m_running) {
+			std::vector<Interactions::InputEvent>& frameEvents = gameEvents.beginFrame();
+			{
+				FRST_TRACE_SCOPE("Take input");
+				// The frame sees everything that happened up to its sample time, and nothing after.
+				// Events are timestamped on the clock of Trace::now().
+				uint64_t sampleTime = fixedStep ? (replayTime += REPLAY_FRAME_NS) : WorkForce::Trace::now();
+				while (true) {
+					const Interactions::InputEvent* event = m_inputEvents.front();
+					if (event == nullptr) {
+						// Events come in order, and a fast replay may not have handed over the rest up to the sample time yet
+						if (fixedStep && m_running) {
+							std::this_thread::yield();
+							continue;
+						}
+						break;
+					}
+					if (event->timestamp > sampleTime) {
+						break;
+					}
+					frameEvents.push_back(*event);
+					m_inputEvents.pop();
 				}
-				delete event;
 			}
+			total_events += frameEvents.size();
 
-			std::vector<Interactions::InputEvent*> packagedEvents;
-			packagedEvents.reserve(gameEvents.size());
-			while (!gameEvents.empty()) {
-				Interactions::InputEvent* event = gameEvents.front();
-				gameEvents.pop();
-				packagedEvents.push_back(event);
+			{
+				FRST_TRACE_SCOPE("Build InputState");
+				lastFrameState = Interactions::InputState(lastFrameState, frameEvents);
 			}
-			total_events += num_events;
 
-			Interactions::InputState* frameState = new Interactions::InputState(*lastFrameState, packagedEvents);
-			delete lastFrameState; // TODO This is a temporary clean up while we do nothing with the state right now.
-			lastFrameState = frameState;
+			// Start this frame's jobs on the workers. This only blocks while too many frames are still in flight.
+			m_workerPool.beginFrame();
 
-			SDL_Delay(10);
+			// Frame pacing only. Input keeps being collected on the input thread meanwhile.
+			if (!fixedStep) {
+				SDL_Delay(10);
+			}
 		}
 	}
 
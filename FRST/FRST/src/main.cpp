@@ -41,7 +41,9 @@ Create and destroy a Vulkan surface on an SDL window.
 #include <SDL_syswm.h>
 #include <vulkan/vulkan.hpp>
 
+#include <cstring>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "FRST/Core.hpp"
@@ -49,9 +51,32 @@ Create and destroy a Vulkan surface on an SDL window.
 vk::SurfaceKHR createVulkanSurface(const vk::Instance& instance, SDL_Window* window);
 std::vector<const char*> getAvailableWSIExtensions();
 
-int main() {
-    // Use validation layers if this is a debug build, and use WSI extensions regardless
-    std::vector<const char*> extensions = getAvailableWSIExtensions();
+int main(int argc, char** argv) {
+    // Input recording and replay, see WindowSystem
+    std::string recordPath;
+    std::string replayPath;
+    auto replaySpeed = FRST::Interactions::WindowSystem::ReplaySpeed::RealTime;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay-fast") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+            replaySpeed = FRST::Interactions::WindowSystem::ReplaySpeed::AsFastAsPossible;
+        } else {
+            std::cout << "usage: FRST [--record file] [--replay file | --replay-fast file]" << std::endl;
+            return 2;
+        }
+    }
+    // Replays need no window, so that they can run on machines without a display
+    bool headless = !replayPath.empty();
+
+    // Use validation layers if this is a debug build, and use WSI extensions unless there is no window to present to
+    std::vector<const char*> extensions;
+    if(!headless) {
+        extensions = getAvailableWSIExtensions();
+    }
     std::vector<const char*> layers;
 #if defined(_DEBUG)
     layers.push_back("VK_LAYER_LUNARG_standard_validation");
@@ -82,41 +107,63 @@ int main() {
         instance = vk::createInstance(instInfo);
     } catch(const std::exception& e) {
         std::cout << "Could not create a Vulkan instance: " << e.what() << std::endl;
-        return 1;
+        // Nothing a replay runs needs Vulkan yet, so it goes on without, on machines with no driver at all
+        if(!headless) {
+            return 1;
+        }
     }
 
     // Create an SDL window that supports Vulkan and OpenGL rendering.
-    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0) {
+    if(SDL_Init(headless ? SDL_INIT_GAMECONTROLLER : SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) != 0) {
         std::cout << "Could not initialize SDL." << std::endl;
         return 1;
     }
-    SDL_Window* window = SDL_CreateWindow("FRST", SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED, 1280, 720, SDL_WINDOW_OPENGL);
-    if(window == NULL) {
-        std::cout << "Could not create SDL window." << std::endl;
-        return 1;
-    }
-
-    // Create a Vulkan surface for rendering
+    SDL_Window* window = NULL;
     vk::SurfaceKHR surface;
-    try {
-        surface = createVulkanSurface(instance, window);
-    } catch(const std::exception& e) {
-        std::cout << "Failed to create Vulkan surface: " << e.what() << std::endl;
-        instance.destroy();
-        return 1;
+    if(!headless) {
+        window = SDL_CreateWindow("FRST", SDL_WINDOWPOS_CENTERED,
+            SDL_WINDOWPOS_CENTERED, 1280, 720, SDL_WINDOW_OPENGL);
+        if(window == NULL) {
+            std::cout << "Could not create SDL window." << std::endl;
+            return 1;
+        }
+
+        // Create a Vulkan surface for rendering
+        try {
+            surface = createVulkanSurface(instance, window);
+        } catch(const std::exception& e) {
+            std::cout << "Failed to create Vulkan surface: " << e.what() << std::endl;
+            instance.destroy();
+            return 1;
+        }
     }
 
     // This is where most initializtion for a program should be performed
 	auto game = new FRST::Core(&instance, &surface, window);
-	game->run(); // Run returning means the game has closed
+	int result = 0;
+	try {
+		if (!recordPath.empty()) {
+			game->recordInput(recordPath);
+		}
+		if (!replayPath.empty()) {
+			game->replayInput(replayPath, replaySpeed);
+		}
+		game->run(); // Run returning means the game has closed
+	} catch(const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		result = 1;
+	}
 
     // Clean up.
 	delete game;
-    instance.destroySurfaceKHR(surface);
-    SDL_DestroyWindow(window);
+    if(window != NULL) {
+        instance.destroySurfaceKHR(surface);
+        SDL_DestroyWindow(window);
+    }
     SDL_Quit();
-    instance.destroy();
+    if(instance) {
+        instance.destroy();
+    }
 
 #ifdef _WIN32
 #ifdef _DEBUG
@@ -129,7 +176,7 @@ int main() {
 #endif
 #endif
 
-    return 0;
+    return result;
 }
 
 vk::SurfaceKHR createVulkanSurface(const vk::Instance& instance, SDL_Window* window)
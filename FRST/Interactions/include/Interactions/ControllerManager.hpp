@@ -18,7 +18,7 @@ namespace FRST {
 			~ControllerManager();
 
 			// Handle controller modification events like being disconnected/connected.
-			void handleControllerEvent(InputEvent* event);
+			void handleControllerEvent(const InputEvent& event);
 		private:
 			void initControllers();
 
@@ -2,6 +2,7 @@
 
 #include "SDL.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <tuple>
@@ -53,12 +54,28 @@ namespace FRST {
 			// Pressed or unpressed for buttons
 			bool active;
 
+			// When the event was collected, in nanoseconds on std::chrono::steady_clock (as WorkForce::Trace::now()).
+			// Set by WindowSystem, 0 until then.
+			uint64_t timestamp;
+
+			// An unsupported event, so that buffers of events can be made up front
+			InputEvent();
 			// Create an InputEvent from an SDL_Event
 			InputEvent(SDL_Event* event);
 			// Create a default state InputEvent
 			InputEvent(Control control);
-			// Make a copy of another InputEvent
-			InputEvent(const InputEvent& other);
+			// InputEvents are plain values, so that a frame's events can be kept in one reusable buffer.
+			// See carriedOver() for copying a state into the next frame.
+			InputEvent(const InputEvent& other) = default;
+			InputEvent& operator=(const InputEvent& other) = default;
+
+			// This state as it starts the next frame: the same, without this frame's change
+			inline InputEvent carriedOver() const {
+				InputEvent next(*this);
+				next.dx = 0;
+				next.dy = 0;
+				return next;
+			}
 
 			// A boolean check for whether this state with no changes should be carried
 			// over to the next frame.
@@ -272,14 +289,14 @@ namespace FRST {
 				ENUM_END = UNSUPPORTED,
 			};
 
-			inline bool isMouseMotionEvent() { return control.type == MS_MOVE; }
-			inline bool isMouseButtonEvent() { return control.type >= MS_START && control.type < MS_END; }
-			inline bool isMouseWheelEvent() { return control.type == MS_WHEEL; }
-			inline bool IS_KEYBOARD_EVENT() { return control.type >= KB_START && control.type < KB_END; }
-			inline bool isControllerButtonEvent() { return control.type >= CTRL_BUTTONS_START && control.type < CTRL_BUTTONS_END; }
-			inline bool isControllerAxisEvent() { return control.type >= CTRL_AXIS_START && control.type < CTRL_AXIS_END; }
-			inline bool isControllerModificationEvent() { return control.type >= CTRL_MODIFICATION_START && control.type < CTRL_MODIFICATION_END; }
-			inline bool isWindowEvent() { return control.type >= WINDOW_START && control.type < WINDOW_END; }
+			inline bool isMouseMotionEvent() const { return control.type == MS_MOVE; }
+			inline bool isMouseButtonEvent() const { return control.type >= MS_START && control.type < MS_END; }
+			inline bool isMouseWheelEvent() const { return control.type == MS_WHEEL; }
+			inline bool IS_KEYBOARD_EVENT() const { return control.type >= KB_START && control.type < KB_END; }
+			inline bool isControllerButtonEvent() const { return control.type >= CTRL_BUTTONS_START && control.type < CTRL_BUTTONS_END; }
+			inline bool isControllerAxisEvent() const { return control.type >= CTRL_AXIS_START && control.type < CTRL_AXIS_END; }
+			inline bool isControllerModificationEvent() const { return control.type >= CTRL_MODIFICATION_START && control.type < CTRL_MODIFICATION_END; }
+			inline bool isWindowEvent() const { return control.type >= WINDOW_START && control.type < WINDOW_END; }
 		};
 	}
 }
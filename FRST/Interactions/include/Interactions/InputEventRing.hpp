@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Interactions/InputEvent.hpp"
+
+
+namespace FRST {
+	namespace Interactions {
+		class InputEventRing {
+			/*
+			 * Storage for the game events of the last few frames, one buffer per frame, reused round robin.
+			 *
+			 * Buffers keep their capacity when reused, so once they have grown to fit the busiest frame
+			 * collecting events does not allocate at all.
+			 * A frame's events stay where they are until numFrames more frames have begun, so an InputState built
+			 * from them can be used by that frame's jobs while later frames are already collecting events.
+			 */
+		public:
+			// Enough events for a frame of a polling rate mouse, so that buffers rarely have to grow
+			static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+			// numFrames should be at least one more than the frames in flight that may still read old events
+			explicit InputEventRing(size_t numFrames, size_t capacity = DEFAULT_CAPACITY);
+
+			InputEventRing(const InputEventRing&) = delete;
+			InputEventRing& operator=(const InputEventRing&) = delete;
+
+			// Move on to the next frame's buffer, emptying it, and return it to be filled with that frame's events
+			std::vector<InputEvent>& beginFrame();
+
+			// The events of the frame begun last
+			std::span<InputEvent> currentFrame() { return m_frames[m_current]; }
+
+			size_t numFrames() const { return m_frames.size(); }
+		private:
+			std::vector<std::vector<InputEvent>> m_frames;
+			size_t m_current;
+		};
+	}
+}
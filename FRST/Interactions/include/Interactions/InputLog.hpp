@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Interactions/InputEvent.hpp"
+
+
+namespace FRST {
+	namespace Interactions {
+		/*
+		 * The file WindowSystem records input to and replays it from: an InputLogHeader, then one InputLogRecord
+		 * per event in the order they were collected. Everything is little endian and written as is.
+		 */
+		struct InputLogHeader {
+			static constexpr char MAGIC[4] = { 'F', 'I', 'N', 'P' };
+			static constexpr uint32_t VERSION = 1;
+
+			char magic[4];
+			uint32_t version;
+			// sizeof(InputLogRecord), so that readers can tell a log from another build apart
+			uint32_t recordSize;
+			uint32_t reserved;
+		};
+
+		struct InputLogRecord {
+			// Nanoseconds since recording started
+			uint64_t time;
+			int32_t x;
+			int32_t y;
+			int32_t dx;
+			int32_t dy;
+			int32_t controller;
+			// An InputEvent::Type
+			int16_t type;
+			uint8_t active;
+			uint8_t reserved;
+
+			static InputLogRecord fromEvent(const InputEvent& event, uint64_t time) {
+				InputLogRecord record;
+				record.time = time;
+				record.x = event.x;
+				record.y = event.y;
+				record.dx = event.dx;
+				record.dy = event.dy;
+				record.controller = event.control.controller;
+				record.type = event.control.type;
+				record.active = event.active ? 1 : 0;
+				record.reserved = 0;
+				return record;
+			}
+
+			// The recorded event, as collected at timestamp
+			InputEvent toEvent(uint64_t timestamp) const {
+				InputEvent event(InputEvent::Control{ static_cast<InputEvent::Type>(type), controller });
+				event.x = x;
+				event.y = y;
+				event.dx = dx;
+				event.dy = dy;
+				event.active = active != 0;
+				event.timestamp = timestamp;
+				return event;
+			}
+		};
+		static_assert(sizeof(InputLogRecord) == 32, "InputLogRecord is written to disk as is");
+	}
+}
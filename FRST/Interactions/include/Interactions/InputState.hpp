@@ -1,7 +1,7 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
+#include <bitset>
+#include <span>
 
 #include "Interactions/InputEvent.hpp"
 
@@ -13,7 +13,8 @@ namespace FRST {
 			 * A class that represents the state of the user's input devices during one frame of execution.
 			 * Contains both the current state of IO and changes this frame.
 			 *
-			 * It holds changes in itself but it queries SDL for the current state, should it be asked to get state.
+			 * State is kept densely: a bit per button and key, and x and y for the few controls that have them,
+			 * for the keyboard and mouse and each controller. Looking a control up is an array index.
 			 *
 			 * The suggested usage is to:
 			 *		Create one each frame. This must be fast
@@ -25,31 +26,55 @@ namespace FRST {
 			 *		Loop through events from this frame
 			 */
 		public:
+			// Controllers that have their own state, past the keyboard and mouse.
+			// Events of controllers with higher indices are still listed in the changes, but have no state.
+			static constexpr InputEvent::Controller MAX_CONTROLLERS = 8;
+
 			// Construct a new default state with no changes
 			InputState();
 
 			// Construct a new state by performing changes to other.
-			// The memory created for changes be taken and managed, so it should
-			// not be manually freed after calling.
-			InputState(const InputState& other, const std::vector<InputEvent*>& changes);
-
-			~InputState();
+			// The changes are this frame's events, normally from an InputEventRing. They are not copied,
+			// so must stay in place for as long as this state is used. Their dx and dy are filled in.
+			InputState(const InputState& other, std::span<InputEvent> changes);
 
 			// Receive a State object representing the most up to date state of the Control
-			const InputEvent* getState(InputEvent::Control ctrl);
+			InputEvent getState(InputEvent::Control ctrl) const;
+			// Whether a button or key is held down
+			bool isActive(InputEvent::Control ctrl) const;
 
 			// The proper interface to look at changes this frame is to iterate over them
 			// They will appear in the order that they occurred
-			typedef std::vector<InputEvent*>::const_iterator StateChangeIterator;
-			StateChangeIterator changesBegin();
-			StateChangeIterator changesEnd();
+			typedef std::span<const InputEvent>::iterator StateChangeIterator;
+			StateChangeIterator changesBegin() const;
+			StateChangeIterator changesEnd() const;
+			std::span<const InputEvent> changes() const { return m_changes; }
 		private:
+			// One slot for the keyboard and mouse, then one per controller
+			static constexpr size_t NUM_SLOTS = MAX_CONTROLLERS + 1;
+			static constexpr size_t NUM_CONTROLS = InputEvent::ENUM_END;
+			// Controls with a position or value besides being pressed: mouse buttons, wheel and motion, then controller axes
+			static constexpr size_t NUM_ANALOG = (InputEvent::KB_START - InputEvent::MS_START)
+				+ (InputEvent::CTRL_AXIS_END - InputEvent::CTRL_AXIS_START);
+
+			// The slot of a controller, or -1 if it has none
+			static int slotIndex(InputEvent::Controller controller);
+			// Where a control's x and y are kept, or -1 if it has none
+			static int analogIndex(InputEvent::Type type);
+
 			// The changes accumulated over this frame
-			std::vector<InputEvent*> m_changes;
+			std::span<const InputEvent> m_changes;
+
+			// The state of every control, which the next frame starts from with one copy
+			struct Controls {
+				std::bitset<NUM_CONTROLS> active[NUM_SLOTS];
+				int x[NUM_SLOTS][NUM_ANALOG];
+				int y[NUM_SLOTS][NUM_ANALOG];
+			} m_controls;
 
-			// The current keyboard state as of this frame
-			// Optimized by only containing states that differ from the default
-			std::unordered_map<InputEvent::Control, InputEvent*> m_currentState;
+			// How far x and y moved this frame, which the next frame starts again from 0
+			int m_dx[NUM_SLOTS][NUM_ANALOG];
+			int m_dy[NUM_SLOTS][NUM_ANALOG];
 		};
 	}
 }
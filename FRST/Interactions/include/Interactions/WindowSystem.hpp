@@ -1,9 +1,14 @@
 #pragma once
 
 #include "SDL.h"
-#include <queue>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include "Interactions/InputEvent.hpp"
+#include "Interactions/InputLog.hpp"
 
 
 namespace FRST {
@@ -15,24 +20,96 @@ namespace FRST {
 
 			// EventLoop functions
 			/*
-			 * Get all pending events by appending them to the provided queues
+			 * Get all pending events by appending them to the provided buffers
 			 * Splits these events into game events and immediate events.
 			 * Generally an immediate event is one that must be handled immediately,
 			 * like a controller being disconnected or the window being resized.
 			 *
+			 * Events are appended by value, so reusing the buffers from frame to frame
+			 * (see InputEventRing) keeps this from allocating.
+			 *
 			 * returns game events in gameEvents
 			 * returns immediate events in immediateEvents
 			 * returns the number of game events
 			 */
 			int getPendingEvents(
-				std::queue<InputEvent*> &gameEvents,
-				std::queue<InputEvent*> &immediateEvents);
+				std::vector<InputEvent> &gameEvents,
+				std::vector<InputEvent> &immediateEvents);
+
+			/*
+			 * As getPendingEvents, but first waits up to timeoutMs for an event to arrive.
+			 * For a thread that does nothing but collect input, so that it wakes as soon as there is some.
+			 */
+			int waitForEvents(
+				std::vector<InputEvent> &gameEvents,
+				std::vector<InputEvent> &immediateEvents,
+				int timeoutMs);
 
 			// These are not handled directly inside getPendingEvents to provide the caller
 			// the chance to schedule their handling at a potentially later time.
-			void handleWindowEvent(InputEvent* event);
+			void handleWindowEvent(const InputEvent& event);
+
+			// Recording and replay
+			// Like the functions above, these must only be called from the thread that collects events.
+			enum class ReplaySpeed {
+				// Each event comes out as long after the replay started as it was recorded after recording started
+				RealTime,
+				// Events come out as fast as they are asked for. See replayStartTime() for keeping frames deterministic.
+				AsFastAsPossible
+			};
+
+			/*
+			 * Write every event collected from now on, game and immediate, to an InputLog at path.
+			 * Throws std::runtime_error if the file cannot be created.
+			 */
+			void startRecording(const std::string& path);
+			// Throws std::runtime_error if the log could not be written in full
+			void stopRecording();
+
+			/*
+			 * Collect events from an InputLog at path instead of from SDL, which is then not polled at all,
+			 * so that a recorded session can be run again without a display or any input devices.
+			 * Events keep their recorded spacing, and are timestamped from replayStartTime() on.
+			 * Throws std::runtime_error if the file cannot be read or is not an input log.
+			 */
+			void startReplay(const std::string& path, ReplaySpeed speed);
+			bool isReplaying() const { return m_replaying; }
+			ReplaySpeed replaySpeed() const { return m_replaySpeed; }
+			// The timestamp recorded time 0 is replayed at. In fast replays the frame loop can sample input at a
+			// fixed step from here, instead of by the clock, for the same frames every time.
+			uint64_t replayStartTime() const { return m_replayStart; }
+			// Whether every event of the replay has been collected
+			bool replayFinished() const { return m_replaying && m_replayNext == m_replay.size(); }
 		private:
+			// Events a fast replay hands out per call, so that callers see them in batches like live input
+			static constexpr size_t REPLAY_BATCH = 256;
+
+			// Translate and timestamp one event from SDL, then add it as addEvent does
+			int addSdlEvent(
+				SDL_Event &sdlEvent,
+				std::vector<InputEvent> &gameEvents,
+				std::vector<InputEvent> &immediateEvents);
+			// Record an event if recording, and append it to the buffer it belongs in.
+			// Returns 1 for a game event and 0 otherwise.
+			int addEvent(
+				const InputEvent &event,
+				std::vector<InputEvent> &gameEvents,
+				std::vector<InputEvent> &immediateEvents);
+			// getPendingEvents, from the replay
+			int getReplayEvents(
+				std::vector<InputEvent> &gameEvents,
+				std::vector<InputEvent> &immediateEvents);
+
 			SDL_Window* window;
+
+			std::ofstream m_recording;
+			uint64_t m_recordStart;
+
+			bool m_replaying;
+			ReplaySpeed m_replaySpeed;
+			uint64_t m_replayStart;
+			std::vector<InputLogRecord> m_replay;
+			size_t m_replayNext;
 		};
 	}
 }
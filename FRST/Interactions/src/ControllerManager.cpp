@@ -28,7 +28,7 @@ namespace FRST {
 			}
 		}
 
-		void ControllerManager::handleControllerEvent(InputEvent* event) {
+		void ControllerManager::handleControllerEvent(const InputEvent& event) {
 			// TODO Implement this at some point
 			// Things will probably break if a controller disconnects ever
 		}
@@ -5,13 +5,18 @@
 
 namespace FRST {
 	namespace Interactions {
+		InputEvent::InputEvent()
+			: InputEvent(Control{ Type::UNSUPPORTED, -1 }) {
+		}
+
 		InputEvent::InputEvent(SDL_Event* event)
 			: control{ Type::UNSUPPORTED, -1 }
 			, x(0)
 			, y(0)
 			, dx(0)
 			, dy(0)
-			, active(false) {
+			, active(false)
+			, timestamp(0) {
 			translateFromSDL(event);
 		}
 
@@ -21,16 +26,8 @@ namespace FRST {
 			, y(0)
 			, dx(0)
 			, dy(0)
-			, active(false) {
-		}
-
-		InputEvent::InputEvent(const InputEvent& other)
-			: control(other.control)
-			, x(other.x)
-			, y(other.y)
-			, dx(0) // We don't copy change because it is no longer valid for the next frame
-			, dy(0)
-			, active(other.active) {
+			, active(false)
+			, timestamp(0) {
 		}
 
 		void InputEvent::translateFromSDL(SDL_Event* event) {
@@ -0,0 +1,27 @@
+#include "Interactions/InputEventRing.hpp"
+
+#include <stdexcept>
+
+
+namespace FRST {
+	namespace Interactions {
+		InputEventRing::InputEventRing(size_t numFrames, size_t capacity)
+			: m_frames(numFrames)
+			, m_current(0) {
+			if (numFrames == 0) {
+				throw std::logic_error("InputEventRing needs at least one frame");
+			}
+			for (std::vector<InputEvent>& frame : m_frames) {
+				frame.reserve(capacity);
+			}
+		}
+
+		std::vector<InputEvent>& InputEventRing::beginFrame() {
+			m_current = (m_current + 1) % m_frames.size();
+			std::vector<InputEvent>& frame = m_frames[m_current];
+			// clear() keeps the capacity
+			frame.clear();
+			return frame;
+		}
+	}
+}
@@ -1,81 +1,92 @@
 #include "Interactions/InputState.hpp"
 
 #include <SDL2/SDL.h>
-#include <tuple>
 
 
 namespace FRST {
 	namespace Interactions {
-		InputState::InputState() : m_changes(), m_currentState() {
+		InputState::InputState() : m_changes(), m_controls(), m_dx(), m_dy() {
 		}
 
-		InputState::InputState(const InputState& other, const std::vector<InputEvent*>& changes)
+		InputState::InputState(const InputState& other, std::span<InputEvent> changes)
 			: m_changes(changes)
-			, m_currentState() {
-
-			// Perform changes on the previous InputState
-			for (auto it = other.m_currentState.cbegin(); it != other.m_currentState.cend(); it++) {
-				if (!it->second->shouldMoveToNextFrame()) {
-					// Copy it over
-					// We can't steal the pointer because another thread may still be using it
-					InputEvent* event = new InputEvent(*it->second);
-					m_currentState[event->control] = event;
-				}
-			}
+			, m_controls(other.m_controls) // Everything carries over, in one copy
+			, m_dx()
+			, m_dy() {
 
 			// Loop over the changes to edit the current state to match the changes
-			for (auto it = m_changes.begin(); it != m_changes.end(); it++) {
-				InputEvent& change = **it;
-				auto search = m_currentState.find(change.control);
-				if (search == m_currentState.end()) {
-					std::tie(search, std::ignore) = m_currentState.insert(
-						std::make_pair(change.control, new InputEvent(change)));
+			for (InputEvent& change : changes) {
+				int slot = slotIndex(change.control.controller);
+				InputEvent::Type type = change.control.type;
+				if (slot < 0 || type < InputEvent::ENUM_START || type >= static_cast<int>(NUM_CONTROLS)) {
+					continue;
+				}
+				m_controls.active[slot][type] = change.active;
 
-					change.dx = change.x;
-					change.dy = change.y;
-					search->second->dx = change.dx;
-					search->second->dy = change.dy;
-				} else {
-					InputEvent& event = *search->second;
-					change.dx = event.x - change.x;
-					change.dy = event.y - change.y;
-					event.dx += change.dx;
-					event.dy += change.dy;
-					event.x = change.x;
-					event.y = change.y;
+				int analog = analogIndex(type);
+				if (analog < 0) {
+					continue;
 				}
+				// Mouse motion comes with its own relative movement, which still counts in relative mouse mode
+				if (!change.isMouseMotionEvent()) {
+					change.dx = change.x - m_controls.x[slot][analog];
+					change.dy = change.y - m_controls.y[slot][analog];
+				}
+				m_dx[slot][analog] += change.dx;
+				m_dy[slot][analog] += change.dy;
+				m_controls.x[slot][analog] = change.x;
+				m_controls.y[slot][analog] = change.y;
 			}
 		}
 
-		InputState::~InputState() {
-			for (auto it = m_currentState.begin(); it != m_currentState.end(); it++) {
-				delete it->second;
+		InputEvent InputState::getState(InputEvent::Control ctrl) const {
+			InputEvent event(ctrl);
+			int slot = slotIndex(ctrl.controller);
+			if (slot < 0 || ctrl.type < InputEvent::ENUM_START || ctrl.type >= static_cast<int>(NUM_CONTROLS)) {
+				return event;
 			}
-
-			for (auto it = m_changes.begin(); it != m_changes.end(); it++) {
-				delete *it;
+			event.active = m_controls.active[slot][ctrl.type];
+			int analog = analogIndex(ctrl.type);
+			if (analog >= 0) {
+				event.x = m_controls.x[slot][analog];
+				event.y = m_controls.y[slot][analog];
+				event.dx = m_dx[slot][analog];
+				event.dy = m_dy[slot][analog];
 			}
+			return event;
 		}
 
-		const InputEvent* InputState::getState(InputEvent::Control ctrl) {
-			auto it = m_currentState.find(ctrl);
-			if (it != m_currentState.end()) {
-				return it->second;
+		bool InputState::isActive(InputEvent::Control ctrl) const {
+			int slot = slotIndex(ctrl.controller);
+			if (slot < 0 || ctrl.type < InputEvent::ENUM_START || ctrl.type >= static_cast<int>(NUM_CONTROLS)) {
+				return false;
 			}
+			return m_controls.active[slot][ctrl.type];
+		}
 
-			// Create a default state and add it to the dictionary
-			// We do this for memory management reasons
-			InputEvent* event = new InputEvent(ctrl);
-			m_currentState[ctrl] = event;
-			return event;
+		InputState::StateChangeIterator InputState::changesBegin() const {
+			return m_changes.begin();
 		}
 
-		InputState::StateChangeIterator InputState::changesBegin() {
-			return m_changes.cbegin();
+		InputState::StateChangeIterator InputState::changesEnd() const {
+			return m_changes.end();
 		}
 
-		InputState::StateChangeIterator InputState::changesEnd() {
-			return m_changes.cend();
+		int InputState::slotIndex(InputEvent::Controller controller) {
+			if (controller < 0) {
+				return 0;
+			}
+			return controller < MAX_CONTROLLERS ? controller + 1 : -1;
+		}
+
+		int InputState::analogIndex(InputEvent::Type type) {
+			if (type >= InputEvent::MS_START && type < InputEvent::KB_START) {
+				return type - InputEvent::MS_START;
+			}
+			if (type >= InputEvent::CTRL_AXIS_START && type < InputEvent::CTRL_AXIS_END) {
+				return (InputEvent::KB_START - InputEvent::MS_START) + (type - InputEvent::CTRL_AXIS_START);
+			}
+			return -1;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -1,49 +1,193 @@
 #include "Interactions/WindowSystem.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 
 
 namespace FRST {
 	namespace Interactions {
-		WindowSystem::WindowSystem(SDL_Window* window) : window(window) {
+		namespace {
+			// Nanoseconds on std::chrono::steady_clock, as InputEvent::timestamp
+			uint64_t now() {
+				return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count());
+			}
+		}
+
+		WindowSystem::WindowSystem(SDL_Window* window)
+			: window(window)
+			, m_recordStart(0)
+			, m_replaying(false)
+			, m_replaySpeed(ReplaySpeed::RealTime)
+			, m_replayStart(0)
+			, m_replayNext(0) {
 		}
 
 		WindowSystem::~WindowSystem() {
 		}
 
 		int WindowSystem::getPendingEvents(
-			std::queue<InputEvent*> &gameEvents,
-			std::queue<InputEvent*> &immediateEvents) {
+			std::vector<InputEvent> &gameEvents,
+			std::vector<InputEvent> &immediateEvents) {
+			if (m_replaying) {
+				return getReplayEvents(gameEvents, immediateEvents);
+			}
+
 			int count = 0;
 
 			SDL_Event temp_event;
 			while (SDL_PollEvent(&temp_event)) {
-				InputEvent* newEvent = new InputEvent(&temp_event);
-				if (newEvent->control.type == InputEvent::Type::UNSUPPORTED) {
-					// Filter unsupported events
-					delete newEvent;
-					newEvent = nullptr;
-				} else if (
-					newEvent->isControllerModificationEvent() ||
-					newEvent->isWindowEvent() ||
-					newEvent->control.type == InputEvent::Type::QUIT) {
-					// This is an immediate event
-					immediateEvents.push(newEvent);
-					newEvent = nullptr;
-				} else {
-					// This is a game event
-					gameEvents.push(newEvent);
-					newEvent = nullptr;
-					count++;
-				}
+				count += addSdlEvent(temp_event, gameEvents, immediateEvents);
 			}
 
 			return count;
 		}
 
-		void WindowSystem::handleWindowEvent(InputEvent* event) {
+		int WindowSystem::waitForEvents(
+			std::vector<InputEvent> &gameEvents,
+			std::vector<InputEvent> &immediateEvents,
+			int timeoutMs) {
+			if (m_replaying) {
+				// Sleep until the next event is due, as SDL would wait for it to arrive
+				if (m_replaySpeed == ReplaySpeed::RealTime && m_replayNext < m_replay.size()) {
+					uint64_t due = m_replayStart + m_replay[m_replayNext].time;
+					uint64_t current = now();
+					if (due > current) {
+						std::this_thread::sleep_for(std::chrono::nanoseconds(
+							std::min<uint64_t>(due - current, uint64_t(timeoutMs) * 1000000)));
+					}
+				}
+				return getReplayEvents(gameEvents, immediateEvents);
+			}
+
+			SDL_Event temp_event;
+			if (!SDL_WaitEventTimeout(&temp_event, timeoutMs)) {
+				return 0;
+			}
+			int count = addSdlEvent(temp_event, gameEvents, immediateEvents);
+			return count + getPendingEvents(gameEvents, immediateEvents);
+		}
+
+		void WindowSystem::handleWindowEvent(const InputEvent& event) {
 			// TODO not required for an MVP but should be written at some point.
 			// I'll write this when not having it annoys me too much.
 		}
+
+		void WindowSystem::startRecording(const std::string& path) {
+			m_recording = std::ofstream(path, std::ios::binary | std::ios::trunc);
+			if (!m_recording) {
+				throw std::runtime_error("WindowSystem: cannot write " + path);
+			}
+			InputLogHeader header;
+			std::memcpy(header.magic, InputLogHeader::MAGIC, 4);
+			header.version = InputLogHeader::VERSION;
+			header.recordSize = sizeof(InputLogRecord);
+			header.reserved = 0;
+			m_recording.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			m_recordStart = now();
+		}
+
+		void WindowSystem::stopRecording() {
+			if (!m_recording.is_open()) {
+				return;
+			}
+			m_recording.close();
+			if (!m_recording) {
+				throw std::runtime_error("WindowSystem: failed writing the input log");
+			}
+		}
+
+		void WindowSystem::startReplay(const std::string& path, ReplaySpeed speed) {
+			std::ifstream stream(path, std::ios::binary);
+			if (!stream) {
+				throw std::runtime_error("WindowSystem: cannot read " + path);
+			}
+			InputLogHeader header;
+			if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+					|| std::memcmp(header.magic, InputLogHeader::MAGIC, 4) != 0
+					|| header.version != InputLogHeader::VERSION || header.recordSize != sizeof(InputLogRecord)) {
+				throw std::runtime_error("WindowSystem: " + path + " is not an input log");
+			}
+
+			std::vector<InputLogRecord> records;
+			InputLogRecord record;
+			while (stream.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+				// Anything else could index past InputState's tables
+				if (record.type < InputEvent::ENUM_START || record.type >= InputEvent::ENUM_END) {
+					throw std::runtime_error("WindowSystem: " + path + " has an event of unknown type");
+				}
+				records.push_back(record);
+			}
+			if (stream.gcount() != 0) {
+				throw std::runtime_error("WindowSystem: " + path + " is truncated");
+			}
+
+			m_replay = std::move(records);
+			m_replayNext = 0;
+			m_replaySpeed = speed;
+			m_replayStart = now();
+			m_replaying = true;
+		}
+
+		int WindowSystem::addSdlEvent(
+			SDL_Event &sdlEvent,
+			std::vector<InputEvent> &gameEvents,
+			std::vector<InputEvent> &immediateEvents) {
+			InputEvent newEvent(&sdlEvent);
+			// SDL's own timestamps are whole milliseconds, too coarse to place mouse movement within a frame.
+			// Events are collected as they arrive, so the time they are seen here is within a poll of when they happened.
+			newEvent.timestamp = now();
+			return addEvent(newEvent, gameEvents, immediateEvents);
+		}
+
+		int WindowSystem::addEvent(
+			const InputEvent &event,
+			std::vector<InputEvent> &gameEvents,
+			std::vector<InputEvent> &immediateEvents) {
+			if (event.control.type == InputEvent::Type::UNSUPPORTED) {
+				// Filter unsupported events
+				return 0;
+			}
+
+			if (m_recording.is_open()) {
+				uint64_t time = event.timestamp > m_recordStart ? event.timestamp - m_recordStart : 0;
+				InputLogRecord record = InputLogRecord::fromEvent(event, time);
+				m_recording.write(reinterpret_cast<const char*>(&record), sizeof(record));
+			}
+
+			if (
+				event.isControllerModificationEvent() ||
+				event.isWindowEvent() ||
+				event.control.type == InputEvent::Type::QUIT) {
+				// This is an immediate event
+				immediateEvents.push_back(event);
+				return 0;
+			} else {
+				// This is a game event
+				gameEvents.push_back(event);
+				return 1;
+			}
+		}
+
+		int WindowSystem::getReplayEvents(
+			std::vector<InputEvent> &gameEvents,
+			std::vector<InputEvent> &immediateEvents) {
+			int count = 0;
+			uint64_t current = now();
+			for (size_t released = 0; m_replayNext < m_replay.size(); released++) {
+				const InputLogRecord& record = m_replay[m_replayNext];
+				uint64_t timestamp = m_replayStart + record.time;
+				if (m_replaySpeed == ReplaySpeed::RealTime ? timestamp > current : released == REPLAY_BATCH) {
+					break;
+				}
+				count += addEvent(record.toEvent(timestamp), gameEvents, immediateEvents);
+				m_replayNext++;
+			}
+			return count;
+		}
 	}
-}
\ No newline at end of file
+}
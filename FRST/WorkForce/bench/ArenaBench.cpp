@@ -0,0 +1,102 @@
+/*
+ * Compares building per-frame job results in a LinearArena against new/delete.
+ *
+ * Each frame allocates thousands of small results, then frees them all, from several threads at once
+ * to include allocator contention. Prints nanoseconds per result for each case.
+ */
+
+#include "WorkForce/LinearArena.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace FRST::WorkForce;
+
+namespace {
+	// A plain trivially destructible result, like a transform or a bounding box
+	struct SmallResult {
+		float values[6];
+	};
+
+	// A result with a virtual destructor, which always needs its destructor called
+	struct PolymorphicResult {
+		virtual ~PolymorphicResult() {}
+		float values[6];
+	};
+
+	const int FRAMES = 200;
+	const int RESULTS_PER_FRAME = 4096;
+
+	// Keep the optimizer from throwing the allocations away
+	volatile uintptr_t s_sink;
+
+	template<class T>
+	void runNewDelete(std::vector<T*>& results) {
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (int i = 0; i < RESULTS_PER_FRAME; i++) {
+				results[i] = new T();
+			}
+			s_sink = reinterpret_cast<uintptr_t>(results[RESULTS_PER_FRAME - 1]);
+			for (int i = 0; i < RESULTS_PER_FRAME; i++) {
+				delete results[i];
+			}
+		}
+	}
+
+	template<class T>
+	void runArena(std::vector<T*>& results) {
+		LinearArena arena;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (int i = 0; i < RESULTS_PER_FRAME; i++) {
+				results[i] = arena.create<T>();
+			}
+			s_sink = reinterpret_cast<uintptr_t>(results[RESULTS_PER_FRAME - 1]);
+			arena.reset();
+		}
+	}
+
+	// Returns nanoseconds per result
+	template<class T>
+	double measure(void (*run)(std::vector<T*>&), int numThreads) {
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; t++) {
+			threads.emplace_back([run] {
+				std::vector<T*> results(RESULTS_PER_FRAME);
+				run(results);
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		return elapsed / (static_cast<double>(FRAMES) * RESULTS_PER_FRAME * numThreads);
+	}
+
+	template<class T>
+	void compare(const char* name, int numThreads) {
+		double heap = measure<T>(&runNewDelete<T>, numThreads);
+		double arena = measure<T>(&runArena<T>, numThreads);
+		std::printf("%-20s threads=%d  new/delete %7.2f ns  arena %7.2f ns  speedup %5.1fx\n",
+			name, numThreads, heap, arena, heap / arena);
+	}
+}
+
+int main(int argc, char** argv) {
+	int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+	if (maxThreads < 1) {
+		maxThreads = 1;
+	}
+
+	std::printf("%d frames of %d results per thread\n", FRAMES, RESULTS_PER_FRAME);
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		compare<SmallResult>("trivial result", threads);
+		compare<PolymorphicResult>("polymorphic result", threads);
+	}
+	return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * Runs synthetic job graphs through the WorkerPool to catch scheduler regressions.
+ *
+ * Each graph is run with 1, 2, 4 ... up to the maximum number of workers, both one frame at a time (for frame
+ * latency) and pipelined (for throughput). Results are written as JSON, to stdout or to the file given with
+ * --out, so that runs of different builds can be compared by a script.
+ * No cores are reserved, so every CPU the process may run on gets a worker and the bench thread is not pinned.
+ *
+ * Usage: WorkForce_bench [--workers N] [--frames N] [--out results.json]
+ */
+
+#include "WorkForce/CpuTopology.hpp"
+#include "WorkForce/Job.hpp"
+#include "WorkForce/JobContext.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace FRST::WorkForce;
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	// Keep the optimizer from throwing the work away
+	volatile uint64_t s_sink;
+
+	uint64_t spin(uint32_t iterations, uint64_t seed) {
+		uint64_t value = seed | 1;
+		for (uint32_t i = 0; i < iterations; i++) {
+			value ^= value << 13;
+			value ^= value >> 7;
+			value ^= value << 17;
+		}
+		return value;
+	}
+
+	// Consumes any number of results, does a fixed amount of work, and produces one result
+	class BenchJob : public Job {
+	public:
+		BenchJob(const std::string& output, const std::vector<std::string>& inputs, uint32_t work)
+			: m_work(work)
+			, m_output(this, output) {
+			for (const std::string& input : inputs) {
+				m_inputs.emplace_back(new Input<uint64_t>(this, input));
+			}
+		}
+
+		const char* name() const override { return "BenchJob"; }
+
+		void execute(JobContext& context) override {
+			uint64_t value = context.frame();
+			for (const auto& input : m_inputs) {
+				value += input->get(context);
+			}
+			m_output.emplace(context, spin(m_work, value));
+		}
+
+	private:
+		const uint32_t m_work;
+		std::vector<std::unique_ptr<Input<uint64_t>>> m_inputs;
+		Output<uint64_t> m_output;
+	};
+
+	struct Graph {
+		std::string name;
+		// Iterations of spin() per job
+		uint32_t work;
+		std::vector<std::unique_ptr<BenchJob>> jobs;
+
+		void add(const std::string& output, const std::vector<std::string>& inputs) {
+			jobs.emplace_back(new BenchJob(output, inputs, work));
+		}
+	};
+
+	std::string result(const std::string& prefix, size_t index) {
+		return prefix + std::to_string(index);
+	}
+
+	// One root feeding a wide layer, gathered by a single job
+	void buildFanOut(Graph& graph, size_t width) {
+		graph.add("root", {});
+		std::vector<std::string> leaves;
+		for (size_t i = 0; i < width; i++) {
+			leaves.push_back(result("leaf", i));
+			graph.add(leaves.back(), { "root" });
+		}
+		graph.add("gather", leaves);
+	}
+
+	// Independent chains, so parallelism is limited to the number of chains
+	void buildChains(Graph& graph, size_t chains, size_t depth) {
+		for (size_t chain = 0; chain < chains; chain++) {
+			std::string prefix = result("chain", chain) + "_";
+			graph.add(result(prefix, 0), {});
+			for (size_t link = 1; link < depth; link++) {
+				graph.add(result(prefix, link), { result(prefix, link - 1) });
+			}
+		}
+	}
+
+	// A stack of diamonds, each splitting into width jobs and joining again
+	void buildDiamonds(Graph& graph, size_t diamonds, size_t width) {
+		std::string join = "join0";
+		graph.add(join, {});
+		for (size_t diamond = 0; diamond < diamonds; diamond++) {
+			std::vector<std::string> sides;
+			for (size_t side = 0; side < width; side++) {
+				sides.push_back(result("side" + std::to_string(diamond) + "_", side));
+				graph.add(sides.back(), { join });
+			}
+			join = result("join", diamond + 1);
+			graph.add(join, sides);
+		}
+	}
+
+	// Thousands of empty jobs, which measures pure scheduling overhead
+	void buildTinyJobs(Graph& graph, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			graph.add(result("tiny", i), {});
+		}
+	}
+
+	struct Measurement {
+		size_t workers;
+		double jobsPerSecond;
+		double nanosecondsPerJob;
+		double overheadNanosecondsPerJob;
+		double p50;
+		double p99;
+		double p999;
+	};
+
+	double percentile(std::vector<double>& sorted, double fraction) {
+		size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+
+	Measurement measure(Graph& graph, size_t workers, size_t frames, double spinNanoseconds) {
+		WorkerPoolConfig config;
+		config.numWorkers = workers;
+		config.framesInFlight = 2;
+		// Otherwise the largest run has one more worker than there are CPUs for them
+		config.reservedCores = 0;
+		WorkerPool pool(config);
+		for (const auto& job : graph.jobs) {
+			pool.addJob(job.get());
+		}
+
+		// Warm up, which also compiles the graph
+		for (size_t frame = 0; frame < 16; frame++) {
+			pool.runFrame();
+		}
+
+		// Latency: each frame on its own, from beginFrame() until every job has finished
+		std::vector<double> latencies;
+		latencies.reserve(frames);
+		for (size_t frame = 0; frame < frames; frame++) {
+			auto start = Clock::now();
+			pool.runFrame();
+			latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+		}
+		std::sort(latencies.begin(), latencies.end());
+
+		// Throughput: frames pipelined as fast as the pool can take them
+		auto start = Clock::now();
+		for (size_t frame = 0; frame < frames; frame++) {
+			pool.beginFrame();
+		}
+		pool.waitForIdle();
+		double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+		double jobs = static_cast<double>(frames * graph.jobs.size());
+		double work = jobs * spinNanoseconds * graph.work;
+		Measurement measurement;
+		measurement.workers = workers;
+		measurement.jobsPerSecond = jobs / elapsed * 1e9;
+		measurement.nanosecondsPerJob = elapsed / jobs;
+		// Worker time that was not spent doing the jobs' own work
+		measurement.overheadNanosecondsPerJob = std::max(0.0, (elapsed * static_cast<double>(workers) - work) / jobs);
+		measurement.p50 = percentile(latencies, 0.5);
+		measurement.p99 = percentile(latencies, 0.99);
+		measurement.p999 = percentile(latencies, 0.999);
+		return measurement;
+	}
+
+	// How long one iteration of spin() takes on this machine
+	double calibrateSpin() {
+		const uint32_t iterations = 10000000;
+		auto start = Clock::now();
+		s_sink = spin(iterations, 1);
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+	}
+}
+
+int main(int argc, char** argv) {
+	// The CPUs the pool places workers on, with no cores reserved
+	size_t workerCpus = std::max<size_t>(1, CpuTopology::detect().cpus().size());
+	size_t maxWorkers = workerCpus;
+	size_t frames = 2000;
+	const char* outPath = nullptr;
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 == argc) {
+			std::fprintf(stderr, "Option %s needs a value\nUsage: %s [--workers N] [--frames N] [--out results.json]\n",
+				argv[i], argv[0]);
+			return 1;
+		}
+		if (std::strcmp(argv[i], "--workers") == 0) {
+			maxWorkers = std::max(1, std::atoi(argv[i + 1]));
+		} else if (std::strcmp(argv[i], "--frames") == 0) {
+			frames = std::max(1, std::atoi(argv[i + 1]));
+		} else if (std::strcmp(argv[i], "--out") == 0) {
+			outPath = argv[i + 1];
+		} else {
+			std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (maxWorkers > workerCpus) {
+		// More workers than CPUs would measure time slicing, not the scheduler
+		std::fprintf(stderr, "Running with up to %zu workers, one per available CPU\n", workerCpus);
+		maxWorkers = workerCpus;
+	}
+
+	std::vector<std::function<void(Graph&)>> builders = {
+		[](Graph& graph) { graph.name = "fan_out"; graph.work = 2000; buildFanOut(graph, 256); },
+		[](Graph& graph) { graph.name = "chains"; graph.work = 2000; buildChains(graph, 8, 64); },
+		[](Graph& graph) { graph.name = "diamonds"; graph.work = 2000; buildDiamonds(graph, 32, 4); },
+		[](Graph& graph) { graph.name = "tiny_jobs"; graph.work = 0; buildTinyJobs(graph, 4096); },
+	};
+
+	// Powers of two, always ending with the maximum
+	std::vector<size_t> workerCounts;
+	for (size_t workers = 1; workers < maxWorkers; workers *= 2) {
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(maxWorkers);
+
+	double spinNanoseconds = calibrateSpin();
+
+	FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+	if (!out) {
+		std::fprintf(stderr, "Could not open %s\n", outPath);
+		return 1;
+	}
+
+	std::fprintf(out, "{\n\t\"frames\": %zu,\n\t\"hardware_threads\": %u,\n\t\"worker_cpus\": %zu,\n\t\"reserved_cores\": 0,\n"
+		"\t\"spin_ns_per_iteration\": %.4f,\n\t\"graphs\": [",
+		frames, std::thread::hardware_concurrency(), workerCpus, spinNanoseconds);
+	for (size_t g = 0; g < builders.size(); g++) {
+		Graph graph;
+		builders[g](graph);
+
+		std::fprintf(out, "%s\n\t\t{\n\t\t\t\"name\": \"%s\",\n\t\t\t\"jobs\": %zu,\n\t\t\t\"work_ns_per_job\": %.1f,\n\t\t\t\"runs\": [",
+			g == 0 ? "" : ",", graph.name.c_str(), graph.jobs.size(), spinNanoseconds * graph.work);
+		bool first = true;
+		for (size_t workers : workerCounts) {
+			Measurement m = measure(graph, workers, frames, spinNanoseconds);
+			std::fprintf(out, "%s\n\t\t\t\t{ \"workers\": %zu, \"jobs_per_second\": %.0f, \"ns_per_job\": %.1f, "
+				"\"overhead_ns_per_job\": %.1f, \"frame_latency_us\": { \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f } }",
+				first ? "" : ",", m.workers, m.jobsPerSecond, m.nanosecondsPerJob, m.overheadNanosecondsPerJob, m.p50, m.p99, m.p999);
+			first = false;
+		}
+		std::fprintf(out, "\n\t\t\t]\n\t\t}");
+		std::fflush(out);
+	}
+	std::fprintf(out, "\n\t]\n}\n");
+
+	if (outPath) {
+		std::fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "WorkForce/ResumeItem.hpp"
+#include <atomic>
+#include <coroutine>
+
+namespace FRST {
+	namespace WorkForce {
+		class WorkerPool;
+
+		class AsyncEvent {
+		public:
+			/*
+			 * A one-shot event that Tasks can co_await.
+			 * Tasks that await it before set() is called are suspended, and are queued onto the pool once it is.
+			 * Awaiting it afterwards continues straight away. set() may be called from any thread, eg. an I/O thread.
+			 */
+			explicit AsyncEvent(WorkerPool& pool);
+
+			AsyncEvent(const AsyncEvent&) = delete;
+			AsyncEvent& operator=(const AsyncEvent&) = delete;
+
+			void set();
+			bool isSet() const;
+
+			class Awaiter {
+			public:
+				explicit Awaiter(AsyncEvent& event)
+					: m_event(event) {}
+
+				bool await_ready() const noexcept { return m_event.isSet(); }
+				bool await_suspend(std::coroutine_handle<> handle) noexcept;
+				void await_resume() noexcept {}
+
+			private:
+				AsyncEvent& m_event;
+				ResumeItem m_resume;
+			};
+
+			Awaiter operator co_await() { return Awaiter(*this); }
+
+		private:
+			WorkerPool& m_pool;
+			// nullptr when nothing is waiting, the head of the waiting list, or this once the event is set.
+			std::atomic<void*> m_state;
+		};
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "WorkForce/Job.hpp"
+#include "WorkForce/Task.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		class AsyncJob : public Job {
+		public:
+			/**
+			 * A Job whose per-frame work is a coroutine.
+			 * executeAsync() may co_await I/O, child Tasks or other events, and its worker is released while it waits.
+			 * The job only counts as finished (and its successors are only released) once the returned Task finishes,
+			 * so every Output must be filled by then.
+			 *
+			 * The context stays valid across suspension, but context.worker() and context.arena() refer to
+			 * whichever worker the coroutine is currently running on, so do not hold onto them across a co_await.
+			 */
+			virtual Task<void> executeAsync(JobContext& context) = 0;
+
+			void execute(JobContext& context) final;
+		};
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		struct LogicalCpu {
+			// The id the OS uses, eg. for affinity
+			uint32_t id;
+			// Dense indices, shared by every logical CPU in the same physical core, L3 cache and NUMA node
+			uint32_t core;
+			uint32_t l3Domain;
+			uint32_t numaNode;
+			// Which SMT thread of its core this is. 0 for the first.
+			uint32_t smtIndex;
+		};
+
+		class CpuTopology {
+		public:
+			/*
+			 * The layout of the online CPUs this process is allowed to run on, read from /sys/devices/system/cpu.
+			 * Where that is not available every CPU is treated as its own core, sharing one L3 and NUMA node.
+			 */
+			static CpuTopology detect();
+
+			// Read from a different root than /sys/devices/system/cpu, eg. a copy taken from another machine.
+			// Every online CPU is included, as this process's affinity says nothing about that machine.
+			static CpuTopology detect(const std::string& root);
+
+			// Ordered by core, with the SMT threads of each core in order
+			const std::vector<LogicalCpu>& cpus() const { return m_cpus; }
+
+			size_t numCores() const { return m_numCores; }
+			size_t numL3Domains() const { return m_numL3Domains; }
+			size_t numNumaNodes() const { return m_numNumaNodes; }
+
+			/*
+			 * How far apart two logical CPUs are, for picking steal victims:
+			 * 0 on the same core, 1 sharing an L3, 2 on the same NUMA node, 3 otherwise.
+			 */
+			static uint32_t distance(const LogicalCpu& a, const LogicalCpu& b);
+
+			// Restrict the calling thread to one logical CPU. Returns false if that is not supported or failed.
+			static bool pinCurrentThread(uint32_t cpu);
+
+		private:
+			CpuTopology();
+
+			// Only the online CPUs in allowed, unless it is empty
+			static CpuTopology detect(const std::string& root, const std::vector<uint32_t>& allowed);
+
+			std::vector<LogicalCpu> m_cpus;
+			size_t m_numCores;
+			size_t m_numL3Domains;
+			size_t m_numNumaNodes;
+		};
+	}
+}
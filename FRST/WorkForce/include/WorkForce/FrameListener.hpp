@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace FRST {
+	namespace WorkForce {
+		class FrameListener {
+		public:
+			/*
+			 * Told by WorkerPool::beginFrame() about each frame it starts, on the thread starting frames.
+			 * onBeginFrame() runs before any job, or any coroutine waiting for the frame, of the new frame, so it can
+			 * swap state that those read at a clean frame boundary. Jobs of older frames may still be running.
+			 */
+			virtual ~FrameListener() = default;
+
+			virtual void onBeginFrame(uint64_t frame) = 0;
+		};
+	}
+}
@@ -1,8 +1,9 @@
 #pragma once
 
-#include "WorkForce/JobResult.hpp"
+#include "WorkForce/JobContext.hpp"
+#include "WorkForce/Port.hpp"
+#include "WorkForce/Priority.hpp"
 
-#include <string>
 #include <vector>
 
 namespace FRST {
@@ -13,23 +14,64 @@ namespace FRST {
 			 * A Job is an action that is called once per-frame.
 			 */
 			Job();
-			~Job();
+			virtual ~Job();
+
+			// Ports hold a pointer back to their job, so jobs cannot be copied
+			Job(const Job&) = delete;
+			Job& operator=(const Job&) = delete;
 
 			/**
 			 * The api used for job ordering.
-			 * It will be ensured that every result asked for by consumes() will be passed into
-			 * execute(), and every result declared by produces() MUST be returned by execute.
+			 * Jobs declare what they need and provide as Input<T> and Output<T> members, which register themselves here.
+			 * It will be ensured that every Input is available when execute() is called, and every Output MUST be
+			 * filled by execute().
 			 *
-			 * This will only be called once, at job queue time. They should not be dependent upon previous frame data.
+			 * These are only read at job queue time, when ports are matched by name and their types are checked.
 			 */
-			virtual const std::vector<const std::string>* produces() const = 0;
-			virtual const std::vector<const std::string>* consumes() const = 0;
+			const std::vector<PortBase*>& inputs() const { return m_inputs; }
+			const std::vector<PortBase*>& outputs() const { return m_outputs; }
 
 			/**
 			 * The work that will be performed per-frame.
-			 * inputs: An array of inputs of the same length and order as returned from consumes()
+			 * Inputs are read with Input::get(context), and outputs are filled with Output::emplace(context, ...).
+			 * The WorkerPool never deletes a result: small ones live inline in their result slot, and larger ones in
+			 * the worker's frame arena, which is reclaimed in bulk once the frame is done.
+			 *
+			 * execute() is called from a worker thread, and may run concurrently with any other job.
+			 * It is never run concurrently with itself: frame N+1 of a job always waits for frame N of that job.
+			 */
+			virtual void execute(JobContext& context) = 0;
+
+			/**
+			 * When several frames are in flight, a job may start the next frame as soon as its own inputs are ready,
+			 * while other jobs are still finishing the previous frame.
+			 * Jobs that touch state shared with other jobs outside of their results (eg. render submission)
+			 * should return true, so that they only start once every job of the previous frame has finished.
+			 *
+			 * This will only be called once, at job queue time.
+			 */
+			virtual bool hasCrossFrameHazard() const { return false; }
+
+			/**
+			 * Critical jobs run ahead of all other queued work. Background jobs only run when nothing else is queued,
+			 * but are not held to the background budget, as their frame cannot finish without them.
+			 * Among the rest, jobs at the head of the longest remaining chain (by measured run time) go first.
+			 *
+			 * This will only be called once, at job queue time.
 			 */
-			virtual const JobResult* execute(const JobResult* inputs) = 0;
+			virtual Priority priority() const { return Priority::Normal; }
+
+			// What the job is called in traces. Must outlive the job, so normally a string literal.
+			virtual const char* name() const { return "Job"; }
+
+		private:
+			friend class PortBase;
+
+			// Called by each port as it is constructed
+			void registerPort(PortBase* port);
+
+			std::vector<PortBase*> m_inputs;
+			std::vector<PortBase*> m_outputs;
 		};
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "WorkForce/LinearArena.hpp"
+#include "WorkForce/ResultSlot.hpp"
+#include "WorkForce/Worker.hpp"
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace FRST {
+	namespace WorkForce {
+		class JobDependencyTracker;
+
+		class JobCompletion {
+		public:
+			/*
+			 * Marks a job whose execute() returned before its work was done as finished for the frame.
+			 * See JobContext::defer().
+			 */
+			void complete();
+
+		private:
+			friend class JobContext;
+
+			JobCompletion(JobDependencyTracker* tracker, uint64_t frame)
+				: m_tracker(tracker)
+				, m_frame(frame) {}
+
+			JobDependencyTracker* m_tracker;
+			uint64_t m_frame;
+		};
+
+		class JobContext {
+		public:
+			/*
+			 * Everything a job can reach while it executes for one frame.
+			 *
+			 * Results are read and written through the job's Input and Output ports, which index straight into
+			 * this frame's result slots. Anything else a job needs to keep for the frame should be built with create(),
+			 * which places it in the running worker's arena. That memory is reclaimed all at once when the frame
+			 * finishes, so nothing needs to be deleted.
+			 */
+			JobContext(ResultSlot* results, JobDependencyTracker* tracker, uint64_t frame)
+				: m_results(results)
+				, m_tracker(tracker)
+				, m_frame(frame)
+				, m_deferred(false) {}
+
+			// Build an object that lives until the frame has finished
+			template<class T, class... Args>
+			T* create(Args&&... args) {
+				return arena().create<T>(std::forward<Args>(args)...);
+			}
+
+			const ResultSlot& resultSlot(ResultID id) const { return m_results[id]; }
+			ResultSlot& resultSlot(ResultID id) { return m_results[id]; }
+
+			/*
+			 * Keep the job running after execute() returns, until complete() is called on the returned object.
+			 * Nothing waiting on the job is released until then. Used by AsyncJob.
+			 */
+			JobCompletion defer() {
+				assert(!m_deferred && "JobContext::defer() may only be called once");
+				m_deferred = true;
+				return JobCompletion(m_tracker, m_frame);
+			}
+			bool isDeferred() const { return m_deferred; }
+
+			// The worker currently running the job, and its arena for this frame
+			Worker& worker() { return *Worker::current(); }
+			LinearArena& arena() { return worker().frameArena(m_frame); }
+			uint64_t frame() const { return m_frame; }
+
+		private:
+			ResultSlot* m_results;
+			JobDependencyTracker* m_tracker;
+			uint64_t m_frame;
+			bool m_deferred;
+		};
+	}
+}
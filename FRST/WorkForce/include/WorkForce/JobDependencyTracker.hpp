@@ -1,14 +1,20 @@
 #pragma once
 
-#include "WorkForce/JobResult.hpp"
-#include <map>
+#include "WorkForce/Job.hpp"
+#include "WorkForce/ResultSlot.hpp"
+#include "WorkForce/WorkItem.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
-#include <string>
 #include <vector>
 
 
 namespace FRST {
 	namespace WorkForce {
+		class JobGraph;
+		class WorkerPool;
+
 		class JobDependencyTracker {
 		public:
 			/**
@@ -16,35 +22,95 @@ namespace FRST {
 			 * A job will not be triggered in a frame if all of its dependencies are not satisfied.
 			 * Dependencies will be held by many trackers at a time, and as such the trackers are not responsible
 			 * for their memory management.
+			 *
+			 * Trackers are built by JobGraph::compile(), which resolves every port to a result slot up front.
+			 * At runtime a tracker is only a countdown of producer jobs, so dispatching a frame does no
+			 * allocation or string work.
+			 *
+			 * With several frames in flight the tracker keeps one countdown per in-flight frame.
+			 * Besides its producers, the job in frame N waits on:
+			 *		The same job in frame N - 1, so a job never runs concurrently with itself
+			 *		The start of frame N, if it has no producers
+			 *		Every job of frame N - 1, if it has a cross frame hazard
 			 */
-			JobDependencyTracker();
+			JobDependencyTracker(Job* job, WorkerPool& pool, size_t framesInFlight);
 			~JobDependencyTracker();
 
+			JobDependencyTracker(const JobDependencyTracker&) = delete;
+			JobDependencyTracker& operator=(const JobDependencyTracker&) = delete;
+
 			/**
-			 * Resets the gathered job results for the next frame.
-			 * Pointes to held results will not be deleted.
-			 * The returned vector should be used when running the associated job.
-			 *
-			 * reset() may be called anytime after addResult returns true, and will contain the most up-to-date
-			 * version of each result.
+			 * Arm the countdowns of every in-flight frame, with firstFrame being the first frame to run.
+			 * Must not be called while a frame is running.
+			 * After this, each countdown is rearmed for frame N + framesInFlight as soon as frame N starts running.
 			 */
-			std::unique_ptr<const std::vector<const JobResult*>> reset();
+			void arm(uint64_t firstFrame);
 
 			/**
-			 * Add a new result for this job.
-			 * Returns true when the job should be queueud to run.
-			 * Overwrites the old result for resultName if one was already present.
+			 * Mark one dependency of this job in the given frame as finished.
+			 * Returns true (exactly once per frame) when workItem(frame) should be queued to run.
 			 */
-			bool addResult(const std::string& resultName, const JobResult* result);
+			bool resolveDependency(uint64_t frame);
+
+			// The WorkItem that runs this job for the given frame.
+			WorkItem* workItem(uint64_t frame) { return &instance(frame); }
+
+			Job* job() const { return m_job; }
+			Priority priority() const { return m_priority; }
+			// A moving average of how long execute() takes, in nanoseconds
+			uint64_t cost() const { return m_cost.load(std::memory_order_relaxed); }
+			// The cost of the longest chain of jobs starting with this one. Kept up to date by JobGraph::updateRanks().
+			uint64_t rank() const { return m_rank.load(std::memory_order_relaxed); }
+			size_t producerCount() const { return m_producerCount; }
+			bool hasCrossFrameHazard() const { return m_hasCrossFrameHazard; }
+
 		private:
-			// A map of job results to their indices in m_jobResults.
-			const std::map<std::string, size_t> m_jobResultIndexMap;
-			// The saved job results for this job.
-			// Size will not change. Unsatisfied indices will be nullptr until they are satisfied.
-			std::vector<const JobResult*>* m_jobResults;
-
-			// To ensure a job is only run once per frame.
-			bool m_hasRunThisFrame;
+			friend class JobGraph;
+			friend class JobCompletion;
+
+			// The state of the job for one in-flight frame
+			struct FrameInstance : public WorkItem {
+				JobDependencyTracker* tracker;
+				// The frame this instance will run next
+				uint64_t frame;
+				std::atomic<uint32_t> remainingDependencies;
+#ifdef FRST_TRACE_ENABLED
+				// When the last dependency was resolved, for tracing
+				uint64_t readyTime;
+#endif
+			};
+
+			static void executeJob(WorkItem* item, Worker& worker);
+			// Release everything waiting on the job in this frame
+			void completeJob(uint64_t frame);
+			// Fold the time one execute() took into the cost
+			void measure(std::chrono::steady_clock::duration duration);
+
+			FrameInstance& instance(uint64_t frame) { return m_instances[frame % m_framesInFlight]; }
+			uint32_t dependencyCount(uint64_t frame) const;
+
+			Job* m_job;
+			WorkerPool& m_pool;
+			const size_t m_framesInFlight;
+			const bool m_hasCrossFrameHazard;
+			const Priority m_priority;
+
+			// Written by whichever worker ran the job last, and read while ranking
+			std::atomic<uint64_t> m_cost;
+			std::atomic<uint64_t> m_rank;
+
+			// The number of distinct jobs that produce something this job consumes.
+			uint32_t m_producerCount;
+			// The first frame since the tracker was armed, which has no previous frame to wait on.
+			uint64_t m_firstFrame;
+
+			std::unique_ptr<FrameInstance[]> m_instances;
+
+			// The slots this job must fill, to check that it did
+			std::vector<ResultID> m_outputIDs;
+
+			// Every job that waits on this one, without duplicates.
+			std::vector<JobDependencyTracker*> m_successors;
 		};
 	}
 }
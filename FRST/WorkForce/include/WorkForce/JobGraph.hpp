@@ -0,0 +1,77 @@
+#pragma once
+
+#include "WorkForce/Job.hpp"
+#include "WorkForce/JobDependencyTracker.hpp"
+#include "WorkForce/Port.hpp"
+#include "WorkForce/ResultSlot.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		class WorkerPool;
+
+		class JobGraph {
+		public:
+			/*
+			 * The static dependency graph of every per-frame job.
+			 *
+			 * Jobs are registered with addJob(), and compile() connects their Input and Output ports by name into
+			 * JobDependencyTrackers that are wired directly to each other. Result names are interned to dense
+			 * ResultIDs, which index the result slots of each frame, and are never looked at while a frame is running.
+			 *
+			 * Every result must have exactly one producer, and every port using a name must agree on its type.
+			 * Jobs that consume a result nobody produces (directly or through another such job) can never be
+			 * triggered and are left out of the graph.
+			 */
+			JobGraph();
+			~JobGraph();
+
+			JobGraph(const JobGraph&) = delete;
+			JobGraph& operator=(const JobGraph&) = delete;
+
+			// Register a job. The graph must be recompiled before the job will run.
+			void addJob(Job* job);
+
+			/*
+			 * Build the trackers for every registered job, each with state for framesInFlight frames.
+			 * Throws std::logic_error if a result has more than one producer, if ports of the same name have
+			 * different types, or if the jobs form a cycle.
+			 */
+			void compile(WorkerPool& pool, size_t framesInFlight);
+
+			/*
+			 * Recompute every job's rank from the latest measured costs, and put the highest ranked roots first.
+			 * Only called between frames, from the thread that starts them.
+			 */
+			void updateRanks();
+
+			// Whether a job was added since the last compile()
+			bool isDirty() const { return m_dirty; }
+
+			// Every runnable job, in topological order.
+			const std::vector<std::unique_ptr<JobDependencyTracker>>& trackers() const { return m_trackers; }
+			// The jobs with no dependencies, which start each frame.
+			const std::vector<JobDependencyTracker*>& roots() const { return m_roots; }
+			// The jobs that must wait for the whole previous frame to finish.
+			const std::vector<JobDependencyTracker*>& hazards() const { return m_hazards; }
+
+			size_t numResults() const { return m_resultIDs.size(); }
+
+		private:
+			ResultID internResult(const PortBase& port);
+
+			std::vector<Job*> m_jobs;
+			std::unordered_map<std::string, ResultID> m_resultIDs;
+			std::vector<PortType> m_resultTypes;
+			bool m_dirty;
+
+			std::vector<std::unique_ptr<JobDependencyTracker>> m_trackers;
+			std::vector<JobDependencyTracker*> m_roots;
+			std::vector<JobDependencyTracker*> m_hazards;
+		};
+	}
+}
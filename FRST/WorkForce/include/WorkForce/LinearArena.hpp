@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		class LinearArena {
+		public:
+			/*
+			 * A bump allocator whose memory is all given back at once by reset().
+			 *
+			 * Memory comes from a list of chunks that are kept across resets, so once the arena has grown
+			 * to the size of a frame's worth of allocations it never touches the heap again.
+			 * Objects created with create<T>() are destroyed by reset(). Trivially destructible types are not
+			 * tracked at all, so resetting an arena full of them is O(1).
+			 *
+			 * An arena is not thread-safe. Each worker has its own for every frame in flight.
+			 */
+			explicit LinearArena(size_t chunkSize = 64 * 1024);
+			~LinearArena();
+
+			LinearArena(const LinearArena&) = delete;
+			LinearArena& operator=(const LinearArena&) = delete;
+
+			// Raw memory that lives until the next reset()
+			void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+				uintptr_t aligned = (m_current + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+				if (aligned + size > m_end) {
+					return allocateSlow(size, alignment);
+				}
+				m_current = aligned + size;
+				return reinterpret_cast<void*>(aligned);
+			}
+
+			// Construct an object that lives until the next reset()
+			template<class T, class... Args>
+			T* create(Args&&... args) {
+				if constexpr (std::is_trivially_destructible<T>::value) {
+					return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+				} else {
+					// Allocate the record first so a throwing constructor leaves nothing to destroy
+					Destructor* destructor = static_cast<Destructor*>(allocate(sizeof(Destructor), alignof(Destructor)));
+					T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+					destructor->destroy = &destroyObject<T>;
+					destructor->object = object;
+					destructor->next = m_destructors;
+					m_destructors = destructor;
+					return object;
+				}
+			}
+
+			// An uninitialized array of trivially destructible elements that lives until the next reset()
+			template<class T>
+			T* allocateArray(size_t count) {
+				static_assert(std::is_trivially_destructible<T>::value, "Arena arrays are never destroyed");
+				return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+			}
+
+			// Destroy every non-trivial object and make all memory available again
+			void reset();
+
+			// The number of bytes handed out since the last reset, including alignment padding
+			size_t bytesUsed() const;
+			// The total size of every chunk owned by the arena
+			size_t bytesReserved() const;
+
+		private:
+			struct Chunk {
+				std::unique_ptr<unsigned char[]> memory;
+				size_t size;
+			};
+
+			// Objects are destroyed newest first, like the stack
+			struct Destructor {
+				void (*destroy)(void* object);
+				void* object;
+				Destructor* next;
+			};
+
+			template<class T>
+			static void destroyObject(void* object) {
+				static_cast<T*>(object)->~T();
+			}
+
+			void* allocateSlow(size_t size, size_t alignment);
+			void useChunk(size_t index);
+
+			const size_t m_chunkSize;
+			std::vector<Chunk> m_chunks;
+			// The chunk currently being bumped through
+			size_t m_chunkIndex;
+			uintptr_t m_current;
+			uintptr_t m_end;
+			// Bytes used in every chunk before the current one
+			size_t m_bytesInFullChunks;
+
+			Destructor* m_destructors;
+		};
+	}
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include "WorkForce/Worker.hpp"
+#include "WorkForce/WorkerPool.hpp"
+#include "WorkForce/WorkItem.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace FRST {
+	namespace WorkForce {
+		/*
+		 * Data-parallel loops over an index range, run on the WorkerPool.
+		 *
+		 * Ranges are split lazily: a worker only halves its range when its own deque is empty, meaning nobody
+		 * has anything of ours to steal. The right half is pushed where idle workers can steal it, and the left
+		 * half is worked through grain indices at a time, splitting again only once the right half was taken.
+		 * A range nobody steals is therefore run as one plain loop, with no task overhead.
+		 *
+		 * Called from a worker (eg. inside Job::execute) the caller runs chunks itself and helps with other work
+		 * while waiting for stolen halves. Called from any other thread the loop is handed to the pool, and the
+		 * caller blocks until it is finished.
+		 */
+		struct Range {
+			size_t begin;
+			size_t end;
+
+			size_t size() const { return end - begin; }
+		};
+
+		// Whether a worker should expose half of its range for stealing
+		inline bool shouldSplitRange(Worker& worker) {
+			return worker.pool().numWorkers() > 1 && !worker.hasQueuedWork();
+		}
+
+		// The stealable half of a split range, owned by the stack frame that split it
+		template<class Body>
+		class ForkedRange : public WorkItem {
+		public:
+			ForkedRange(Body& body, Range range, size_t grain, bool notifyExternal)
+				: WorkItem{ &ForkedRange::run }
+				, m_body(body)
+				, m_range(range)
+				, m_grain(grain)
+				, m_notifyExternal(notifyExternal)
+				, m_done(false) {}
+
+			// Push onto the worker's deque, where idle workers can steal it
+			void forkFrom(Worker& worker) {
+				worker.push(this);
+			}
+			// Pop it back and run it if nobody stole it, otherwise help with other work until it is done
+			void joinOn(Worker& worker) {
+				worker.runUntil(m_done);
+			}
+
+			// For callers outside the pool
+			void runExternally(WorkerPool& pool) {
+				pool.submit(this);
+				pool.waitExternally(m_done);
+			}
+
+			Body& body() { return m_body; }
+
+		private:
+			static void run(WorkItem* item, Worker& worker) {
+				ForkedRange& task = *static_cast<ForkedRange*>(item);
+				task.m_body.run(worker, task.m_range, task.m_grain);
+
+				// The task may be destroyed by its owner as soon as m_done is set
+				bool notifyExternal = task.m_notifyExternal;
+				WorkerPool& pool = worker.pool();
+				task.m_done.store(true, std::memory_order_release);
+				if (notifyExternal) {
+					pool.notifyExternalWaiters();
+				}
+			}
+
+			Body& m_body;
+			const Range m_range;
+			const size_t m_grain;
+			const bool m_notifyExternal;
+			std::atomic<bool> m_done;
+		};
+
+		template<class Function>
+		class ParallelForBody {
+		public:
+			explicit ParallelForBody(Function& function)
+				: m_function(function) {}
+
+			void run(Worker& worker, Range range, size_t grain) {
+				while (range.size() > grain) {
+					if (shouldSplitRange(worker)) {
+						size_t middle = range.begin + range.size() / 2;
+						ForkedRange<ParallelForBody> right(*this, Range{ middle, range.end }, grain, false);
+						right.forkFrom(worker);
+						run(worker, Range{ range.begin, middle }, grain);
+						right.joinOn(worker);
+						return;
+					}
+
+					size_t chunkEnd = range.begin + grain;
+					for (size_t i = range.begin; i < chunkEnd; i++) {
+						m_function(i);
+					}
+					range.begin = chunkEnd;
+				}
+
+				for (size_t i = range.begin; i < range.end; i++) {
+					m_function(i);
+				}
+			}
+
+		private:
+			Function& m_function;
+		};
+
+		template<class T, class Reduce, class Combine>
+		class ParallelReduceBody {
+		public:
+			ParallelReduceBody(const T& identity, Reduce& reduce, Combine& combine)
+				: m_identity(identity)
+				, m_reduce(reduce)
+				, m_combine(combine)
+				, m_result(identity) {}
+
+			// A fresh body for a stolen half, sharing the functions but with its own result
+			ParallelReduceBody(const ParallelReduceBody& other)
+				: m_identity(other.m_identity)
+				, m_reduce(other.m_reduce)
+				, m_combine(other.m_combine)
+				, m_result(other.m_identity) {}
+
+			void run(Worker& worker, Range range, size_t grain) {
+				m_result = m_combine(std::move(m_result), reduceRange(worker, range, grain));
+			}
+
+			T& result() { return m_result; }
+
+		private:
+			T reduceRange(Worker& worker, Range range, size_t grain) {
+				T accumulated = m_identity;
+				while (range.size() > grain) {
+					if (shouldSplitRange(worker)) {
+						size_t middle = range.begin + range.size() / 2;
+						ParallelReduceBody rightBody(*this);
+						ForkedRange<ParallelReduceBody> right(rightBody, Range{ middle, range.end }, grain, false);
+						right.forkFrom(worker);
+						accumulated = m_combine(std::move(accumulated), reduceRange(worker, Range{ range.begin, middle }, grain));
+						right.joinOn(worker);
+						return m_combine(std::move(accumulated), std::move(rightBody.result()));
+					}
+
+					size_t chunkEnd = range.begin + grain;
+					for (size_t i = range.begin; i < chunkEnd; i++) {
+						accumulated = m_reduce(std::move(accumulated), i);
+					}
+					range.begin = chunkEnd;
+				}
+
+				for (size_t i = range.begin; i < range.end; i++) {
+					accumulated = m_reduce(std::move(accumulated), i);
+				}
+				return accumulated;
+			}
+
+			const T& m_identity;
+			Reduce& m_reduce;
+			Combine& m_combine;
+			T m_result;
+		};
+
+		/*
+		 * Call function(i) for every i in range, in parallel.
+		 * grain is the smallest number of indices worth running as one piece of work.
+		 */
+		template<class Function>
+		void parallelFor(WorkerPool& pool, Range range, size_t grain, Function&& function) {
+			if (grain == 0) {
+				grain = 1;
+			}
+			ParallelForBody<Function> body(function);
+
+			Worker* worker = Worker::current();
+			if (worker && &worker->pool() == &pool) {
+				body.run(*worker, range, grain);
+			} else {
+				ForkedRange<ParallelForBody<Function>> root(body, range, grain, true);
+				root.runExternally(pool);
+			}
+		}
+
+		/*
+		 * Fold every index of range into a value, in parallel.
+		 * reduce(T accumulated, size_t i) -> T folds in one index, combine(T left, T right) -> T merges the
+		 * results of two neighbouring pieces. combine must be associative and identity must be its identity,
+		 * but neither needs to be commutative: pieces are always combined in index order.
+		 */
+		template<class T, class Reduce, class Combine>
+		T parallelReduce(WorkerPool& pool, Range range, size_t grain, const T& identity, Reduce&& reduce, Combine&& combine) {
+			if (grain == 0) {
+				grain = 1;
+			}
+			ParallelReduceBody<T, Reduce, Combine> body(identity, reduce, combine);
+
+			Worker* worker = Worker::current();
+			if (worker && &worker->pool() == &pool) {
+				body.run(*worker, range, grain);
+			} else {
+				ForkedRange<ParallelReduceBody<T, Reduce, Combine>> root(body, range, grain, true);
+				root.runExternally(pool);
+			}
+			return std::move(body.result());
+		}
+
+		template<class Function>
+		class ParallelForAwaiter : public WorkItem {
+		public:
+			ParallelForAwaiter(WorkerPool& pool, Range range, size_t grain, Function function)
+				: WorkItem{ &ParallelForAwaiter::run }
+				, m_pool(pool)
+				, m_range(range)
+				, m_grain(grain == 0 ? 1 : grain)
+				, m_function(std::move(function))
+				, m_body(m_function)
+				, m_handle() {}
+
+			// m_body refers to m_function, so the awaiter must stay where it was built
+			ParallelForAwaiter(const ParallelForAwaiter&) = delete;
+			ParallelForAwaiter& operator=(const ParallelForAwaiter&) = delete;
+
+			bool await_ready() const noexcept { return m_range.size() == 0; }
+			void await_suspend(std::coroutine_handle<> handle) {
+				m_handle = handle;
+				m_pool.submit(this);
+			}
+			void await_resume() noexcept {}
+
+		private:
+			static void run(WorkItem* item, Worker& worker) {
+				ParallelForAwaiter& awaiter = *static_cast<ParallelForAwaiter*>(item);
+				awaiter.m_body.run(worker, awaiter.m_range, awaiter.m_grain);
+				awaiter.m_handle.resume();
+			}
+
+			WorkerPool& m_pool;
+			const Range m_range;
+			const size_t m_grain;
+			Function m_function;
+			ParallelForBody<Function> m_body;
+			std::coroutine_handle<> m_handle;
+		};
+
+		/*
+		 * co_await parallelForAsync(pool, range, grain, function) is parallelFor() for a Task.
+		 * The Task is suspended while the loop runs, and resumed on whichever worker finishes it.
+		 */
+		template<class Function>
+		ParallelForAwaiter<std::decay_t<Function>> parallelForAsync(WorkerPool& pool, Range range, size_t grain, Function&& function) {
+			return ParallelForAwaiter<std::decay_t<Function>>(pool, range, grain, std::forward<Function>(function));
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "WorkForce/JobContext.hpp"
+#include "WorkForce/ResultSlot.hpp"
+#include <cassert>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace FRST {
+	namespace WorkForce {
+		class Job;
+		class JobGraph;
+
+		// Identifies a result type without RTTI. Every type has a distinct tag address.
+		typedef const void* PortType;
+
+		template<class T>
+		struct PortTypeTag {
+			static constexpr char tag = 0;
+		};
+
+		template<class T>
+		constexpr PortType portType() {
+			return &PortTypeTag<typename std::remove_cv<T>::type>::tag;
+		}
+
+		class PortBase {
+		public:
+			/*
+			 * The untyped part of a job's Input or Output.
+			 * A port registers itself with the job that owns it, and the JobGraph connects ports with the
+			 * same name when it is compiled, checking that their types match.
+			 */
+			PortBase(const PortBase&) = delete;
+			PortBase& operator=(const PortBase&) = delete;
+
+			const std::string& name() const { return m_name; }
+			PortType type() const { return m_type; }
+			bool isOutput() const { return m_isOutput; }
+
+		protected:
+			PortBase(Job* job, std::string name, PortType type, bool isOutput);
+
+			const ResultSlot& slot(const JobContext& context) const { return context.resultSlot(m_resultID); }
+			ResultSlot& slot(JobContext& context) const { return context.resultSlot(m_resultID); }
+
+		private:
+			friend class JobGraph;
+
+			const std::string m_name;
+			const PortType m_type;
+			const bool m_isOutput;
+			// Assigned when the graph is compiled
+			ResultID m_resultID;
+		};
+
+		template<class T>
+		class Input : public PortBase {
+		public:
+			/*
+			 * A result that a job needs before it can run. Declare it as a member of the job:
+			 *		Input<InputState> m_input{ this, "input.state" };
+			 * and read it in execute() with m_input.get(context).
+			 */
+			Input(Job* job, std::string name)
+				: PortBase(job, std::move(name), portType<T>(), false) {}
+
+			const T& get(const JobContext& context) const {
+				const ResultSlot& resultSlot = slot(context);
+				assert(resultSlot.frame == context.frame() && "Job input was produced in a different frame");
+				return *static_cast<const T*>(resultSlot.value);
+			}
+		};
+
+		template<class T>
+		class Output : public PortBase {
+		public:
+			/*
+			 * A result that a job must provide every time it runs. Declare it as a member of the job:
+			 *		Output<TerrainChunkBatch> m_chunks{ this, "terrain.chunks" };
+			 * and fill it in execute() with m_chunks.emplace(context, ...) or m_chunks.set(context, ...).
+			 */
+			Output(Job* job, std::string name)
+				: PortBase(job, std::move(name), portType<T>(), true) {}
+
+			// Whether a T is small enough to be stored directly in its result slot
+			static constexpr bool STORED_INLINE =
+				sizeof(T) <= ResultSlot::INLINE_SIZE &&
+				alignof(T) <= ResultSlot::INLINE_ALIGNMENT &&
+				std::is_trivially_destructible<T>::value;
+
+			// Build the result for this frame. It is reclaimed when the frame has finished.
+			template<class... Args>
+			T* emplace(JobContext& context, Args&&... args) const {
+				ResultSlot& resultSlot = slot(context);
+				T* value;
+				if constexpr (STORED_INLINE) {
+					value = new (resultSlot.storage) T(std::forward<Args>(args)...);
+				} else {
+					value = context.create<T>(std::forward<Args>(args)...);
+				}
+				resultSlot.value = value;
+				resultSlot.frame = context.frame();
+				return value;
+			}
+
+			// Publish a result that is owned elsewhere. It must stay alive until the frame has finished.
+			void set(JobContext& context, const T* value) const {
+				ResultSlot& resultSlot = slot(context);
+				resultSlot.value = value;
+				resultSlot.frame = context.frame();
+			}
+		};
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace FRST {
+	namespace WorkForce {
+		/*
+		 * How urgently a piece of work should run.
+		 *		Critical work runs before anything else that is queued, eg. input -> simulation -> render submission.
+		 *		Normal work is ordered by the job graph, longest remaining chain first.
+		 *		Background work only runs when a worker has nothing else to do. Outside the job graph it is also limited
+		 *		to WorkerPoolConfig::backgroundBudget per frame, and whatever does not fit waits for the next frame.
+		 */
+		enum class Priority {
+			Critical,
+			Normal,
+			Background
+		};
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FRST {
+	namespace WorkForce {
+		// A dense id for a named result, assigned when the job graph is compiled
+		typedef uint32_t ResultID;
+
+		struct alignas(64) ResultSlot {
+			/*
+			 * Where one result of one frame is handed from its producer to its consumers.
+			 * There is one slot per result for every frame in flight, each on its own cache line.
+			 *
+			 * Small trivially destructible results are built directly in storage, anything else lives in
+			 * the producing worker's frame arena and is only pointed to.
+			 */
+			static const size_t INLINE_SIZE = 40;
+			static const size_t INLINE_ALIGNMENT = 16;
+
+			const void* value;
+			// The frame that wrote value, so results from two frames can never be mixed
+			uint64_t frame;
+			alignas(INLINE_ALIGNMENT) unsigned char storage[INLINE_SIZE];
+		};
+	}
+}
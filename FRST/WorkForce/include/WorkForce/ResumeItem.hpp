@@ -0,0 +1,28 @@
+#pragma once
+
+#include "WorkForce/WorkItem.hpp"
+#include <coroutine>
+
+namespace FRST {
+	namespace WorkForce {
+		struct ResumeItem : public WorkItem {
+			/*
+			 * Resumes a suspended coroutine on whichever worker picks it up.
+			 * Awaiters embed one of these, so handing a coroutine back to the pool never allocates.
+			 * next is free for whoever holds the item while the coroutine is suspended, to chain waiters together.
+			 */
+			ResumeItem()
+				: WorkItem{ &ResumeItem::resume }
+				, handle()
+				, next(nullptr) {}
+
+			std::coroutine_handle<> handle;
+			ResumeItem* next;
+
+		private:
+			static void resume(WorkItem* item, Worker&) {
+				static_cast<ResumeItem*>(item)->handle.resume();
+			}
+		};
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace FRST {
+	namespace WorkForce {
+		template<class T>
+		class SpscRing {
+		public:
+			/*
+			 * A fixed size lock-free queue from exactly one producing thread to exactly one consuming thread.
+			 *
+			 * Each side keeps a cached copy of the other's index and only reloads it when the ring looks full
+			 * (or empty), so a push or pop normally touches no cache line the other thread is writing.
+			 * T must be default constructible and copy assignable. The capacity is rounded up to a power of two.
+			 */
+			explicit SpscRing(size_t capacity = 4096)
+				: m_capacity(roundToPowerOfTwo(capacity))
+				, m_mask(m_capacity - 1)
+				, m_items(new T[m_capacity])
+				, m_head(0)
+				, m_cachedTail(0)
+				, m_tail(0)
+				, m_cachedHead(0) {}
+
+			SpscRing(const SpscRing&) = delete;
+			SpscRing& operator=(const SpscRing&) = delete;
+
+			// Producer only. Returns false, without adding the item, if the ring is full.
+			bool push(const T& item) {
+				size_t tail = m_tail.load(std::memory_order_relaxed);
+				if (tail - m_cachedHead == m_capacity) {
+					m_cachedHead = m_head.load(std::memory_order_acquire);
+					if (tail - m_cachedHead == m_capacity) {
+						return false;
+					}
+				}
+				m_items[tail & m_mask] = item;
+				m_tail.store(tail + 1, std::memory_order_release);
+				return true;
+			}
+
+			// Consumer only. The oldest item, or nullptr if the ring is empty. Stays valid until pop().
+			const T* front() {
+				size_t head = m_head.load(std::memory_order_relaxed);
+				if (head == m_cachedTail) {
+					m_cachedTail = m_tail.load(std::memory_order_acquire);
+					if (head == m_cachedTail) {
+						return nullptr;
+					}
+				}
+				return &m_items[head & m_mask];
+			}
+
+			// Consumer only. Removes the item front() returned, which must not have been nullptr.
+			void pop() {
+				m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			}
+
+			// Consumer only. Copies the oldest item into item and removes it, or returns false if the ring is empty.
+			bool pop(T& item) {
+				const T* oldest = front();
+				if (oldest == nullptr) {
+					return false;
+				}
+				item = *oldest;
+				pop();
+				return true;
+			}
+
+			size_t capacity() const { return m_capacity; }
+
+			// A racy snapshot, only suitable as a hint.
+			bool empty() const {
+				return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_relaxed);
+			}
+
+		private:
+			static size_t roundToPowerOfTwo(size_t value) {
+				size_t result = 2;
+				while (result < value) {
+					result <<= 1;
+				}
+				return result;
+			}
+
+			const size_t m_capacity;
+			const size_t m_mask;
+			const std::unique_ptr<T[]> m_items;
+
+			// The consumer's side: the next item to read, and the last tail it saw
+			alignas(64) std::atomic<size_t> m_head;
+			size_t m_cachedTail;
+			// The producer's side: the next slot to write, and the last head it saw
+			alignas(64) std::atomic<size_t> m_tail;
+			size_t m_cachedHead;
+		};
+	}
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "WorkForce/ResumeItem.hpp"
+#include "WorkForce/WorkerPool.hpp"
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace FRST {
+	namespace WorkForce {
+		template<class T>
+		class Task;
+
+		// The parts of a Task's promise that do not depend on its result type
+		class TaskPromiseBase {
+		public:
+			struct FinalAwaiter {
+				bool await_ready() noexcept { return false; }
+
+				template<class Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+					TaskPromiseBase& promise = handle.promise();
+					if (promise.m_continuation) {
+						// Go straight back to whoever awaited us, on this worker
+						return promise.m_continuation;
+					}
+					if (promise.m_detached) {
+						handle.destroy();
+					}
+					return std::noop_coroutine();
+				}
+
+				void await_resume() noexcept {}
+			};
+
+			// Tasks do nothing until they are awaited or spawned
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			FinalAwaiter final_suspend() noexcept { return {}; }
+
+			void unhandled_exception() {
+				if (m_detached) {
+					// Nobody is left to rethrow it to, the same as an exception escaping a std::thread
+					std::terminate();
+				}
+				m_exception = std::current_exception();
+			}
+
+		protected:
+			template<class T>
+			friend class Task;
+			friend void spawn(WorkerPool& pool, Task<void> task, Priority priority);
+			friend void runDetached(Task<void> task);
+
+			void rethrowIfFailed() {
+				if (m_exception) {
+					std::rethrow_exception(m_exception);
+				}
+			}
+
+			std::coroutine_handle<> m_continuation;
+			std::exception_ptr m_exception;
+			bool m_detached = false;
+			// Used to queue the task when it is spawned
+			ResumeItem m_start;
+		};
+
+		template<class T>
+		class TaskPromise : public TaskPromiseBase {
+		public:
+			Task<T> get_return_object();
+
+			template<class Value>
+			void return_value(Value&& value) {
+				m_value.emplace(std::forward<Value>(value));
+			}
+
+			T takeResult() {
+				rethrowIfFailed();
+				return std::move(*m_value);
+			}
+
+		private:
+			std::optional<T> m_value;
+		};
+
+		template<>
+		class TaskPromise<void> : public TaskPromiseBase {
+		public:
+			Task<void> get_return_object();
+
+			void return_void() {}
+
+			void takeResult() {
+				rethrowIfFailed();
+			}
+		};
+
+		template<class T = void>
+		class Task {
+		public:
+			/*
+			 * A coroutine that runs on the WorkerPool, and may suspend without holding up its worker.
+			 *
+			 * A Task is lazy. It starts when it is co_awaited by another Task, which runs it inline on the same
+			 * worker and is resumed with its result once it finishes, or when it is handed to spawn().
+			 * While a Task is suspended (eg. on an AsyncEvent, nextFrame() or parallelForAsync()) its worker
+			 * goes back to running other work, and the Task is queued back onto the pool when it can continue.
+			 * It may therefore resume on a different worker than it started on.
+			 *
+			 * T must be void or a movable value type. Exceptions are rethrown into the awaiting Task.
+			 */
+			typedef TaskPromise<T> promise_type;
+
+			Task(Task&& other) noexcept
+				: m_handle(std::exchange(other.m_handle, nullptr)) {}
+			Task& operator=(Task&& other) noexcept {
+				if (this != &other) {
+					destroy();
+					m_handle = std::exchange(other.m_handle, nullptr);
+				}
+				return *this;
+			}
+			~Task() {
+				destroy();
+			}
+
+			Task(const Task&) = delete;
+			Task& operator=(const Task&) = delete;
+
+			struct Awaiter {
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() noexcept { return false; }
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+					handle.promise().m_continuation = awaiting;
+					return handle;
+				}
+				T await_resume() {
+					return handle.promise().takeResult();
+				}
+			};
+
+			Awaiter operator co_await() && {
+				assert(m_handle && "Task has already been started");
+				return Awaiter{ m_handle };
+			}
+
+		private:
+			friend class TaskPromise<T>;
+			friend void spawn(WorkerPool& pool, Task<void> task, Priority priority);
+			friend void runDetached(Task<void> task);
+
+			explicit Task(std::coroutine_handle<promise_type> handle)
+				: m_handle(handle) {}
+
+			// Give up ownership, the coroutine frame will destroy itself once it finishes
+			std::coroutine_handle<promise_type> detach() {
+				assert(m_handle && "Task has already been started");
+				m_handle.promise().m_detached = true;
+				return std::exchange(m_handle, nullptr);
+			}
+
+			void destroy() {
+				if (m_handle) {
+					m_handle.destroy();
+					m_handle = nullptr;
+				}
+			}
+
+			std::coroutine_handle<promise_type> m_handle;
+		};
+
+		template<class T>
+		Task<T> TaskPromise<T>::get_return_object() {
+			return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() {
+			return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+		}
+
+		/*
+		 * Queue a task to run on the pool, with nothing waiting on its result.
+		 * The priority only applies to starting it. Once it suspends it is resumed as Normal work.
+		 */
+		inline void spawn(WorkerPool& pool, Task<void> task, Priority priority = Priority::Normal) {
+			std::coroutine_handle<TaskPromise<void>> handle = task.detach();
+			handle.promise().m_start.handle = handle;
+			pool.submit(&handle.promise().m_start, priority);
+		}
+
+		// Start a task on the calling worker right away, with nothing waiting on its result
+		inline void runDetached(Task<void> task) {
+			task.detach().resume();
+		}
+
+		class FrameAwaiter {
+		public:
+			// Throws std::logic_error if the pool has a single frame in flight, see nextFrame()
+			FrameAwaiter(WorkerPool& pool, uint64_t frame)
+				: m_pool(pool)
+				, m_frame(frame) {
+				if (pool.framesInFlight() < 2) {
+					throw std::logic_error("FrameAwaiter: waiting for the next frame needs at least 2 frames in flight");
+				}
+			}
+
+			bool await_ready() noexcept { return false; }
+			bool await_suspend(std::coroutine_handle<> handle) noexcept {
+				m_resume.handle = handle;
+				return m_pool.resumeAtFrame(&m_resume, m_frame);
+			}
+			void await_resume() noexcept {}
+
+		private:
+			WorkerPool& m_pool;
+			const uint64_t m_frame;
+			ResumeItem m_resume;
+		};
+
+		/*
+		 * co_await nextFrame(pool) suspends until the next call to WorkerPool::beginFrame().
+		 * From within a job this holds up the job's frame, which beginFrame() waits for with a single frame in flight,
+		 * so it throws std::logic_error unless the pool has at least 2.
+		 */
+		inline FrameAwaiter nextFrame(WorkerPool& pool) {
+			return FrameAwaiter(pool, pool.nextFrame());
+		}
+
+		/*
+		 * co_await nextFrame(context) suspends an AsyncJob until the frame after the one it is running for has begun.
+		 * That frame may already have begun, as frames are pipelined. The job holds up its own frame while it waits,
+		 * so this throws std::logic_error unless the pool has at least 2 frames in flight.
+		 */
+		inline FrameAwaiter nextFrame(JobContext& context) {
+			return FrameAwaiter(context.worker().pool(), context.frame() + 1);
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace FRST {
+	namespace WorkForce {
+		struct TraceEvent {
+			enum class Kind : uint32_t {
+				// A FRST_TRACE_SCOPE
+				Scope,
+				// One Job::execute()
+				Job,
+				// A whole frame, from beginFrame() until its last job finished
+				Frame
+			};
+
+			// Must outlive the trace, so normally a string literal
+			const char* name;
+			Kind kind;
+			// Nanoseconds, from Trace::now()
+			uint64_t begin;
+			uint64_t end;
+			uint64_t frame;
+			// Jobs only. Time from the start of the frame until the job's dependencies were met,
+			// and from then until a worker picked it up.
+			uint64_t dependencyWait;
+			uint64_t queueWait;
+			// Frames only. The WorkerPool slot the frame used, so that frames in flight together get a track each.
+			uint32_t frameSlot;
+		};
+
+		class Trace {
+		public:
+			/*
+			 * Low overhead timeline recording, for viewing in chrome://tracing or ui.perfetto.dev.
+			 *
+			 * Every thread records into its own fixed size ring buffer, with no locking and no allocation once the
+			 * buffer exists. Only the most recent events of each thread are kept. Writing a trace copies the
+			 * buffers while they are still being written, and drops any event that was being overwritten during the copy.
+			 *
+			 * Recording is compiled in when FRST_TRACE_ENABLED is defined (the FRST_TRACE CMake option).
+			 * Otherwise FRST_TRACE_SCOPE is empty, and writing a trace produces an empty one.
+			 */
+			static const uint64_t NO_FRAME = UINT64_MAX;
+			// How many events each thread keeps
+			static const size_t EVENTS_PER_THREAD = 1 << 14;
+
+			// A monotonic timestamp in nanoseconds
+			static uint64_t now();
+
+			// Add an event to the calling thread's buffer
+			static void record(const TraceEvent& event);
+
+			// Name the calling thread's track in the trace
+			static void setThreadName(const std::string& name);
+
+			// Write everything recorded so far as Chrome trace JSON. Safe to call while other threads are recording.
+			static void writeChromeJson(std::ostream& out);
+			// Returns false if the file could not be written
+			static bool writeChromeJson(const std::string& path);
+		};
+
+		class TraceScope {
+		public:
+			// Records the time between construction and destruction as a span on the calling thread
+			explicit TraceScope(const char* name, uint64_t frame = Trace::NO_FRAME)
+				: m_name(name)
+				, m_frame(frame)
+				, m_begin(Trace::now()) {}
+			~TraceScope() {
+				Trace::record(TraceEvent{ m_name, TraceEvent::Kind::Scope, m_begin, Trace::now(), m_frame, 0, 0, 0 });
+			}
+
+			TraceScope(const TraceScope&) = delete;
+			TraceScope& operator=(const TraceScope&) = delete;
+
+		private:
+			const char* m_name;
+			uint64_t m_frame;
+			uint64_t m_begin;
+		};
+	}
+}
+
+#define FRST_TRACE_CONCAT_INNER(a, b) a##b
+#define FRST_TRACE_CONCAT(a, b) FRST_TRACE_CONCAT_INNER(a, b)
+
+#ifdef FRST_TRACE_ENABLED
+// Time the rest of the enclosing scope. name must be a string literal.
+#define FRST_TRACE_SCOPE(name) ::FRST::WorkForce::TraceScope FRST_TRACE_CONCAT(frstTraceScope, __LINE__)(name)
+#define FRST_TRACE_SCOPE_FRAME(name, frame) ::FRST::WorkForce::TraceScope FRST_TRACE_CONCAT(frstTraceScope, __LINE__)(name, frame)
+#else
+#define FRST_TRACE_SCOPE(name)
+#define FRST_TRACE_SCOPE_FRAME(name, frame)
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace FRST {
+	namespace WorkForce {
+		class Worker;
+
+		struct WorkItem {
+			/*
+			 * The smallest unit of work that can be handed to a WorkerPool.
+			 * Anything that wants to run on a worker embeds (or inherits) one of these and points
+			 * execute at a static trampoline. This keeps the queues intrusive, so pushing work never allocates.
+			 *
+			 * The item must stay alive until execute has been called.
+			 */
+			typedef void (*ExecuteFunction)(WorkItem* item, Worker& worker);
+
+			ExecuteFunction execute;
+		};
+	}
+}
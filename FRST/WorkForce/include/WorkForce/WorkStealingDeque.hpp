@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		template<class T>
+		class WorkStealingDeque {
+		public:
+			/*
+			 * A lock-free Chase-Lev work-stealing deque, using the C11 memory model version from
+			 * "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+			 *
+			 * Only the owning thread may call push() and pop(), which work on the bottom of the deque.
+			 * Any thread may call steal(), which takes from the top.
+			 * T must be a pointer type, and nullptr is reserved to mean "nothing was taken".
+			 */
+			explicit WorkStealingDeque(int64_t initialCapacity = 1024)
+				: m_top(0)
+				, m_bottom(0)
+				, m_array(new Array(roundToPowerOfTwo(initialCapacity))) {
+				m_arrays.emplace_back(m_array.load(std::memory_order_relaxed));
+			}
+			~WorkStealingDeque() {}
+
+			WorkStealingDeque(const WorkStealingDeque&) = delete;
+			WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+			// Owner only. Grows the backing array if it is full.
+			void push(T item) {
+				int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+				int64_t top = m_top.load(std::memory_order_acquire);
+				Array* array = m_array.load(std::memory_order_relaxed);
+				if (bottom - top > array->capacity - 1) {
+					array = grow(array, top, bottom);
+				}
+				array->put(bottom, item);
+				std::atomic_thread_fence(std::memory_order_release);
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			// Owner only. Takes the most recently pushed item.
+			T pop() {
+				int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+				Array* array = m_array.load(std::memory_order_relaxed);
+				m_bottom.store(bottom, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t top = m_top.load(std::memory_order_relaxed);
+
+				T item = nullptr;
+				if (top <= bottom) {
+					item = array->get(bottom);
+					if (top == bottom) {
+						// Last item, race against thieves for it
+						if (!m_top.compare_exchange_strong(top, top + 1,
+								std::memory_order_seq_cst, std::memory_order_relaxed)) {
+							item = nullptr;
+						}
+						m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					}
+				} else {
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				}
+				return item;
+			}
+
+			// Any thread. Takes the oldest item, or returns nullptr if empty or if another thread won the race.
+			T steal() {
+				int64_t top = m_top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+				if (top < bottom) {
+					Array* array = m_array.load(std::memory_order_acquire);
+					T item = array->get(top);
+					if (!m_top.compare_exchange_strong(top, top + 1,
+							std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						return nullptr;
+					}
+					return item;
+				}
+				return nullptr;
+			}
+
+			// A racy snapshot, only suitable as a hint.
+			bool empty() const {
+				int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+				int64_t top = m_top.load(std::memory_order_relaxed);
+				return bottom <= top;
+			}
+
+		private:
+			struct Array {
+				int64_t capacity;
+				int64_t mask;
+				std::unique_ptr<std::atomic<T>[]> buffer;
+
+				explicit Array(int64_t capacity)
+					: capacity(capacity)
+					, mask(capacity - 1)
+					, buffer(new std::atomic<T>[capacity]) {}
+
+				T get(int64_t index) const { return buffer[index & mask].load(std::memory_order_relaxed); }
+				void put(int64_t index, T item) { buffer[index & mask].store(item, std::memory_order_relaxed); }
+			};
+
+			Array* grow(Array* old, int64_t top, int64_t bottom) {
+				Array* array = new Array(old->capacity * 2);
+				for (int64_t i = top; i < bottom; i++) {
+					array->put(i, old->get(i));
+				}
+				// Thieves may still be reading the old array, so it is kept alive until the deque dies.
+				// The deque only ever doubles, so this wastes at most the size of the current array.
+				m_arrays.emplace_back(array);
+				m_array.store(array, std::memory_order_release);
+				return array;
+			}
+
+			static int64_t roundToPowerOfTwo(int64_t value) {
+				int64_t result = 2;
+				while (result < value) {
+					result <<= 1;
+				}
+				return result;
+			}
+
+			// top and bottom are written by different threads, so keep them off each other's cache line.
+			alignas(64) std::atomic<int64_t> m_top;
+			alignas(64) std::atomic<int64_t> m_bottom;
+			alignas(64) std::atomic<Array*> m_array;
+
+			// Owner only. Every array that has been used, for deferred reclamation.
+			std::vector<std::unique_ptr<Array>> m_arrays;
+		};
+	}
+}
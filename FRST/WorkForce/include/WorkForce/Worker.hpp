@@ -1 +1,94 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include "WorkForce/LinearArena.hpp"
+#include "WorkForce/Priority.hpp"
+#include "WorkForce/WorkItem.hpp"
+#include "WorkForce/WorkStealingDeque.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		class WorkerPool;
+
+		class Worker {
+		public:
+			/*
+			 * A single thread owned by a WorkerPool.
+			 * Each worker runs Critical work first, its own or stolen, then work from its own deque, then from the
+			 * pool's shared queue, then steals from the other workers, and finally runs Background work.
+			 * When there is nothing to do it parks in the pool instead of spinning.
+			 */
+			Worker(WorkerPool& pool, size_t index);
+			~Worker();
+
+			Worker(const Worker&) = delete;
+			Worker& operator=(const Worker&) = delete;
+
+			void start();
+			void join();
+
+			// Owner thread only. Queue Critical or Normal work that this worker (or a thief) will run.
+			void push(WorkItem* item, Priority priority = Priority::Normal);
+			// Owner thread only.
+			WorkItem* pop();
+			// Any thread.
+			WorkItem* steal();
+			WorkItem* stealCritical();
+
+			// A racy hint of whether anything is sitting in this worker's (Normal) deque.
+			bool hasQueuedWork() const;
+
+			/*
+			 * Owner thread only. Run other queued work (our own first, then stolen) until done is set.
+			 * This is how a job waits on work it has forked without tying up the worker.
+			 */
+			void runUntil(const std::atomic<bool>& done);
+
+			/*
+			 * The arena that jobs running on this worker allocate from in the given frame.
+			 * Owner thread only, except that the pool resets it once every job of the frame has finished.
+			 */
+			LinearArena& frameArena(uint64_t frame) { return m_frameArenas[frame % m_framesInFlight]; }
+
+			size_t index() const { return m_index; }
+			WorkerPool& pool() { return m_pool; }
+
+			// The Worker running on the calling thread, or nullptr if this is not a worker thread.
+			static Worker* current();
+
+		private:
+			friend class WorkerPool;
+
+			void run();
+			WorkItem* findWork();
+			WorkItem* stealFromOthers(bool critical);
+
+			WorkerPool& m_pool;
+			const size_t m_index;
+			std::thread m_thread;
+			WorkStealingDeque<WorkItem*> m_deque;
+			WorkStealingDeque<WorkItem*> m_criticalDeque;
+
+			// One arena per frame in flight
+			const size_t m_framesInFlight;
+			std::unique_ptr<LinearArena[]> m_frameArenas;
+
+			// State for picking steal victims. Only touched by the owning thread.
+			uint32_t m_random;
+
+			// Set by the pool before the thread starts when workers are pinned.
+			// The logical CPU to run on, or -1 to let the OS decide.
+			int64_t m_cpu;
+			// The other workers from nearest to furthest, and where each group of equally distant workers ends.
+			// Empty to pick victims at random.
+			std::vector<size_t> m_victims;
+			std::vector<size_t> m_victimTierEnds;
+		};
+	}
+}
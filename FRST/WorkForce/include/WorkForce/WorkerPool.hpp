@@ -1,28 +1,228 @@
 #pragma once
 
+#include "WorkForce/CpuTopology.hpp"
+#include "WorkForce/FrameListener.hpp"
 #include "WorkForce/JobDependencyTracker.hpp"
+#include "WorkForce/JobGraph.hpp"
 #include "WorkForce/Job.hpp"
-#include <map>
+#include "WorkForce/Priority.hpp"
+#include "WorkForce/ResultSlot.hpp"
+#include "WorkForce/ResumeItem.hpp"
+#include "WorkForce/Worker.hpp"
+#include "WorkForce/WorkItem.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace FRST {
 	namespace WorkForce {
+		struct WorkerPoolConfig {
+			// The number of threads to start. 0 means one per logical CPU left after reservedCores and useSMT.
+			size_t numWorkers = 0;
+
+			// How many frames may be running at once.
+			// 1 is a full barrier between frames, 2 or 3 let the next frame start while the last one drains.
+			size_t framesInFlight = 2;
+
+			// Worker time, summed over all workers, that Background work submitted outside the job graph may use
+			// per frame. Zero means no limit.
+			std::chrono::microseconds backgroundBudget = std::chrono::microseconds::zero();
+
+			// Write a Chrome trace to tracePath once this many frames have finished. Zero means never.
+			// Needs tracing to be compiled in, see Trace.
+			uint64_t traceFrames = 0;
+			std::string tracePath = "trace.json";
+
+			// Pin each worker to its own logical CPU, and the thread that creates the pool (normally the main/SDL thread)
+			// to the first reserved core. Workers then steal from workers sharing their core or L3 cache first.
+			bool pinThreads = true;
+			// Let workers use every SMT thread of a core, instead of one worker per physical core.
+			bool useSMT = true;
+			// Physical cores kept free of workers, for the main thread and the OS. Ignored if that leaves no cores.
+			size_t reservedCores = 1;
+		};
+
 		class WorkerPool {
 		public:
-			WorkerPool();
+			/*
+			 * The WorkerPool owns one Worker thread per available logical CPU (see WorkerPoolConfig and CpuTopology)
+			 * and runs every registered Job once per frame.
+			 * Jobs are queued as soon as everything they consume has been produced, so independent jobs run in parallel.
+			 *
+			 * Frames are pipelined: frame N + 1 may start while jobs of frame N are still running, as long as
+			 * no more than framesInFlight frames are unfinished. See JobDependencyTracker for the exact ordering.
+			 */
+			explicit WorkerPool(const WorkerPoolConfig& config = WorkerPoolConfig());
 			~WorkerPool();
 
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool& operator=(const WorkerPool&) = delete;
+
+			/*
+			 * Register a job to be run every frame. The job is not owned by the pool and must outlive it.
+			 * Must only be called from the thread that starts frames. The job graph is recompiled before the next frame,
+			 * which waits for every frame in flight to finish.
+			 */
+			void addJob(Job* job);
+
+			/*
+			 * Have a listener told about every frame from the next one on. It is not owned by the pool.
+			 * Both must only be called from the thread that starts frames.
+			 */
+			void addFrameListener(FrameListener* listener);
+			void removeFrameListener(FrameListener* listener);
+
+			/*
+			 * Start the next frame and return its number without waiting for it to finish.
+			 * Blocks while framesInFlight frames are already unfinished.
+			 * Throws std::logic_error if newly added jobs do not form a valid graph (see JobGraph::compile()).
+			 *
+			 * Frames must only be started from one thread.
+			 */
+			uint64_t beginFrame();
+
+			/*
+			 * Block until every job of the frame has finished.
+			 * Results produced during the frame are reclaimed before this returns.
+			 */
+			void waitForFrame(uint64_t frame);
+
+			// Block until every frame that has been started is finished.
+			void waitForIdle();
+
+			// Start a frame and wait for it, as if there were only one frame in flight.
+			void runFrame();
+
+			/*
+			 * Queue a piece of work to be run on any worker.
+			 * Safe to call from any thread. From a worker thread the work goes onto that worker's own deque,
+			 * except for Background work, which is kept in one queue for the whole pool.
+			 */
+			void submit(WorkItem* item, Priority priority = Priority::Normal);
+
+			/*
+			 * Block a thread that is not one of this pool's workers until done is set.
+			 * Whoever sets done must call notifyExternalWaiters() afterwards.
+			 */
+			void waitExternally(const std::atomic<bool>& done);
+			void notifyExternalWaiters();
 
+			/*
+			 * Queue a suspended coroutine to be resumed once the given frame has begun. See nextFrame().
+			 * Returns false, without queueing it, if the frame has already begun.
+			 */
+			bool resumeAtFrame(ResumeItem* item, uint64_t frame);
+			// The frame that the next call to beginFrame() will start
+			uint64_t nextFrame();
+
+			size_t numWorkers() const { return m_workers.size(); }
+			Worker& worker(size_t index) { return *m_workers[index]; }
+			size_t framesInFlight() const { return m_config.framesInFlight; }
+			const CpuTopology& topology() const { return m_topology; }
+			bool isStopping() const { return m_stopping.load(std::memory_order_relaxed); }
 
 		private:
-			// A map of each consumable string registered to every job that consumes it.
-			std::map<std::string, std::vector<JobDependencyTracker*>> m_consumableMap;
-			// A list of jobs that consume nothing
-			std::vector<Job*> m_ // TODO: How to best track once the next frame can begin to run?
+			friend class Worker;
+			friend class JobDependencyTracker;
+
+			// Book keeping for one in-flight frame
+			struct FrameContext {
+				std::atomic<size_t> jobsRemaining;
+				// Guarded by m_frameMutex. One past the last frame that finished using this context.
+				uint64_t retiredThrough;
+				// One slot per ResultID
+				std::unique_ptr<ResultSlot[]> results;
+#ifdef FRST_TRACE_ENABLED
+				// When beginFrame() started it, for tracing
+				uint64_t beginTime;
+#endif
+			};
+
+			FrameContext& frameContext(uint64_t frame) { return m_frames[frame % m_config.framesInFlight]; }
+			ResultSlot* frameResults(uint64_t frame) { return frameContext(frame).results.get(); }
+
+			// Queue a job for a frame with the job's priority
+			void submitJob(JobDependencyTracker* tracker, uint64_t frame);
+			// Called by a tracker once its job has run and released its successors.
+			void finishJob(uint64_t frame);
+			// Pin workers to m_workerCpus and give them steal orders by distance
+			void placeWorkers();
+			// Called once every job of a frame has finished.
+			void retireFrame(uint64_t frame);
+			bool isRetired(uint64_t frame);
+
+			// Take work that was submitted from outside the pool.
+			WorkItem* takeSubmitted();
+			// Run one piece of Background work, if there is any and the budget allows. Returns whether it did.
+			bool runBackground(Worker& worker);
+			bool hasBackgroundWork() const;
+			// A racy check for whether any work is queued anywhere in the pool.
+			bool hasQueuedWork() const;
+
+			// Block the calling worker until more work is submitted or the pool is stopping.
+			void park();
+			// Wake one parked worker, if any, after new work was made available.
+			void notifyWorker();
+
+			const CpuTopology m_topology;
+			// The CPUs workers may run on, in the order they are handed out, and the CPUs set aside
+			const std::vector<LogicalCpu> m_workerCpus;
+			const std::vector<LogicalCpu> m_reservedCpus;
+			const WorkerPoolConfig m_config;
+
+			std::vector<std::unique_ptr<Worker>> m_workers;
+			std::atomic<bool> m_stopping;
+
+			// Work submitted from threads that are not workers (eg. the main thread)
+			mutable std::mutex m_submittedMutex;
+			std::deque<WorkItem*> m_submitted;
+			std::atomic<size_t> m_numSubmitted;
+
+			// A racy count of the items in every worker's critical deque, so workers only look for them when it is worthwhile.
+			std::atomic<size_t> m_numCritical;
+
+			// Background work. Jobs from the graph are kept apart, as they are not limited by the budget.
+			mutable std::mutex m_backgroundMutex;
+			std::deque<WorkItem*> m_backgroundJobs;
+			std::deque<WorkItem*> m_background;
+			std::atomic<size_t> m_numBackgroundJobs;
+			std::atomic<size_t> m_numBackground;
+			// What is left of this frame's background budget, in nanoseconds
+			std::atomic<int64_t> m_backgroundBudget;
+
+			// Parking for idle workers
+			std::mutex m_parkMutex;
+			std::condition_variable m_parkCondition;
+			std::atomic<size_t> m_numParked;
+			// Guarded by m_parkMutex. Wakeups that have been handed out but not yet consumed.
+			size_t m_pendingWakeups;
+
+			// Threads outside the pool waiting on work inside it
+			std::mutex m_externalMutex;
+			std::condition_variable m_externalCondition;
+
+			// Coroutines waiting for the next beginFrame(), chained through ResumeItem::next
+			std::mutex m_frameWaitersMutex;
+			ResumeItem* m_frameWaiters;
+			// Guarded by m_frameWaitersMutex, a copy of m_nextFrame for other threads
+			uint64_t m_framesBegun;
 
+			// Every registered job, compiled into trackers before the first frame that needs them.
+			JobGraph m_graph;
+			// Only touched by the thread starting frames
+			std::vector<FrameListener*> m_frameListeners;
 
-			std::vector<Job*> m_jobs;
+			// Frame tracking. Only the thread starting frames touches m_nextFrame.
+			std::unique_ptr<FrameContext[]> m_frames;
+			uint64_t m_nextFrame;
+			std::mutex m_frameMutex;
+			std::condition_variable m_frameCondition;
 		};
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,44 @@
+#include "WorkForce/AsyncEvent.hpp"
+
+#include "WorkForce/WorkerPool.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		AsyncEvent::AsyncEvent(WorkerPool& pool)
+			: m_pool(pool)
+			, m_state(nullptr) {}
+
+		void AsyncEvent::set() {
+			void* state = m_state.exchange(this, std::memory_order_acq_rel);
+			if (state == this) {
+				return;
+			}
+
+			ResumeItem* waiter = static_cast<ResumeItem*>(state);
+			while (waiter) {
+				// The waiter may run and be gone as soon as it is submitted
+				ResumeItem* next = waiter->next;
+				m_pool.submit(waiter);
+				waiter = next;
+			}
+		}
+
+		bool AsyncEvent::isSet() const {
+			return m_state.load(std::memory_order_acquire) == this;
+		}
+
+		bool AsyncEvent::Awaiter::await_suspend(std::coroutine_handle<> handle) noexcept {
+			m_resume.handle = handle;
+			void* state = m_event.m_state.load(std::memory_order_acquire);
+			do {
+				if (state == &m_event) {
+					// Set while we were suspending, carry on without queueing
+					return false;
+				}
+				m_resume.next = static_cast<ResumeItem*>(state);
+			} while (!m_event.m_state.compare_exchange_weak(state, &m_resume,
+				std::memory_order_release, std::memory_order_acquire));
+			return true;
+		}
+	}
+}
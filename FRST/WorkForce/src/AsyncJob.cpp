@@ -0,0 +1,16 @@
+#include "WorkForce/AsyncJob.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		// Owns a copy of the context for as long as the job is running
+		static Task<void> runAsyncJob(AsyncJob& job, JobContext context, JobCompletion completion) {
+			co_await job.executeAsync(context);
+			completion.complete();
+		}
+
+		void AsyncJob::execute(JobContext& context) {
+			JobCompletion completion = context.defer();
+			runDetached(runAsyncJob(*this, context, completion));
+		}
+	}
+}
@@ -0,0 +1,199 @@
+#include "WorkForce/CpuTopology.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace FRST {
+	namespace WorkForce {
+		// Parse a kernel cpu list such as "0-3,8,10-11"
+		static std::vector<uint32_t> parseCpuList(const std::string& list) {
+			std::vector<uint32_t> cpus;
+			size_t position = 0;
+			while (position < list.size()) {
+				size_t end = list.find(',', position);
+				if (end == std::string::npos) {
+					end = list.size();
+				}
+				std::string range = list.substr(position, end - position);
+				size_t dash = range.find('-');
+				try {
+					if (dash == std::string::npos) {
+						cpus.push_back(static_cast<uint32_t>(std::stoul(range)));
+					} else {
+						uint32_t first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+						uint32_t last = static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+						for (uint32_t cpu = first; cpu <= last; cpu++) {
+							cpus.push_back(cpu);
+						}
+					}
+				} catch (const std::exception&) {
+					// Blank or malformed, eg. a trailing newline
+				}
+				position = end + 1;
+			}
+			return cpus;
+		}
+
+		static bool readLine(const std::filesystem::path& path, std::string& line) {
+			std::ifstream file(path);
+			return file && std::getline(file, line);
+		}
+
+		// The lowest cpu of a list, used as a key shared by every cpu in it
+		static uint32_t listKey(const std::filesystem::path& path, uint32_t fallback) {
+			std::string line;
+			if (!readLine(path, line)) {
+				return fallback;
+			}
+			std::vector<uint32_t> cpus = parseCpuList(line);
+			return cpus.empty() ? fallback : *std::min_element(cpus.begin(), cpus.end());
+		}
+
+		CpuTopology::CpuTopology()
+			: m_cpus()
+			, m_numCores(0)
+			, m_numL3Domains(0)
+			, m_numNumaNodes(0) {}
+
+		// The CPUs this process may run on, eg. under taskset, a cgroup cpuset or a container. Empty if unknown.
+		static std::vector<uint32_t> allowedCpus() {
+			std::vector<uint32_t> cpus;
+#ifdef __linux__
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+				for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+					if (CPU_ISSET(cpu, &set)) {
+						cpus.push_back(cpu);
+					}
+				}
+			}
+#endif
+			return cpus;
+		}
+
+		CpuTopology CpuTopology::detect() {
+			return detect("/sys/devices/system/cpu", allowedCpus());
+		}
+
+		CpuTopology CpuTopology::detect(const std::string& root) {
+			return detect(root, {});
+		}
+
+		CpuTopology CpuTopology::detect(const std::string& root, const std::vector<uint32_t>& allowed) {
+			namespace fs = std::filesystem;
+
+			std::vector<uint32_t> online;
+			std::string line;
+			if (readLine(fs::path(root) / "online", line)) {
+				online = parseCpuList(line);
+			}
+			if (!allowed.empty()) {
+				std::vector<uint32_t> usable;
+				for (uint32_t cpu : online.empty() ? allowed : online) {
+					if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+						usable.push_back(cpu);
+					}
+				}
+				online = std::move(usable);
+			}
+			if (online.empty()) {
+				uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+				for (uint32_t cpu = 0; cpu < count; cpu++) {
+					online.push_back(cpu);
+				}
+			}
+
+			// Raw keys first, then made dense
+			struct RawCpu {
+				uint32_t id;
+				uint32_t coreKey;
+				uint32_t l3Key;
+				uint32_t numaKey;
+			};
+			std::vector<RawCpu> raw;
+			for (uint32_t id : online) {
+				fs::path cpuPath = fs::path(root) / ("cpu" + std::to_string(id));
+				RawCpu cpu = { id, id, id, 0 };
+				cpu.coreKey = listKey(cpuPath / "topology" / "thread_siblings_list", id);
+
+				// Without an L3 (or without cache info) a core is its own domain
+				cpu.l3Key = cpu.coreKey;
+				std::error_code error;
+				for (const auto& entry : fs::directory_iterator(cpuPath / "cache", error)) {
+					std::string level;
+					if (entry.path().filename().string().rfind("index", 0) == 0 && readLine(entry.path() / "level", level) && level == "3") {
+						cpu.l3Key = listKey(entry.path() / "shared_cpu_list", cpu.coreKey);
+					}
+				}
+				for (const auto& entry : fs::directory_iterator(cpuPath, error)) {
+					std::string name = entry.path().filename().string();
+					if (name.size() > 4 && name.rfind("node", 0) == 0 && std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+						cpu.numaKey = static_cast<uint32_t>(std::stoul(name.substr(4)));
+					}
+				}
+				raw.push_back(cpu);
+			}
+
+			// Keep cores together, in the order of their first cpu
+			std::stable_sort(raw.begin(), raw.end(), [](const RawCpu& a, const RawCpu& b) {
+				return a.coreKey != b.coreKey ? a.coreKey < b.coreKey : a.id < b.id;
+			});
+
+			CpuTopology topology;
+			std::map<uint32_t, uint32_t> cores;
+			std::map<uint32_t, uint32_t> l3Domains;
+			std::map<uint32_t, uint32_t> numaNodes;
+			std::map<uint32_t, uint32_t> threadsPerCore;
+			for (const RawCpu& cpu : raw) {
+				LogicalCpu logical;
+				logical.id = cpu.id;
+				logical.core = cores.emplace(cpu.coreKey, static_cast<uint32_t>(cores.size())).first->second;
+				logical.l3Domain = l3Domains.emplace(cpu.l3Key, static_cast<uint32_t>(l3Domains.size())).first->second;
+				logical.numaNode = numaNodes.emplace(cpu.numaKey, static_cast<uint32_t>(numaNodes.size())).first->second;
+				logical.smtIndex = threadsPerCore[cpu.coreKey]++;
+				topology.m_cpus.push_back(logical);
+			}
+			topology.m_numCores = cores.size();
+			topology.m_numL3Domains = l3Domains.size();
+			topology.m_numNumaNodes = numaNodes.size();
+			return topology;
+		}
+
+		uint32_t CpuTopology::distance(const LogicalCpu& a, const LogicalCpu& b) {
+			if (a.core == b.core) {
+				return 0;
+			}
+			if (a.l3Domain == b.l3Domain) {
+				return 1;
+			}
+			if (a.numaNode == b.numaNode) {
+				return 2;
+			}
+			return 3;
+		}
+
+		bool CpuTopology::pinCurrentThread(uint32_t cpu) {
+#ifdef __linux__
+			if (cpu >= CPU_SETSIZE) {
+				return false;
+			}
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+			(void)cpu;
+			return false;
+#endif
+		}
+	}
+}
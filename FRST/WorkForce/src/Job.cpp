@@ -1,2 +1,21 @@
 #include "WorkForce/Job.hpp"
 
+namespace FRST {
+	namespace WorkForce {
+		Job::Job()
+			: m_inputs()
+			, m_outputs() {
+		}
+
+		Job::~Job() {
+		}
+
+		void Job::registerPort(PortBase* port) {
+			if (port->isOutput()) {
+				m_outputs.push_back(port);
+			} else {
+				m_inputs.push_back(port);
+			}
+		}
+	}
+}
@@ -1 +1,153 @@
-#include "WorkForce/JobDependencyTracker.hpp"
\ No newline at end of file
+#include "WorkForce/JobDependencyTracker.hpp"
+
+#include "WorkForce/Trace.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace FRST {
+	namespace WorkForce {
+		JobDependencyTracker::JobDependencyTracker(Job* job, WorkerPool& pool, size_t framesInFlight)
+			: m_job(job)
+			, m_pool(pool)
+			, m_framesInFlight(framesInFlight)
+			, m_hasCrossFrameHazard(job->hasCrossFrameHazard())
+			, m_priority(job->priority())
+			// Until a job has been measured, rank it by the length of its chain
+			, m_cost(1)
+			, m_rank(1)
+			, m_producerCount(0)
+			, m_firstFrame(0)
+			, m_instances(new FrameInstance[framesInFlight])
+			, m_outputIDs()
+			, m_successors() {
+			for (size_t i = 0; i < m_framesInFlight; i++) {
+				FrameInstance& frameInstance = m_instances[i];
+				frameInstance.execute = &JobDependencyTracker::executeJob;
+				frameInstance.tracker = this;
+				frameInstance.frame = 0;
+				frameInstance.remainingDependencies.store(0, std::memory_order_relaxed);
+#ifdef FRST_TRACE_ENABLED
+				frameInstance.readyTime = 0;
+#endif
+			}
+		}
+
+		JobDependencyTracker::~JobDependencyTracker() {
+		}
+
+		void JobDependencyTracker::arm(uint64_t firstFrame) {
+			m_firstFrame = firstFrame;
+			for (uint64_t frame = firstFrame; frame < firstFrame + m_framesInFlight; frame++) {
+				FrameInstance& frameInstance = instance(frame);
+				frameInstance.frame = frame;
+				frameInstance.remainingDependencies.store(dependencyCount(frame), std::memory_order_relaxed);
+			}
+		}
+
+		uint32_t JobDependencyTracker::dependencyCount(uint64_t frame) const {
+			uint32_t count = m_producerCount;
+			if (m_producerCount == 0) {
+				// Jobs with producers are held back by them, everything else waits for the frame to start
+				count++;
+			}
+			if (frame > m_firstFrame) {
+				count++;
+				if (m_hasCrossFrameHazard) {
+					count++;
+				}
+			}
+			return count;
+		}
+
+		bool JobDependencyTracker::resolveDependency(uint64_t frame) {
+			// acq_rel so the last producer sees every other producer's writes to our input slots
+			FrameInstance& frameInstance = instance(frame);
+			if (frameInstance.remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+				return false;
+			}
+#ifdef FRST_TRACE_ENABLED
+			frameInstance.readyTime = Trace::now();
+#endif
+			return true;
+		}
+
+		void JobDependencyTracker::executeJob(WorkItem* item, Worker&) {
+			FrameInstance& frameInstance = *static_cast<FrameInstance*>(item);
+			JobDependencyTracker& tracker = *frameInstance.tracker;
+			uint64_t frame = frameInstance.frame;
+
+			// Nothing else can reach this instance's countdown until this job finishes, so rearm it now
+			// for the next frame that uses it.
+			frameInstance.frame = frame + tracker.m_framesInFlight;
+			frameInstance.remainingDependencies.store(
+				tracker.dependencyCount(frameInstance.frame), std::memory_order_relaxed);
+
+			JobContext context(tracker.m_pool.frameResults(frame), &tracker, frame);
+			auto start = std::chrono::steady_clock::now();
+			tracker.m_job->execute(context);
+			auto end = std::chrono::steady_clock::now();
+			tracker.measure(end - start);
+
+#ifdef FRST_TRACE_ENABLED
+			uint64_t traceStart = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count());
+			uint64_t traceEnd = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count());
+			uint64_t frameStart = tracker.m_pool.frameContext(frame).beginTime;
+			uint64_t readyTime = std::max(frameInstance.readyTime, frameStart);
+			Trace::record(TraceEvent{ tracker.m_job->name(), TraceEvent::Kind::Job, traceStart, traceEnd, frame,
+				readyTime - frameStart, traceStart > readyTime ? traceStart - readyTime : 0, 0 });
+#endif
+			if (!context.isDeferred()) {
+				tracker.completeJob(frame);
+			}
+		}
+
+		void JobDependencyTracker::completeJob(uint64_t frame) {
+#ifdef _DEBUG
+			ResultSlot* results = m_pool.frameResults(frame);
+			for (ResultID output : m_outputIDs) {
+				assert(results[output].frame == frame && "Job::execute() must fill every Output");
+			}
+#endif
+
+			// The highest ranked successor is queued last, so that this worker pops it next and stays on the critical path
+			JobDependencyTracker* next = nullptr;
+			for (JobDependencyTracker* successor : m_successors) {
+				if (successor->resolveDependency(frame)) {
+					if (!next) {
+						next = successor;
+					} else if (successor->rank() > next->rank()) {
+						m_pool.submitJob(next, frame);
+						next = successor;
+					} else {
+						m_pool.submitJob(successor, frame);
+					}
+				}
+			}
+
+			// Let the next frame of this job go
+			if (resolveDependency(frame + 1)) {
+				m_pool.submitJob(this, frame + 1);
+			}
+
+			if (next) {
+				m_pool.submitJob(next, frame);
+			}
+
+			m_pool.finishJob(frame);
+		}
+
+		void JobDependencyTracker::measure(std::chrono::steady_clock::duration duration) {
+			uint64_t sample = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+			// Exponential moving average over roughly the last 8 frames
+			uint64_t cost = m_cost.load(std::memory_order_relaxed);
+			m_cost.store(cost - cost / 8 + sample / 8 + 1, std::memory_order_relaxed);
+		}
+
+		void JobCompletion::complete() {
+			m_tracker->completeJob(m_frame);
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#include "WorkForce/JobGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace FRST {
+	namespace WorkForce {
+		// Marks a result that no registered job produces
+		static const size_t NO_PRODUCER = static_cast<size_t>(-1);
+
+		JobGraph::JobGraph()
+			: m_jobs()
+			, m_resultIDs()
+			, m_resultTypes()
+			, m_dirty(false)
+			, m_trackers()
+			, m_roots()
+			, m_hazards() {
+		}
+
+		JobGraph::~JobGraph() {
+		}
+
+		void JobGraph::addJob(Job* job) {
+			m_jobs.push_back(job);
+			m_dirty = true;
+		}
+
+		ResultID JobGraph::internResult(const PortBase& port) {
+			auto it = m_resultIDs.find(port.name());
+			if (it != m_resultIDs.end()) {
+				if (m_resultTypes[it->second] != port.type()) {
+					throw std::logic_error("JobGraph: ports named \"" + port.name() + "\" have different types");
+				}
+				return it->second;
+			}
+			ResultID id = static_cast<ResultID>(m_resultIDs.size());
+			m_resultIDs.emplace(port.name(), id);
+			m_resultTypes.push_back(port.type());
+			return id;
+		}
+
+		void JobGraph::compile(WorkerPool& pool, size_t framesInFlight) {
+			m_trackers.clear();
+			m_roots.clear();
+			m_hazards.clear();
+			m_resultIDs.clear();
+			m_resultTypes.clear();
+
+			size_t numJobs = m_jobs.size();
+
+			// Intern every name once, and point each port at its slot. From here on only ids are used.
+			std::vector<std::vector<ResultID>> produces(numJobs);
+			std::vector<std::vector<ResultID>> consumes(numJobs);
+			for (size_t job = 0; job < numJobs; job++) {
+				for (PortBase* port : m_jobs[job]->outputs()) {
+					port->m_resultID = internResult(*port);
+					produces[job].push_back(port->m_resultID);
+				}
+				for (PortBase* port : m_jobs[job]->inputs()) {
+					port->m_resultID = internResult(*port);
+					consumes[job].push_back(port->m_resultID);
+				}
+			}
+
+			std::vector<size_t> producerOf(m_resultIDs.size(), NO_PRODUCER);
+			for (size_t job = 0; job < numJobs; job++) {
+				for (ResultID result : produces[job]) {
+					if (producerOf[result] != NO_PRODUCER) {
+						throw std::logic_error("JobGraph: more than one job produces the same result");
+					}
+					producerOf[result] = job;
+				}
+			}
+
+			// The distinct producer jobs of each job
+			std::vector<std::vector<size_t>> predecessors(numJobs);
+			std::vector<bool> unsatisfiable(numJobs, false);
+			for (size_t job = 0; job < numJobs; job++) {
+				for (ResultID result : consumes[job]) {
+					size_t producer = producerOf[result];
+					if (producer == NO_PRODUCER) {
+						unsatisfiable[job] = true;
+					} else if (std::find(predecessors[job].begin(), predecessors[job].end(), producer) == predecessors[job].end()) {
+						predecessors[job].push_back(producer);
+					}
+				}
+			}
+
+			std::vector<std::vector<size_t>> successors(numJobs);
+			for (size_t job = 0; job < numJobs; job++) {
+				for (size_t producer : predecessors[job]) {
+					successors[producer].push_back(job);
+				}
+			}
+
+			// Kahn's algorithm. Unsatisfiable jobs are still visited so they can poison their successors.
+			std::vector<size_t> inDegree(numJobs);
+			std::vector<size_t> ready;
+			for (size_t job = 0; job < numJobs; job++) {
+				inDegree[job] = predecessors[job].size();
+				if (inDegree[job] == 0) {
+					ready.push_back(job);
+				}
+			}
+
+			std::vector<size_t> order;
+			order.reserve(numJobs);
+			for (size_t i = 0; i < ready.size(); i++) {
+				size_t job = ready[i];
+				order.push_back(job);
+				for (size_t successor : successors[job]) {
+					if (unsatisfiable[job]) {
+						unsatisfiable[successor] = true;
+					}
+					if (--inDegree[successor] == 0) {
+						ready.push_back(successor);
+					}
+				}
+			}
+			if (order.size() != numJobs) {
+				throw std::logic_error("JobGraph: the inputs and outputs of the jobs form a cycle");
+			}
+
+			// Build trackers in topological order
+			std::vector<JobDependencyTracker*> trackerOf(numJobs, nullptr);
+			for (size_t job : order) {
+				if (unsatisfiable[job]) {
+					continue;
+				}
+				m_trackers.emplace_back(new JobDependencyTracker(m_jobs[job], pool, framesInFlight));
+				JobDependencyTracker* tracker = m_trackers.back().get();
+				trackerOf[job] = tracker;
+				tracker->m_producerCount = static_cast<uint32_t>(predecessors[job].size());
+				if (predecessors[job].empty()) {
+					m_roots.push_back(tracker);
+				}
+				if (tracker->hasCrossFrameHazard()) {
+					m_hazards.push_back(tracker);
+				}
+			}
+
+			for (size_t job = 0; job < numJobs; job++) {
+				JobDependencyTracker* tracker = trackerOf[job];
+				if (!tracker) {
+					continue;
+				}
+
+				tracker->m_outputIDs = produces[job];
+				for (size_t successor : successors[job]) {
+					if (trackerOf[successor]) {
+						tracker->m_successors.push_back(trackerOf[successor]);
+					}
+				}
+			}
+
+			updateRanks();
+			m_dirty = false;
+		}
+
+		void JobGraph::updateRanks() {
+			// Successors always come later in topological order, so walk backwards
+			for (auto tracker = m_trackers.rbegin(); tracker != m_trackers.rend(); ++tracker) {
+				uint64_t longestSuccessor = 0;
+				for (JobDependencyTracker* successor : (*tracker)->m_successors) {
+					longestSuccessor = std::max(longestSuccessor, successor->rank());
+				}
+				(*tracker)->m_rank.store((*tracker)->cost() + longestSuccessor, std::memory_order_relaxed);
+			}
+
+			std::stable_sort(m_roots.begin(), m_roots.end(), [](JobDependencyTracker* a, JobDependencyTracker* b) {
+				return a->rank() > b->rank();
+			});
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#include "WorkForce/LinearArena.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		LinearArena::LinearArena(size_t chunkSize)
+			: m_chunkSize(chunkSize)
+			, m_chunks()
+			, m_chunkIndex(0)
+			, m_current(0)
+			, m_end(0)
+			, m_bytesInFullChunks(0)
+			, m_destructors(nullptr) {
+		}
+
+		LinearArena::~LinearArena() {
+			reset();
+		}
+
+		void LinearArena::reset() {
+			for (Destructor* destructor = m_destructors; destructor; destructor = destructor->next) {
+				destructor->destroy(destructor->object);
+			}
+			m_destructors = nullptr;
+
+			m_bytesInFullChunks = 0;
+			if (m_chunks.empty()) {
+				m_chunkIndex = 0;
+				m_current = 0;
+				m_end = 0;
+			} else {
+				useChunk(0);
+			}
+		}
+
+		size_t LinearArena::bytesUsed() const {
+			if (m_chunks.empty()) {
+				return 0;
+			}
+			uintptr_t start = reinterpret_cast<uintptr_t>(m_chunks[m_chunkIndex].memory.get());
+			return m_bytesInFullChunks + (m_current - start);
+		}
+
+		size_t LinearArena::bytesReserved() const {
+			size_t total = 0;
+			for (const Chunk& chunk : m_chunks) {
+				total += chunk.size;
+			}
+			return total;
+		}
+
+		void* LinearArena::allocateSlow(size_t size, size_t alignment) {
+			// Move on to the next chunk that is big enough, keeping any smaller ones for later resets
+			size_t next = m_chunks.empty() ? 0 : m_chunkIndex + 1;
+			if (!m_chunks.empty()) {
+				uintptr_t start = reinterpret_cast<uintptr_t>(m_chunks[m_chunkIndex].memory.get());
+				m_bytesInFullChunks += m_current - start;
+			}
+
+			size_t needed = size + alignment;
+			while (next < m_chunks.size() && m_chunks[next].size < needed) {
+				next++;
+			}
+			if (next == m_chunks.size()) {
+				size_t chunkSize = needed > m_chunkSize ? needed : m_chunkSize;
+				m_chunks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[chunkSize]), chunkSize });
+			}
+
+			useChunk(next);
+			return allocate(size, alignment);
+		}
+
+		void LinearArena::useChunk(size_t index) {
+			m_chunkIndex = index;
+			m_current = reinterpret_cast<uintptr_t>(m_chunks[index].memory.get());
+			m_end = m_current + m_chunks[index].size;
+		}
+	}
+}
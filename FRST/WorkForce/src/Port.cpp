@@ -0,0 +1,15 @@
+#include "WorkForce/Port.hpp"
+
+#include "WorkForce/Job.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		PortBase::PortBase(Job* job, std::string name, PortType type, bool isOutput)
+			: m_name(std::move(name))
+			, m_type(type)
+			, m_isOutput(isOutput)
+			, m_resultID(0) {
+			job->registerPort(this);
+		}
+	}
+}
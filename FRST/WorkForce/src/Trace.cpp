@@ -0,0 +1,225 @@
+#include "WorkForce/Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace FRST {
+	namespace WorkForce {
+		uint64_t Trace::now() {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+#ifdef FRST_TRACE_ENABLED
+		// One thread's events. Written only by that thread, read by whoever writes the trace.
+		class TraceBuffer {
+		public:
+			TraceBuffer(uint32_t id, const std::string& name)
+				: m_id(id)
+				, m_name(name)
+				, m_head(0)
+				, m_slots(new Slot[Trace::EVENTS_PER_THREAD]) {}
+
+			void record(const TraceEvent& event) {
+				uint64_t head = m_head.load(std::memory_order_relaxed);
+				Slot& slot = m_slots[head % Trace::EVENTS_PER_THREAD];
+				uint64_t words[WORDS] = {};
+				std::memcpy(words, &event, sizeof(event));
+
+				// A reader that sees any of the new words also sees the odd sequence, and drops the slot
+				slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				for (size_t i = 0; i < WORDS; i++) {
+					slot.words[i].store(words[i], std::memory_order_relaxed);
+				}
+				slot.sequence.store(2 * head + 2, std::memory_order_release);
+				m_head.store(head + 1, std::memory_order_release);
+			}
+
+			// Copy out every event that is complete and not overwritten while copying
+			void copy(std::vector<TraceEvent>& out) const {
+				uint64_t head = m_head.load(std::memory_order_acquire);
+				uint64_t first = head > Trace::EVENTS_PER_THREAD ? head - Trace::EVENTS_PER_THREAD : 0;
+				for (uint64_t index = first; index < head; index++) {
+					const Slot& slot = m_slots[index % Trace::EVENTS_PER_THREAD];
+					// The writer may have lapped us, or be halfway through this slot
+					uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+					if (sequence != 2 * index + 2) {
+						continue;
+					}
+					uint64_t words[WORDS];
+					for (size_t i = 0; i < WORDS; i++) {
+						words[i] = slot.words[i].load(std::memory_order_relaxed);
+					}
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+						continue;
+					}
+					TraceEvent event;
+					std::memcpy(&event, words, sizeof(event));
+					out.push_back(event);
+				}
+			}
+
+			uint32_t id() const { return m_id; }
+			std::string name() const {
+				std::lock_guard<std::mutex> lock(m_nameMutex);
+				return m_name;
+			}
+			void setName(const std::string& name) {
+				std::lock_guard<std::mutex> lock(m_nameMutex);
+				m_name = name;
+			}
+
+		private:
+			static_assert(std::is_trivially_copyable_v<TraceEvent>, "TraceEvents are copied through Slot words");
+			static constexpr size_t WORDS = (sizeof(TraceEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+			// One event, stored as atomic words so that it can be read while being overwritten.
+			// sequence is 2 * (index + 1) once the event with that index is complete, and odd while it is written.
+			struct Slot {
+				std::atomic<uint64_t> sequence{ 0 };
+				std::atomic<uint64_t> words[WORDS] = {};
+			};
+
+			const uint32_t m_id;
+			mutable std::mutex m_nameMutex;
+			std::string m_name;
+			std::atomic<uint64_t> m_head;
+			std::unique_ptr<Slot[]> m_slots;
+		};
+
+		// Every buffer ever created. Buffers outlive their threads, so a trace can include threads that have exited.
+		static std::mutex s_buffersMutex;
+		static std::vector<std::unique_ptr<TraceBuffer>> s_buffers;
+
+		static thread_local TraceBuffer* s_threadBuffer = nullptr;
+
+		static TraceBuffer& threadBuffer() {
+			if (!s_threadBuffer) {
+				std::lock_guard<std::mutex> lock(s_buffersMutex);
+				uint32_t id = static_cast<uint32_t>(s_buffers.size());
+				s_buffers.emplace_back(new TraceBuffer(id, "Thread " + std::to_string(id + 1)));
+				s_threadBuffer = s_buffers.back().get();
+			}
+			return *s_threadBuffer;
+		}
+
+		void Trace::record(const TraceEvent& event) {
+			threadBuffer().record(event);
+		}
+
+		void Trace::setThreadName(const std::string& name) {
+			threadBuffer().setName(name);
+		}
+
+		static void writeJsonString(std::ostream& out, const std::string& string) {
+			out << '"';
+			for (char c : string) {
+				if (c == '"' || c == '\\') {
+					out << '\\' << c;
+				} else if (static_cast<unsigned char>(c) < 0x20) {
+					out << ' ';
+				} else {
+					out << c;
+				}
+			}
+			out << '"';
+		}
+
+		static void writeMicroseconds(std::ostream& out, uint64_t nanoseconds) {
+			out << nanoseconds / 1000 << '.';
+			uint64_t fraction = nanoseconds % 1000;
+			out << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + fraction / 10 % 10)
+				<< static_cast<char>('0' + fraction % 10);
+		}
+
+		void Trace::writeChromeJson(std::ostream& out) {
+			struct Track {
+				uint32_t id;
+				std::string name;
+				std::vector<TraceEvent> events;
+			};
+			std::vector<Track> tracks;
+			{
+				std::lock_guard<std::mutex> lock(s_buffersMutex);
+				for (const auto& buffer : s_buffers) {
+					tracks.push_back(Track{ buffer->id(), buffer->name(), {} });
+					buffer->copy(tracks.back().events);
+				}
+			}
+
+			// Timestamps start at the first event, to keep the numbers readable.
+			// Frames get the first tracks, one per frame slot, as spans on one track have to nest.
+			uint64_t origin = UINT64_MAX;
+			uint32_t frameTracks = 1;
+			for (const Track& track : tracks) {
+				for (const TraceEvent& event : track.events) {
+					origin = std::min(origin, event.begin);
+					if (event.kind == TraceEvent::Kind::Frame) {
+						frameTracks = std::max(frameTracks, event.frameSlot + 1);
+					}
+				}
+			}
+
+			out << "{\"traceEvents\":[\n";
+			for (uint32_t slot = 0; slot < frameTracks; slot++) {
+				out << (slot == 0 ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << slot
+					<< ",\"args\":{\"name\":\"Frames " << slot << "\"}}";
+			}
+			for (const Track& track : tracks) {
+				out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << frameTracks + track.id << ",\"args\":{\"name\":";
+				writeJsonString(out, track.name);
+				out << "}}";
+
+				for (const TraceEvent& event : track.events) {
+					out << ",\n{\"name\":";
+					writeJsonString(out, event.name);
+					out << ",\"cat\":\"" << (event.kind == TraceEvent::Kind::Job ? "job" : event.kind == TraceEvent::Kind::Frame ? "frame" : "scope")
+						<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.kind == TraceEvent::Kind::Frame ? event.frameSlot : frameTracks + track.id) << ",\"ts\":";
+					writeMicroseconds(out, event.begin - origin);
+					out << ",\"dur\":";
+					writeMicroseconds(out, event.end - event.begin);
+					out << ",\"args\":{";
+					if (event.frame != NO_FRAME) {
+						out << "\"frame\":" << event.frame;
+					}
+					if (event.kind == TraceEvent::Kind::Job) {
+						out << (event.frame != NO_FRAME ? "," : "") << "\"worker\":";
+						writeJsonString(out, track.name);
+						out << ",\"dependency_wait_us\":";
+						writeMicroseconds(out, event.dependencyWait);
+						out << ",\"queue_wait_us\":";
+						writeMicroseconds(out, event.queueWait);
+					}
+					out << "}}";
+				}
+			}
+			out << "\n]}\n";
+		}
+#else
+		void Trace::record(const TraceEvent&) {}
+
+		void Trace::setThreadName(const std::string&) {}
+
+		void Trace::writeChromeJson(std::ostream& out) {
+			out << "{\"traceEvents\":[]}\n";
+		}
+#endif
+
+		bool Trace::writeChromeJson(const std::string& path) {
+			std::ofstream file(path);
+			if (!file) {
+				return false;
+			}
+			writeChromeJson(file);
+			return static_cast<bool>(file);
+		}
+	}
+}
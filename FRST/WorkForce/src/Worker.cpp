@@ -1 +1,189 @@
-#include "WorkForce/Worker.hpp"
\ No newline at end of file
+#include "WorkForce/Worker.hpp"
+
+#include "WorkForce/CpuTopology.hpp"
+#include "WorkForce/Trace.hpp"
+#include "WorkForce/WorkerPool.hpp"
+
+namespace FRST {
+	namespace WorkForce {
+		// How many rounds of stealing to attempt before parking the thread.
+		static const int SPIN_ROUNDS_BEFORE_PARKING = 64;
+
+		static thread_local Worker* s_currentWorker = nullptr;
+
+		Worker::Worker(WorkerPool& pool, size_t index)
+			: m_pool(pool)
+			, m_index(index)
+			, m_thread()
+			, m_deque()
+			, m_criticalDeque(64)
+			, m_framesInFlight(pool.framesInFlight())
+			, m_frameArenas(new LinearArena[pool.framesInFlight()])
+			, m_random(static_cast<uint32_t>(index) * 2654435761u + 1)
+			, m_cpu(-1)
+			, m_victims()
+			, m_victimTierEnds() {
+		}
+
+		Worker::~Worker() {
+		}
+
+		void Worker::start() {
+			m_thread = std::thread(&Worker::run, this);
+		}
+
+		void Worker::join() {
+			if (m_thread.joinable()) {
+				m_thread.join();
+			}
+		}
+
+		void Worker::push(WorkItem* item, Priority priority) {
+			if (priority == Priority::Critical) {
+				m_criticalDeque.push(item);
+				m_pool.m_numCritical.fetch_add(1, std::memory_order_relaxed);
+			} else {
+				m_deque.push(item);
+			}
+		}
+
+		WorkItem* Worker::pop() {
+			return m_deque.pop();
+		}
+
+		WorkItem* Worker::steal() {
+			return m_deque.steal();
+		}
+
+		WorkItem* Worker::stealCritical() {
+			WorkItem* item = m_criticalDeque.steal();
+			if (item) {
+				m_pool.m_numCritical.fetch_sub(1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		bool Worker::hasQueuedWork() const {
+			return !m_deque.empty();
+		}
+
+		void Worker::runUntil(const std::atomic<bool>& done) {
+			while (!done.load(std::memory_order_acquire)) {
+				WorkItem* item = findWork();
+				if (item) {
+					item->execute(item, *this);
+				} else {
+					// Whatever we are waiting on is running on another worker
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		Worker* Worker::current() {
+			return s_currentWorker;
+		}
+
+		void Worker::run() {
+			s_currentWorker = this;
+			Trace::setThreadName("Worker " + std::to_string(m_index));
+			if (m_cpu >= 0) {
+				CpuTopology::pinCurrentThread(static_cast<uint32_t>(m_cpu));
+			}
+
+			int idleRounds = 0;
+			while (!m_pool.isStopping()) {
+				WorkItem* item = findWork();
+				if (item) {
+					idleRounds = 0;
+					item->execute(item, *this);
+					continue;
+				}
+
+				if (m_pool.runBackground(*this)) {
+					idleRounds = 0;
+					continue;
+				}
+
+				if (idleRounds < SPIN_ROUNDS_BEFORE_PARKING) {
+					idleRounds++;
+					std::this_thread::yield();
+				} else {
+					idleRounds = 0;
+					m_pool.park();
+				}
+			}
+
+			s_currentWorker = nullptr;
+		}
+
+		WorkItem* Worker::findWork() {
+			WorkItem* item = m_criticalDeque.pop();
+			if (item) {
+				m_pool.m_numCritical.fetch_sub(1, std::memory_order_relaxed);
+				return item;
+			}
+			if (m_pool.m_numCritical.load(std::memory_order_relaxed) > 0) {
+				item = stealFromOthers(true);
+				if (item) {
+					return item;
+				}
+			}
+
+			item = pop();
+			if (item) {
+				return item;
+			}
+
+			item = m_pool.takeSubmitted();
+			if (item) {
+				return item;
+			}
+
+			return stealFromOthers(false);
+		}
+
+		WorkItem* Worker::stealFromOthers(bool critical) {
+			size_t numWorkers = m_pool.numWorkers();
+			if (numWorkers < 2) {
+				return nullptr;
+			}
+
+			// xorshift32, just to spread thieves over different victims
+			m_random ^= m_random << 13;
+			m_random ^= m_random >> 17;
+			m_random ^= m_random << 5;
+
+			if (!m_victims.empty()) {
+				// Nearest workers first, starting at a random victim within each group
+				size_t tierBegin = 0;
+				for (size_t tierEnd : m_victimTierEnds) {
+					size_t tierSize = tierEnd - tierBegin;
+					size_t start = m_random % tierSize;
+					for (size_t i = 0; i < tierSize; i++) {
+						Worker& other = m_pool.worker(m_victims[tierBegin + (start + i) % tierSize]);
+						WorkItem* item = critical ? other.stealCritical() : other.steal();
+						if (item) {
+							return item;
+						}
+					}
+					tierBegin = tierEnd;
+				}
+				return nullptr;
+			}
+
+			size_t start = m_random % numWorkers;
+			for (size_t i = 0; i < numWorkers; i++) {
+				size_t victim = (start + i) % numWorkers;
+				if (victim == m_index) {
+					continue;
+				}
+				Worker& other = m_pool.worker(victim);
+				WorkItem* item = critical ? other.stealCritical() : other.steal();
+				if (item) {
+					return item;
+				}
+			}
+			return nullptr;
+		}
+	}
+}
@@ -1 +1,462 @@
-#include "WorkForce/WorkerPool.hpp"
\ No newline at end of file
+#include "WorkForce/WorkerPool.hpp"
+
+#include "WorkForce/Trace.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <utility>
+
+namespace FRST {
+	namespace WorkForce {
+		// The first reservedCores cores are set aside, unless that would leave nothing for the workers
+		static size_t numReservedCores(const CpuTopology& topology, const WorkerPoolConfig& config) {
+			return config.reservedCores < topology.numCores() ? config.reservedCores : 0;
+		}
+
+		/*
+		 * The CPUs workers are placed on, in order.
+		 * The first SMT thread of every core comes before any second thread, so that a small pool uses separate cores.
+		 */
+		static std::vector<LogicalCpu> findWorkerCpus(const CpuTopology& topology, const WorkerPoolConfig& config) {
+			size_t reserved = numReservedCores(topology, config);
+			std::vector<LogicalCpu> cpus;
+			for (const LogicalCpu& cpu : topology.cpus()) {
+				if (cpu.core >= reserved && (config.useSMT || cpu.smtIndex == 0)) {
+					cpus.push_back(cpu);
+				}
+			}
+			std::stable_sort(cpus.begin(), cpus.end(), [](const LogicalCpu& a, const LogicalCpu& b) {
+				return a.smtIndex < b.smtIndex;
+			});
+			return cpus;
+		}
+
+		static std::vector<LogicalCpu> findReservedCpus(const CpuTopology& topology, const WorkerPoolConfig& config) {
+			size_t reserved = numReservedCores(topology, config);
+			std::vector<LogicalCpu> cpus;
+			for (const LogicalCpu& cpu : topology.cpus()) {
+				if (cpu.core < reserved) {
+					cpus.push_back(cpu);
+				}
+			}
+			return cpus;
+		}
+
+		// Fill in the defaults that depend on the machine
+		static WorkerPoolConfig resolveConfig(WorkerPoolConfig config, const std::vector<LogicalCpu>& workerCpus) {
+			if (config.numWorkers == 0) {
+				config.numWorkers = workerCpus.size();
+			}
+			if (config.numWorkers == 0) {
+				config.numWorkers = 1;
+			}
+			if (config.framesInFlight == 0) {
+				config.framesInFlight = 1;
+			}
+			return config;
+		}
+
+		WorkerPool::WorkerPool(const WorkerPoolConfig& config)
+			: m_topology(CpuTopology::detect())
+			, m_workerCpus(findWorkerCpus(m_topology, config))
+			, m_reservedCpus(findReservedCpus(m_topology, config))
+			, m_config(resolveConfig(config, m_workerCpus))
+			, m_workers()
+			, m_stopping(false)
+			, m_numSubmitted(0)
+			, m_numCritical(0)
+			, m_numBackgroundJobs(0)
+			, m_numBackground(0)
+			, m_backgroundBudget(std::numeric_limits<int64_t>::max())
+			, m_numParked(0)
+			, m_pendingWakeups(0)
+			, m_frameWaiters(nullptr)
+			, m_framesBegun(0)
+			, m_graph()
+			, m_frames(new FrameContext[m_config.framesInFlight])
+			, m_nextFrame(0) {
+			for (size_t i = 0; i < m_config.framesInFlight; i++) {
+				m_frames[i].jobsRemaining.store(0, std::memory_order_relaxed);
+				m_frames[i].retiredThrough = 0;
+#ifdef FRST_TRACE_ENABLED
+				m_frames[i].beginTime = 0;
+#endif
+			}
+
+			// All workers must exist before any start, as they steal from each other.
+			m_workers.reserve(m_config.numWorkers);
+			for (size_t i = 0; i < m_config.numWorkers; i++) {
+				m_workers.emplace_back(new Worker(*this, i));
+			}
+			if (m_config.pinThreads && !m_workerCpus.empty()) {
+				placeWorkers();
+				if (!m_reservedCpus.empty()) {
+					CpuTopology::pinCurrentThread(m_reservedCpus.front().id);
+				}
+			}
+			for (auto& worker : m_workers) {
+				worker->start();
+			}
+		}
+
+		void WorkerPool::placeWorkers() {
+			// More workers than CPUs share them round robin
+			for (size_t i = 0; i < m_workers.size(); i++) {
+				m_workers[i]->m_cpu = static_cast<int64_t>(m_workerCpus[i % m_workerCpus.size()].id);
+			}
+
+			// Each worker steals from the closest workers first: the same core, then the same L3, then the same node
+			for (size_t i = 0; i < m_workers.size(); i++) {
+				const LogicalCpu& cpu = m_workerCpus[i % m_workerCpus.size()];
+				std::vector<std::pair<uint32_t, size_t>> others;
+				for (size_t j = 0; j < m_workers.size(); j++) {
+					if (j != i) {
+						others.emplace_back(CpuTopology::distance(cpu, m_workerCpus[j % m_workerCpus.size()]), j);
+					}
+				}
+				std::stable_sort(others.begin(), others.end());
+
+				Worker& worker = *m_workers[i];
+				for (size_t k = 0; k < others.size(); k++) {
+					worker.m_victims.push_back(others[k].second);
+					if (k + 1 == others.size() || others[k + 1].first != others[k].first) {
+						worker.m_victimTierEnds.push_back(worker.m_victims.size());
+					}
+				}
+			}
+		}
+
+		WorkerPool::~WorkerPool() {
+			waitForIdle();
+
+			{
+				std::lock_guard<std::mutex> lock(m_parkMutex);
+				m_stopping.store(true);
+			}
+			m_parkCondition.notify_all();
+
+			for (auto& worker : m_workers) {
+				worker->join();
+			}
+		}
+
+		void WorkerPool::addJob(Job* job) {
+			m_graph.addJob(job);
+		}
+
+		void WorkerPool::addFrameListener(FrameListener* listener) {
+			m_frameListeners.push_back(listener);
+		}
+
+		void WorkerPool::removeFrameListener(FrameListener* listener) {
+			m_frameListeners.erase(std::remove(m_frameListeners.begin(), m_frameListeners.end(), listener), m_frameListeners.end());
+		}
+
+		uint64_t WorkerPool::beginFrame() {
+			if (m_graph.isDirty()) {
+				// The trackers are about to be replaced, so nothing may still be using them.
+				waitForIdle();
+				m_graph.compile(*this, m_config.framesInFlight);
+				for (const auto& tracker : m_graph.trackers()) {
+					tracker->arm(m_nextFrame);
+				}
+				for (size_t i = 0; i < m_config.framesInFlight; i++) {
+					m_frames[i].results.reset(new ResultSlot[m_graph.numResults()]);
+					for (size_t result = 0; result < m_graph.numResults(); result++) {
+						m_frames[i].results[result].value = nullptr;
+						m_frames[i].results[result].frame = UINT64_MAX;
+					}
+				}
+			}
+
+			uint64_t frame = m_nextFrame++;
+			if (frame >= m_config.framesInFlight) {
+				// The context is shared with this frame, so it must be finished with first
+				waitForFrame(frame - m_config.framesInFlight);
+			}
+
+			if (m_config.traceFrames > 0 && frame == m_config.traceFrames) {
+				waitForFrame(frame - 1);
+				Trace::writeChromeJson(m_config.tracePath);
+			}
+
+			m_graph.updateRanks();
+
+			for (FrameListener* listener : m_frameListeners) {
+				listener->onBeginFrame(frame);
+			}
+
+			if (m_config.backgroundBudget.count() > 0) {
+				// Background work that did not fit into the last frame gets another go
+				int64_t budget = std::chrono::duration_cast<std::chrono::nanoseconds>(m_config.backgroundBudget).count();
+				m_backgroundBudget.store(budget, std::memory_order_relaxed);
+				size_t waiting = std::min(m_numBackground.load(std::memory_order_relaxed), m_workers.size());
+				for (size_t i = 0; i < waiting; i++) {
+					notifyWorker();
+				}
+			}
+
+			// Everything waiting has asked for a frame no later than this one
+			ResumeItem* waiter;
+			{
+				std::lock_guard<std::mutex> lock(m_frameWaitersMutex);
+				m_framesBegun = frame + 1;
+				waiter = std::exchange(m_frameWaiters, nullptr);
+			}
+			while (waiter) {
+				ResumeItem* next = waiter->next;
+				submit(waiter);
+				waiter = next;
+			}
+
+#ifdef FRST_TRACE_ENABLED
+			frameContext(frame).beginTime = Trace::now();
+#endif
+
+			const auto& trackers = m_graph.trackers();
+			if (trackers.empty()) {
+				retireFrame(frame);
+				return frame;
+			}
+
+			frameContext(frame).jobsRemaining.store(trackers.size(), std::memory_order_relaxed);
+			for (JobDependencyTracker* tracker : m_graph.roots()) {
+				if (tracker->resolveDependency(frame)) {
+					submitJob(tracker, frame);
+				}
+			}
+			return frame;
+		}
+
+		void WorkerPool::waitForFrame(uint64_t frame) {
+			std::unique_lock<std::mutex> lock(m_frameMutex);
+			m_frameCondition.wait(lock, [this, frame] { return isRetired(frame); });
+		}
+
+		void WorkerPool::waitForIdle() {
+			// Frames finish in order, but the book keeping for consecutive frames may race, so wait on each of them.
+			uint64_t first = m_nextFrame > m_config.framesInFlight ? m_nextFrame - m_config.framesInFlight : 0;
+			for (uint64_t frame = first; frame < m_nextFrame; frame++) {
+				waitForFrame(frame);
+			}
+		}
+
+		void WorkerPool::runFrame() {
+			waitForFrame(beginFrame());
+		}
+
+		void WorkerPool::submit(WorkItem* item, Priority priority) {
+			Worker* current = Worker::current();
+			if (priority == Priority::Background) {
+				{
+					std::lock_guard<std::mutex> lock(m_backgroundMutex);
+					m_background.push_back(item);
+					m_numBackground.fetch_add(1, std::memory_order_relaxed);
+				}
+				if (m_backgroundBudget.load(std::memory_order_relaxed) <= 0) {
+					// Nobody may run it before the next frame anyway
+					return;
+				}
+			} else if (current && &current->pool() == this) {
+				current->push(item, priority);
+			} else {
+				std::lock_guard<std::mutex> lock(m_submittedMutex);
+				if (priority == Priority::Critical) {
+					m_submitted.push_front(item);
+				} else {
+					m_submitted.push_back(item);
+				}
+				m_numSubmitted.fetch_add(1, std::memory_order_relaxed);
+			}
+			notifyWorker();
+		}
+
+		void WorkerPool::submitJob(JobDependencyTracker* tracker, uint64_t frame) {
+			if (tracker->priority() != Priority::Background) {
+				submit(tracker->workItem(frame), tracker->priority());
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_backgroundMutex);
+				m_backgroundJobs.push_back(tracker->workItem(frame));
+				m_numBackgroundJobs.fetch_add(1, std::memory_order_relaxed);
+			}
+			notifyWorker();
+		}
+
+		void WorkerPool::waitExternally(const std::atomic<bool>& done) {
+			std::unique_lock<std::mutex> lock(m_externalMutex);
+			m_externalCondition.wait(lock, [&done] { return done.load(std::memory_order_acquire); });
+		}
+
+		void WorkerPool::notifyExternalWaiters() {
+			{
+				// Taking the lock means a waiter is either before its check of done, or already waiting
+				std::lock_guard<std::mutex> lock(m_externalMutex);
+			}
+			m_externalCondition.notify_all();
+		}
+
+		bool WorkerPool::resumeAtFrame(ResumeItem* item, uint64_t frame) {
+			std::lock_guard<std::mutex> lock(m_frameWaitersMutex);
+			if (frame < m_framesBegun) {
+				return false;
+			}
+			item->next = m_frameWaiters;
+			m_frameWaiters = item;
+			return true;
+		}
+
+		uint64_t WorkerPool::nextFrame() {
+			std::lock_guard<std::mutex> lock(m_frameWaitersMutex);
+			return m_framesBegun;
+		}
+
+		void WorkerPool::finishJob(uint64_t frame) {
+			if (frameContext(frame).jobsRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				retireFrame(frame);
+			}
+		}
+
+		void WorkerPool::retireFrame(uint64_t frame) {
+#ifdef FRST_TRACE_ENABLED
+			Trace::record(TraceEvent{ "Frame", TraceEvent::Kind::Frame, frameContext(frame).beginTime, Trace::now(), frame, 0, 0,
+				static_cast<uint32_t>(frame % m_config.framesInFlight) });
+#endif
+
+			// Every job of the frame has finished, so nothing can be holding onto its results anymore.
+			// Inline results are trivially destructible and are simply overwritten by the next use of the slots.
+			for (auto& worker : m_workers) {
+				worker->frameArena(frame).reset();
+			}
+
+			// Jobs with a cross frame hazard in the next frame were waiting on this
+			for (JobDependencyTracker* tracker : m_graph.hazards()) {
+				if (tracker->resolveDependency(frame + 1)) {
+					submitJob(tracker, frame + 1);
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_frameMutex);
+				frameContext(frame).retiredThrough = frame + 1;
+			}
+			m_frameCondition.notify_all();
+		}
+
+		bool WorkerPool::isRetired(uint64_t frame) {
+			return frameContext(frame).retiredThrough > frame;
+		}
+
+		WorkItem* WorkerPool::takeSubmitted() {
+			if (m_numSubmitted.load(std::memory_order_relaxed) == 0) {
+				return nullptr;
+			}
+
+			std::lock_guard<std::mutex> lock(m_submittedMutex);
+			if (m_submitted.empty()) {
+				return nullptr;
+			}
+			WorkItem* item = m_submitted.front();
+			m_submitted.pop_front();
+			m_numSubmitted.fetch_sub(1, std::memory_order_relaxed);
+			return item;
+		}
+
+		bool WorkerPool::runBackground(Worker& worker) {
+			if (!hasBackgroundWork()) {
+				return false;
+			}
+
+			WorkItem* item = nullptr;
+			bool budgeted = false;
+			{
+				std::lock_guard<std::mutex> lock(m_backgroundMutex);
+				if (!m_backgroundJobs.empty()) {
+					item = m_backgroundJobs.front();
+					m_backgroundJobs.pop_front();
+					m_numBackgroundJobs.fetch_sub(1, std::memory_order_relaxed);
+				} else if (!m_background.empty() && m_backgroundBudget.load(std::memory_order_relaxed) > 0) {
+					item = m_background.front();
+					m_background.pop_front();
+					m_numBackground.fetch_sub(1, std::memory_order_relaxed);
+					budgeted = true;
+				}
+			}
+			if (!item) {
+				return false;
+			}
+
+			if (!budgeted || m_config.backgroundBudget.count() == 0) {
+				item->execute(item, worker);
+				return true;
+			}
+
+			// Items are never interrupted, so the last one of a frame may overrun the budget by its own length
+			auto start = std::chrono::steady_clock::now();
+			item->execute(item, worker);
+			int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			m_backgroundBudget.fetch_sub(elapsed, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool WorkerPool::hasBackgroundWork() const {
+			if (m_numBackgroundJobs.load(std::memory_order_relaxed) > 0) {
+				return true;
+			}
+			return m_numBackground.load(std::memory_order_relaxed) > 0 && m_backgroundBudget.load(std::memory_order_relaxed) > 0;
+		}
+
+		bool WorkerPool::hasQueuedWork() const {
+			if (m_numSubmitted.load(std::memory_order_relaxed) > 0 || m_numCritical.load(std::memory_order_relaxed) > 0) {
+				return true;
+			}
+			if (hasBackgroundWork()) {
+				return true;
+			}
+			for (const auto& worker : m_workers) {
+				if (worker->hasQueuedWork()) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void WorkerPool::park() {
+			std::unique_lock<std::mutex> lock(m_parkMutex);
+
+			// Announce that we are about to sleep before the final check for work.
+			// Paired with the fence in notifyWorker() so that either we see the new work,
+			// or the submitter sees us and hands out a wakeup.
+			m_numParked.fetch_add(1, std::memory_order_seq_cst);
+			if (hasQueuedWork() || isStopping()) {
+				m_numParked.fetch_sub(1, std::memory_order_relaxed);
+				return;
+			}
+
+			m_parkCondition.wait(lock, [this] { return m_pendingWakeups > 0 || isStopping(); });
+			if (m_pendingWakeups > 0) {
+				m_pendingWakeups--;
+			}
+			m_numParked.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void WorkerPool::notifyWorker() {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_numParked.load(std::memory_order_relaxed) == 0) {
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_parkMutex);
+				if (m_pendingWakeups >= m_numParked.load(std::memory_order_relaxed)) {
+					return;
+				}
+				m_pendingWakeups++;
+			}
+			m_parkCondition.notify_one();
+		}
+	}
+}